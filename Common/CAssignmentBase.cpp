@@ -0,0 +1,687 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CAssignmentBase.h"
+#include "IMultiDeviceComputeTask.h"
+#include "IOverlappedComputeTask.h"
+#include "IAsyncBuildComputeTask.h"
+#include "IBatchComputeTask.h"
+
+#include "CLUtil.h"
+#include "CTimer.h"
+#include "CFileUtil.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+#if defined (__APPLE__) || defined(MACOSX)
+   #define GL_SHARING_EXTENSION "cl_APPLE_gl_sharing"
+#else
+   #define GL_SHARING_EXTENSION "cl_khr_gl_sharing"
+#endif
+
+// required for OpenGL interop
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#ifdef linux
+    #if defined (__APPLE__) || defined(MACOSX)
+        #include <OpenGL/OpenGL.h>
+    #else
+        #include <GL/glx.h>
+    #endif
+#endif
+
+// Environment variable overriding the automatic device selection (the command line option takes precedence)
+#define DEVICE_OVERRIDE_ENV_VAR "GPU_COMPUTING_DEVICE"
+// Environment variable enabling the multi-device mode, like the --multi-device option
+#define MULTI_DEVICE_ENV_VAR "GPU_COMPUTING_MULTI_DEVICE"
+// Environment variable with the directory of edited kernel sources, like the --kernel-dir option
+#define KERNEL_DIR_ENV_VAR "GPU_COMPUTING_KERNEL_DIR"
+
+///////////////////////////////////////////////////////////////////////////////
+// CAssignmentBase
+
+CAssignmentBase::CAssignmentBase()
+	: m_CLPlatform(nullptr), m_CLDevice(nullptr)
+{
+}
+
+CAssignmentBase::~CAssignmentBase()
+{
+	ReleaseCLContext();
+}
+
+bool CAssignmentBase::EnterMainLoop(int argc, char** argv)
+{
+	const char* programName = argc > 0 ? argv[0] : "Assignment";
+	if(!m_Options.Parse(argc, argv))
+	{
+		CBenchmarkOptions::PrintUsage(programName, cerr);
+		return false;
+	}
+	if(m_Options.IsHelpRequested())
+	{
+		CBenchmarkOptions::PrintUsage(programName, cout);
+		return true;
+	}
+
+	// --device <platform:device | index | name substring> overrides the automatic device selection
+	m_DeviceOverride = m_Options.GetDeviceOverride();
+	// --multi-device splits the tasks which support it over all devices of the platform
+	m_MultiDevice = m_Options.IsMultiDevice();
+	if(getenv(MULTI_DEVICE_ENV_VAR) != NULL && string(getenv(MULTI_DEVICE_ENV_VAR)) != "0")
+		m_MultiDevice = true;
+
+	// --kernel-dir <dir> loads edited kernels without rebuilding, otherwise the embedded sources are used
+	string kernelDir = m_Options.GetKernelDir();
+	if(kernelDir.empty() && getenv(KERNEL_DIR_ENV_VAR) != NULL)
+		kernelDir = getenv(KERNEL_DIR_ENV_VAR);
+	CLUtil::SetProgramSourceDir(kernelDir);
+
+	if(!InitCLContext())
+		return false;
+
+	m_QueuedRuns.clear();
+	m_PendingSection.clear();
+	m_BenchmarkRuns.clear();
+	m_Report.Clear();
+	m_Trace.Clear();
+	bool success = DoCompute();
+
+	if(!m_BenchmarkRuns.empty())
+		PrintBenchmarkSummary(cout);
+
+	if(!m_Options.GetReportFile().empty())
+		success &= m_Report.Save(m_Options.GetReportFile());
+
+	// a regression or a result without counterpart in the baseline fails the run, so scripts can check the exit code
+	if(!m_Options.GetBaselineFile().empty())
+	{
+		CBenchmarkReport baseline;
+		success &= baseline.Load(m_Options.GetBaselineFile()) && m_Report.Compare(baseline, m_Options.GetThreshold(), cout);
+	}
+
+	if(!m_Options.GetTraceFile().empty())
+		success &= m_Trace.Save(m_Options.GetTraceFile());
+
+	ReleaseCLContext();
+
+	return success;
+}
+
+#define PRINT_INFO(title, buffer, bufferSize, maxBufferSize, expr) { expr; buffer[bufferSize] = '\0'; std::cout << title << ": " << buffer << std::endl; }
+
+namespace
+{
+	//! Properties of a device which are relevant for the selection
+	struct SDeviceCandidate
+	{
+		cl_platform_id	Platform;
+		cl_device_id	Device;
+		cl_uint			PlatformIndex;
+		cl_uint			DeviceIndex;
+		std::string		Name;
+		std::string		PlatformName;
+		cl_device_type	Type;
+		cl_uint			ComputeUnits;
+		cl_uint			ClockMHz;
+		cl_ulong		GlobalMemorySize;
+		bool			UnifiedMemory;
+		bool			Available;
+	};
+
+	std::string GetInfoString(cl_platform_id Platform, cl_device_id Device, cl_uint Param)
+	{
+		char buffer[1024] = "";
+		if (Device != NULL)
+			clGetDeviceInfo(Device, Param, sizeof(buffer) - 1, buffer, NULL);
+		else
+			clGetPlatformInfo(Platform, Param, sizeof(buffer) - 1, buffer, NULL);
+		return buffer;
+	}
+
+	SDeviceCandidate QueryDeviceCandidate(cl_platform_id Platform, cl_uint PlatformIndex, cl_device_id Device, cl_uint DeviceIndex)
+	{
+		SDeviceCandidate c;
+		c.Platform = Platform;
+		c.Device = Device;
+		c.PlatformIndex = PlatformIndex;
+		c.DeviceIndex = DeviceIndex;
+		c.Name = GetInfoString(NULL, Device, CL_DEVICE_NAME);
+		c.PlatformName = GetInfoString(Platform, NULL, CL_PLATFORM_NAME);
+
+		cl_bool unified = CL_FALSE, available = CL_FALSE, compilerAvailable = CL_FALSE;
+		c.Type = CL_DEVICE_TYPE_DEFAULT;
+		c.ComputeUnits = c.ClockMHz = 0;
+		c.GlobalMemorySize = 0;
+		clGetDeviceInfo(Device, CL_DEVICE_TYPE, sizeof(cl_device_type), &c.Type, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &c.ComputeUnits, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(cl_uint), &c.ClockMHz, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &c.GlobalMemorySize, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unified, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_AVAILABLE, sizeof(cl_bool), &available, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_COMPILER_AVAILABLE, sizeof(cl_bool), &compilerAvailable, NULL);
+		c.UnifiedMemory = unified == CL_TRUE;
+		// we build all programs from source, so a device without a compiler is of no use
+		c.Available = available == CL_TRUE && compilerAvailable == CL_TRUE;
+		return c;
+	}
+
+	const char* DeviceTypeName(cl_device_type Type)
+	{
+		if (Type & CL_DEVICE_TYPE_GPU) return "GPU";
+		if (Type & CL_DEVICE_TYPE_ACCELERATOR) return "accelerator";
+		if (Type & CL_DEVICE_TYPE_CPU) return "CPU";
+		return "other";
+	}
+
+	//! GPUs first, then accelerators, CPU devices are the fallback
+	int DeviceTypeRank(cl_device_type Type)
+	{
+		if (Type & CL_DEVICE_TYPE_GPU) return 3;
+		if (Type & CL_DEVICE_TYPE_ACCELERATOR) return 2;
+		if (Type & CL_DEVICE_TYPE_CPU) return 1;
+		return 0;
+	}
+
+	//! Compares the device type, dedicated memory, compute throughput and memory size, in this order
+	bool IsBetterDevice(const SDeviceCandidate& A, const SDeviceCandidate& B)
+	{
+		if (DeviceTypeRank(A.Type) != DeviceTypeRank(B.Type))
+			return DeviceTypeRank(A.Type) > DeviceTypeRank(B.Type);
+		// a discrete device usually has much more memory bandwidth than an integrated one
+		if (A.UnifiedMemory != B.UnifiedMemory)
+			return !A.UnifiedMemory;
+		cl_ulong throughputA = cl_ulong(A.ComputeUnits) * A.ClockMHz;
+		cl_ulong throughputB = cl_ulong(B.ComputeUnits) * B.ClockMHz;
+		if (throughputA != throughputB)
+			return throughputA > throughputB;
+		return A.GlobalMemorySize > B.GlobalMemorySize;
+	}
+
+	std::string ToLower(std::string Text)
+	{
+		for (size_t i = 0; i < Text.size(); i++)
+			Text[i] = char(tolower((unsigned char)Text[i]));
+		return Text;
+	}
+
+	bool ParseIndex(const std::string& Text, cl_uint& Index)
+	{
+		if (Text.empty() || Text.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+		Index = cl_uint(atoi(Text.c_str()));
+		return true;
+	}
+
+	//! Finds the device selected by Override, returns -1 if there is none
+	/*!
+		Accepted forms:
+			"P:D"		device D of platform P
+			"N"			the N-th device over all platforms, in the printed order
+			"gpu", "cpu", "accelerator"	the best device of this type
+			otherwise	the best device whose device or platform name contains Override (case insensitive)
+	*/
+	int MatchDeviceOverride(const std::vector<SDeviceCandidate>& Candidates, const std::string& Override)
+	{
+		cl_uint platformIndex, deviceIndex;
+		size_t colon = Override.find(':');
+		if (colon != std::string::npos && ParseIndex(Override.substr(0, colon), platformIndex) && ParseIndex(Override.substr(colon + 1), deviceIndex))
+		{
+			for (size_t i = 0; i < Candidates.size(); i++)
+			{
+				if (Candidates[i].PlatformIndex == platformIndex && Candidates[i].DeviceIndex == deviceIndex)
+					return Candidates[i].Available ? int(i) : -1;
+			}
+			return -1;
+		}
+		if (ParseIndex(Override, deviceIndex))
+			return deviceIndex < Candidates.size() && Candidates[deviceIndex].Available ? int(deviceIndex) : -1;
+
+		std::string pattern = ToLower(Override);
+		int best = -1;
+		for (size_t i = 0; i < Candidates.size(); i++)
+		{
+			const SDeviceCandidate& c = Candidates[i];
+			bool match;
+			if (pattern == "gpu" || pattern == "cpu" || pattern == "accelerator")
+				match = ToLower(DeviceTypeName(c.Type)) == pattern;
+			else
+				match = ToLower(c.Name).find(pattern) != std::string::npos || ToLower(c.PlatformName).find(pattern) != std::string::npos;
+
+			if (match && c.Available && (best < 0 || IsBetterDevice(c, Candidates[best])))
+				best = int(i);
+		}
+		return best;
+	}
+}
+
+bool CAssignmentBase::InitCLContext()
+{
+	//////////////////////////////////////////////////////
+	//(Sect 4.3)
+
+	// 1. get all platform IDs
+
+	std::vector<cl_platform_id> platformIds;
+	const cl_uint c_MaxPlatforms = 16;
+	platformIds.resize(c_MaxPlatforms);
+	
+	cl_uint countPlatforms;
+	V_RETURN_FALSE_CL(clGetPlatformIDs(c_MaxPlatforms, &platformIds[0], &countPlatforms), "Failed to get CL platform ID");
+	platformIds.resize(countPlatforms);
+
+	// 2. enumerate the devices of all types on all platforms
+	std::vector<SDeviceCandidate> candidates;
+	for (cl_uint p = 0; p < countPlatforms; p++)
+	{
+		cl_uint countDevices = 0;
+		cl_int res = clGetDeviceIDs(platformIds[p], CL_DEVICE_TYPE_ALL, 0, NULL, &countDevices);
+		if (res != CL_SUCCESS || countDevices == 0) // Some poor implementations don't set the count to zero and return CL_DEVICE_NOT_FOUND.
+		{
+			std::string platformName = GetInfoString(platformIds[p], NULL, CL_PLATFORM_NAME);
+			if (res == CL_SUCCESS || res == CL_DEVICE_NOT_FOUND)
+				printf("[WARNING]: Platform %u (%s) has no OpenCL devices.\n", p, platformName.c_str());
+			else
+				printf("[WARNING]: clGetDeviceIDs() failed. Error type: %s, Platform name: %s!\n",
+					CLUtil::GetCLErrorString(res), platformName.c_str());
+			continue;
+		}
+
+		std::vector<cl_device_id> deviceIds(countDevices);
+		V_RETURN_FALSE_CL(clGetDeviceIDs(platformIds[p], CL_DEVICE_TYPE_ALL, countDevices, &deviceIds[0], NULL), "Failed to get CL device IDs");
+
+		for (cl_uint d = 0; d < countDevices; d++)
+			candidates.push_back(QueryDeviceCandidate(platformIds[p], p, deviceIds[d], d));
+	}
+
+	if (candidates.empty())
+	{
+		std::cout << "No device with OpenCL support was found.";
+		return false;
+	}
+
+	// 3. pick a device: the explicit override if given, the best scored device otherwise
+	std::string deviceOverride = m_DeviceOverride;
+	if (deviceOverride.empty() && getenv(DEVICE_OVERRIDE_ENV_VAR) != NULL)
+		deviceOverride = getenv(DEVICE_OVERRIDE_ENV_VAR);
+
+	// the first column is the index for --device N, the second one platform:device
+	std::cout << "OpenCL devices:" << std::endl << std::endl;
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		const SDeviceCandidate& c = candidates[i];
+		std::cout << "  " << i << " [" << c.PlatformIndex << ":" << c.DeviceIndex << "] " << c.Name << " (" << c.PlatformName << "), "
+			<< DeviceTypeName(c.Type) << ", " << c.ComputeUnits << " CUs @ " << c.ClockMHz << " MHz, "
+			<< (c.GlobalMemorySize >> 20) << " MB" << (c.UnifiedMemory ? " unified" : "")
+			<< (c.Available ? "" : ", not available") << std::endl;
+	}
+	std::cout << std::endl;
+
+	int selected = -1;
+	if (!deviceOverride.empty())
+	{
+		selected = MatchDeviceOverride(candidates, deviceOverride);
+		if (selected < 0)
+		{
+			std::cerr << "Error: no available OpenCL device matches '" << deviceOverride
+				<< "' (use an index or platform:device from the list above, a device type or a part of a name)." << std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		// candidates are in enumeration order and only a strictly better device replaces
+		// the current choice, so the selection is deterministic
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			if (candidates[i].Available && (selected < 0 || IsBetterDevice(candidates[i], candidates[selected])))
+				selected = int(i);
+		}
+		if (selected < 0)
+		{
+			std::cout << "None of the OpenCL devices is available.";
+			return false;
+		}
+	}
+
+	m_CLDevice = candidates[selected].Device;
+	m_CLPlatform = candidates[selected].Platform;
+
+	// the selected device comes first, a context can only contain devices of a single platform
+	m_CLDevices.assign(1, m_CLDevice);
+	if (m_MultiDevice)
+	{
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			if (int(i) != selected && candidates[i].Available && candidates[i].Platform == m_CLPlatform)
+				m_CLDevices.push_back(candidates[i].Device);
+		}
+		std::cout << "Multi-device mode: using " << m_CLDevices.size() << " device(s) of the selected platform." << std::endl << std::endl;
+	}
+
+	// Printing platform and device data.
+	const int maxBufferSize = 1024;
+	char buffer[maxBufferSize];
+	size_t bufferSize;
+	std::cout << "OpenCL platform:" << std::endl << std::endl;
+	PRINT_INFO("Name", buffer, bufferSize, maxBufferSize, clGetPlatformInfo(m_CLPlatform, CL_PLATFORM_NAME, maxBufferSize, (void*)buffer, &bufferSize));
+	PRINT_INFO("Vendor", buffer, bufferSize, maxBufferSize, clGetPlatformInfo(m_CLPlatform, CL_PLATFORM_VENDOR, maxBufferSize, (void*)buffer, &bufferSize));
+	PRINT_INFO("Version", buffer, bufferSize, maxBufferSize, clGetPlatformInfo(m_CLPlatform, CL_PLATFORM_VERSION, maxBufferSize, (void*)buffer, &bufferSize));
+	PRINT_INFO("Profile", buffer, bufferSize, maxBufferSize, clGetPlatformInfo(m_CLPlatform, CL_PLATFORM_PROFILE, maxBufferSize, (void*)buffer, &bufferSize));
+	std::cout << std::endl << "Device:" << std::endl << std::endl;
+	PRINT_INFO("Name", buffer, bufferSize, maxBufferSize, clGetDeviceInfo(m_CLDevice, CL_DEVICE_NAME, maxBufferSize, (void*)buffer, &bufferSize));
+	PRINT_INFO("Vendor", buffer, bufferSize, maxBufferSize, clGetDeviceInfo(m_CLDevice, CL_DEVICE_VENDOR, maxBufferSize, (void*)buffer, &bufferSize));
+	PRINT_INFO("Driver version", buffer, bufferSize, maxBufferSize, clGetDeviceInfo(m_CLDevice, CL_DRIVER_VERSION, maxBufferSize, (void*)buffer, &bufferSize));
+	cl_ulong localMemorySize;
+	clGetDeviceInfo(m_CLDevice, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMemorySize, &bufferSize);
+	std::cout << "Local memory size: " << localMemorySize << " Byte" << std::endl;
+	std::cout << std::endl << "******************************" << std::endl << std::endl;
+
+        
+	cl_int clError;
+
+	m_CLContext.Reset(clCreateContext(NULL, cl_uint(m_CLDevices.size()), &m_CLDevices[0], NULL, NULL, &clError));
+		
+	V_RETURN_FALSE_CL(clError, "Failed to create OpenCL context.");
+
+	// Finally, create a command queue. All the asynchronous commands to the device will be issued
+	// from the CPU into this queue. This way the host program can continue the execution until some results
+	// from that device are needed.
+	// Profiling lets CLUtil::ProfileKernel() time every run on the device via its event.
+
+	m_CLCommandQueue.Reset(clCreateCommandQueue(m_CLContext, m_CLDevice, CL_QUEUE_PROFILING_ENABLE, &clError));
+	V_RETURN_FALSE_CL(clError, "Failed to create the command queue in the context");
+	m_CLCommandQueues.assign(1, m_CLCommandQueue);
+
+	// Transfers issued to a separate queue can run while the kernels of the first one execute
+	// (if the device has a copy engine). Two in-order queues keep the ordering within the
+	// transfers and within the kernels, only the dependencies between them need events.
+	m_CLTransferQueue.Reset(clCreateCommandQueue(m_CLContext, m_CLDevice, CL_QUEUE_PROFILING_ENABLE, &clError));
+	V_RETURN_FALSE_CL(clError, "Failed to create the transfer queue in the context");
+
+	// tasks allocate their device buffers through CBufferPool::AcquireBuffer() from now on
+	CBufferPool::SetActive(&m_BufferPool);
+
+	// and record their timings with CBenchmarkReport::Record()
+	m_Report.SetDevice(candidates[selected].Name);
+	CBenchmarkReport::SetActive(&m_Report);
+
+	// the timeline is only recorded on request, the trace scopes are no-ops otherwise
+	if (!m_Options.GetTraceFile().empty())
+		CTraceRecorder::SetActive(&m_Trace);
+
+	// one more queue for each additional device
+	for (size_t i = 1; i < m_CLDevices.size(); i++)
+	{
+		CLCommandQueue queue(clCreateCommandQueue(m_CLContext, m_CLDevices[i], CL_QUEUE_PROFILING_ENABLE, &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create the command queue of an additional device");
+		m_CLCommandQueues.push_back(queue);
+		m_CLAdditionalQueues.push_back(std::move(queue));
+	}
+
+	return true;
+}
+
+void CAssignmentBase::ReleaseCLContext()
+{
+	if (CBufferPool::GetActive() == &m_BufferPool)
+	{
+		if (m_BufferPool.GetNumAcquisitions() > 0)
+			m_BufferPool.PrintStatistics(std::cout);
+		CBufferPool::SetActive(nullptr);
+	}
+	m_BufferPool.Clear();
+
+	if (CBenchmarkReport::GetActive() == &m_Report)
+		CBenchmarkReport::SetActive(nullptr);
+
+	// the device events refer to the queues released below
+	if (CTraceRecorder::GetActive() == &m_Trace)
+	{
+		m_Trace.Flush();
+		CTraceRecorder::SetActive(nullptr);
+	}
+
+	CLUtil::ReleaseProgramCache();
+
+	m_CLCommandQueues.clear();
+	m_CLAdditionalQueues.clear();
+	m_CLDevices.clear();
+
+	m_CLTransferQueue.Reset();
+	m_CLCommandQueue.Reset();
+	m_CLContext.Reset();
+}
+
+bool CAssignmentBase::RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3])
+{
+	if(m_CLContext == nullptr)
+	{
+		std::cerr<<"Error: RunComputeTask() cannot execute because the OpenCL context has not been created first."<<endl;
+	}
+	
+	bool initialized;
+	{
+		CTraceScope scope("InitResources", "task");
+		initialized = Task.InitResources(m_CLDevice, m_CLContext);
+	}
+	if(!initialized)
+	{
+		std::cerr << "Error during resource allocation. Aborting execution." <<endl;
+		Task.ReleaseResources();
+		return false;
+	}
+
+	// in the multi-device mode the task is split over all devices, if it supports this
+	IMultiDeviceComputeTask* pMultiDeviceTask = nullptr;
+	if (m_CLDevices.size() > 1)
+		pMultiDeviceTask = dynamic_cast<IMultiDeviceComputeTask*>(&Task);
+	if (pMultiDeviceTask != nullptr)
+	{
+		CTraceScope scope("InitMultiDeviceResources", "task");
+		initialized = pMultiDeviceTask->InitMultiDeviceResources(m_CLContext, m_CLDevices);
+	}
+	if (!initialized)
+	{
+		std::cerr << "Error during multi-device resource allocation. Aborting execution." <<endl;
+		Task.ReleaseResources();
+		return false;
+	}
+
+	// Compute the golden result.
+	cout << "Computing CPU reference result...";
+	{
+		CTraceScope scope("ComputeCPU", "task");
+		Task.ComputeCPU();
+	}
+	cout << "DONE" << endl;
+
+	// Running the same task on the GPU.
+	cout << "Computing GPU result...";
+
+	// Runing the kernel N times. This make the measurement of the execution time more accurate.
+	IOverlappedComputeTask* pOverlappedTask = dynamic_cast<IOverlappedComputeTask*>(&Task);
+	{
+		CTraceScope scope("ComputeGPU", "task");
+		if (pMultiDeviceTask != nullptr)
+			pMultiDeviceTask->ComputeGPUMultiDevice(m_CLContext, m_CLCommandQueues, LocalWorkSize);
+		else if (pOverlappedTask != nullptr)
+			pOverlappedTask->ComputeGPUOverlapped(m_CLContext, m_CLCommandQueue, m_CLTransferQueue, LocalWorkSize);
+		else
+			Task.ComputeGPU(m_CLContext, m_CLCommandQueue, LocalWorkSize);
+	}
+	cout << "DONE" << endl;
+
+	// Validating results.
+	{
+		CTraceScope scope("ValidateResults", "task");
+		m_LastTaskValid = Task.ValidateResults();
+	}
+	if (m_LastTaskValid)
+	{
+		cout << "GOLD TEST PASSED!" << endl;
+	}
+	else
+	{
+		cout << "INVALID RESULTS!" << endl;
+	}
+	
+	// Cleaning up.
+	{
+		CTraceScope scope("ReleaseResources", "task");
+		Task.ReleaseResources();
+	}
+
+	// the timestamps of the device commands are available now, and their events are released
+	if (CTraceRecorder::GetActive() != nullptr)
+		CTraceRecorder::GetActive()->Flush();
+
+	return true;
+}
+
+void CAssignmentBase::AddBenchmark(const std::string& TaskName, const SBenchmarkConfig& Defaults, const TaskFactory& CreateTask)
+{
+	if (!m_Options.IsTaskSelected(TaskName))
+		return;
+
+	std::vector<SBenchmarkConfig> configs = m_Options.GetConfigs(Defaults);
+	for (size_t i = 0; i < configs.size(); i++)
+	{
+		SQueuedRun queued;
+		queued.Section = m_PendingSection;
+		m_PendingSection.clear();
+
+		SBenchmarkRun& run = queued.Run;
+		run.Task = TaskName;
+		run.Config = configs[i];
+		run.Executed = false;
+		run.Valid = false;
+		run.Milliseconds = 0.0;
+
+		// the programs compile in the background while the remaining runs are queued
+		queued.Task = CreateTask(configs[i]);
+		IAsyncBuildComputeTask* pAsyncBuildTask = dynamic_cast<IAsyncBuildComputeTask*>(queued.Task.get());
+		if (pAsyncBuildTask != nullptr)
+			pAsyncBuildTask->StartProgramBuilds(m_CLDevice, m_CLContext);
+
+		m_QueuedRuns.push_back(std::move(queued));
+	}
+}
+
+void CAssignmentBase::AddBenchmarkSection(const std::string& Title)
+{
+	m_PendingSection = Title;
+}
+
+bool CAssignmentBase::RunBenchmarks()
+{
+	{
+		CTraceScope scope("WaitForProgramBuilds", "build");
+		CLUtil::WaitForProgramBuilds();
+	}
+
+	bool success = true;
+	for (size_t i = 0; i < m_QueuedRuns.size(); i++)
+	{
+		SQueuedRun& queued = m_QueuedRuns[i];
+		SBenchmarkRun& run = queued.Run;
+		const SBenchmarkConfig& config = run.Config;
+		const std::string& TaskName = run.Task;
+
+		if (!queued.Section.empty())
+			cout << "########################################" << endl << queued.Section << endl << endl;
+
+		cout << "[" << TaskName << "]";
+		if (config.Size[0] != 0)
+			cout << " size " << config.Size[0] << "x" << config.Size[1] << "x" << config.Size[2] << ",";
+		if (config.LocalWorkSize[0] != 0)
+			cout << " local size " << config.LocalWorkSize[0] << "x" << config.LocalWorkSize[1] << "x" << config.LocalWorkSize[2] << ",";
+		cout << " " << config.Iterations << " iterations";
+		if (!config.Input.empty())
+			cout << ", input " << config.Input;
+		cout << endl << endl;
+
+		m_Report.BeginRun(TaskName, config);
+
+		CTraceScope scope(TaskName.c_str(), "benchmark");
+		CTimer timer;
+		timer.Start();
+		// a directory as input runs the task over all its images, if it supports this
+		IBatchComputeTask* pBatchTask = dynamic_cast<IBatchComputeTask*>(queued.Task.get());
+		if (pBatchTask != nullptr && CFileUtil::IsDirectory(config.Input))
+		{
+			bool valid = false;
+			run.Executed = pBatchTask->ComputeBatch(m_CLDevice, m_CLContext, m_CLCommandQueue, config.Input, run.Config.LocalWorkSize, valid);
+			run.Valid = run.Executed && valid;
+		}
+		else if (queued.Task)
+		{
+			m_LastTaskValid = false;
+			run.Executed = RunComputeTask(*queued.Task, run.Config.LocalWorkSize);
+			run.Valid = run.Executed && m_LastTaskValid;
+		}
+		else
+			std::cerr << "Error: " << TaskName << " does not support this configuration." << endl;
+		timer.Stop();
+		run.Milliseconds = timer.GetElapsedMilliseconds();
+
+		// the task is not needed any more, only its results
+		queued.Task.reset();
+		m_Report.EndRun(run.Valid);
+
+		// a wrong result fails the run like an error, so scripts can check the exit code
+		success &= run.Valid;
+		m_BenchmarkRuns.push_back(run);
+		cout << endl;
+	}
+	m_QueuedRuns.clear();
+	return success;
+}
+
+void CAssignmentBase::PrintBenchmarkSummary(std::ostream& Out) const
+{
+	bool csv = m_Options.GetOutputFormat() == CBenchmarkOptions::FORMAT_CSV;
+	if (csv)
+		Out << "task,size_x,size_y,size_z,local_x,local_y,local_z,iterations,input,status,wall_ms" << endl;
+	else
+		Out << "########################################" << endl << "Benchmark summary:" << endl << endl;
+
+	for (size_t i = 0; i < m_BenchmarkRuns.size(); i++)
+	{
+		const SBenchmarkRun& run = m_BenchmarkRuns[i];
+		const SBenchmarkConfig& c = run.Config;
+		const char* status = !run.Executed ? "failed" : run.Valid ? "passed" : "invalid";
+		if (csv)
+		{
+			Out << run.Task << "," << c.Size[0] << "," << c.Size[1] << "," << c.Size[2] << ","
+				<< c.LocalWorkSize[0] << "," << c.LocalWorkSize[1] << "," << c.LocalWorkSize[2] << ","
+				<< c.Iterations << "," << c.Input << "," << status << "," << run.Milliseconds << endl;
+		}
+		else
+		{
+			Out << "  " << run.Task;
+			if (c.Size[0] != 0)
+				Out << " size " << c.Size[0] << "x" << c.Size[1] << "x" << c.Size[2];
+			if (c.LocalWorkSize[0] != 0)
+				Out << " local " << c.LocalWorkSize[0] << "x" << c.LocalWorkSize[1] << "x" << c.LocalWorkSize[2];
+			if (!c.Input.empty())
+				Out << " " << c.Input;
+			Out << ": " << status << " (" << run.Milliseconds << " ms)" << endl;
+		}
+	}
+	if (!csv)
+		Out << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
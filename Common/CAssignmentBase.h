@@ -0,0 +1,163 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CASSIGNMENT_BASE_H
+#define _CASSIGNMENT_BASE_H
+
+#include "IComputeTask.h"
+#include "CBufferPool.h"
+#include "CLHandles.h"
+#include "CBenchmarkOptions.h"
+#include "CBenchmarkReport.h"
+#include "CTraceRecorder.h"
+
+#include "CommonDefs.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <ostream>
+
+//! Base class for all assignments
+/*! 
+	Inherit a new class for each specific assignment.
+	This class is abstract.
+
+	Usage of class: from your main CPP you typically call
+	EnterMainLoop(). This returns when the assignment is finished.
+
+	Internally the assignment class should initialize the context,
+	run one or more compute tasks and then release the context.
+
+	The command line is parsed into m_Options (see CBenchmarkOptions), DoCompute()
+	normally queues its tasks with AddBenchmark() so they can be selected and
+	reconfigured from the command line, and executes them with RunBenchmarks().
+*/
+class CAssignmentBase
+{
+public:
+	CAssignmentBase();
+
+	virtual ~CAssignmentBase();
+
+	//! Main loop. You only need to overload this if you do some rendering in your assignment.
+	virtual bool EnterMainLoop(int argc, char** argv);
+
+	//! You need to overload this to define a specific behavior for your assignments
+	virtual bool DoCompute() = 0;
+
+protected:	
+	//! Creates the context and the command queue on the selected device
+	/*!
+		All devices of all platforms are considered. Unless an override is given
+		(command line option --device or the environment variable GPU_COMPUTING_DEVICE),
+		a GPU is preferred over an accelerator and a CPU device, a discrete device over an
+		integrated one, then the one with more compute units x clock and more memory.
+	*/
+	virtual bool InitCLContext();
+
+	virtual void ReleaseCLContext();
+
+	virtual bool RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]);
+
+	//! Creates the task of one benchmark run, returns nullptr if the configuration is not supported
+	typedef std::function<std::unique_ptr<IComputeTask>(const SBenchmarkConfig&)> TaskFactory;
+
+	//! Queues a run of a task for each configuration selected on the command line
+	/*!
+		Options which were not given are taken from Defaults. Nothing is done if the
+		task was not selected with --task.
+
+		The tasks are created right away, so the programs of all tasks implementing
+		IAsyncBuildComputeTask compile concurrently while DoCompute() queues the others.
+	*/
+	void AddBenchmark(const std::string& TaskName, const SBenchmarkConfig& Defaults, const TaskFactory& CreateTask);
+
+	//! Queues a heading, which is printed before the runs added after it
+	void AddBenchmarkSection(const std::string& Title);
+
+	//! Executes the queued runs in order, returns false if one of them could not be executed or was invalid
+	/*!
+		The program builds are finished first, so the compilers running in the background
+		do not disturb the timings of the runs.
+	*/
+	bool RunBenchmarks();
+
+	//! Prints all runs of RunBenchmarks() in the format selected with --format
+	void PrintBenchmarkSummary(std::ostream& Out) const;
+
+	//! One run of AddBenchmark()
+	struct SBenchmarkRun
+	{
+		std::string			Task;
+		SBenchmarkConfig	Config;
+		bool				Executed;
+		bool				Valid;
+		//! Wall time of the whole run, including the CPU reference and the validation
+		double				Milliseconds;
+	};
+
+	//! A run of AddBenchmark() which has not been executed yet
+	struct SQueuedRun
+	{
+		//! Heading of AddBenchmarkSection() printed before the run, if not empty
+		std::string						Section;
+		SBenchmarkRun					Run;
+		//! nullptr if the task does not support the configuration
+		std::unique_ptr<IComputeTask>	Task;
+	};
+
+	CBenchmarkOptions			m_Options;
+	std::vector<SQueuedRun>		m_QueuedRuns;
+	std::string					m_PendingSection;
+	std::vector<SBenchmarkRun>	m_BenchmarkRuns;
+	//! Timings recorded by the tasks, active while the context exists
+	CBenchmarkReport			m_Report;
+	//! Timeline of the host and device activity, only active if a trace file was requested
+	CTraceRecorder				m_Trace;
+	//! Result of the validation in the last RunComputeTask()
+	bool						m_LastTaskValid = false;
+
+	cl_platform_id		m_CLPlatform;
+	cl_device_id		m_CLDevice;
+	CLContext			m_CLContext;
+	CLCommandQueue		m_CLCommandQueue;
+	//! Second queue on m_CLDevice for transfers, see IOverlappedComputeTask
+	CLCommandQueue		m_CLTransferQueue;
+
+	//! Device buffers returned by the tasks, active while the context exists
+	CBufferPool			m_BufferPool;
+
+	//! Device requested on the command line, empty for the automatic selection
+	std::string			m_DeviceOverride;
+
+	//! Multi-device mode: the context contains all available devices of the selected platform
+	/*!
+		m_CLDevices[0] and m_CLCommandQueues[0] are the selected device and its queue
+		(m_CLDevice and m_CLCommandQueue), in single device mode the vectors only contain these.
+	*/
+	bool							m_MultiDevice = false;
+	std::vector<cl_device_id>		m_CLDevices;
+	std::vector<cl_command_queue>	m_CLCommandQueues;
+	//! The queues of the additional devices, m_CLCommandQueues only refers to them
+	std::vector<CLCommandQueue>		m_CLAdditionalQueues;
+};
+
+#endif // _CASSIGNMENT_BASE_H
@@ -0,0 +1,299 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CBenchmarkOptions.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+// upper bound of the number of runs of a sweep, protects against typos such as "1:1G:+1"
+#define MAX_SWEEP_STEPS 4096
+
+///////////////////////////////////////////////////////////////////////////////
+// CBenchmarkOptions
+
+CBenchmarkOptions::CBenchmarkOptions()
+	: m_Iterations(0), m_Format(FORMAT_TEXT), m_MultiDevice(false), m_Threshold(5.0), m_DifferenceImages(false), m_Help(false)
+{
+}
+
+bool CBenchmarkOptions::Parse(int argc, char** argv)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+
+		if(option == "--help" || option == "-h")
+		{
+			m_Help = true;
+			continue;
+		}
+		if(option == "--multi-device")
+		{
+			m_MultiDevice = true;
+			continue;
+		}
+		if(option == "--difference-images")
+		{
+			m_DifferenceImages = true;
+			continue;
+		}
+
+		// all other options take a value
+		if(i + 1 >= argc)
+		{
+			cerr << "Error: missing value of the option " << option << "." << endl;
+			return false;
+		}
+		string value = argv[++i];
+
+		bool valid = true;
+		if(option == "--task")
+			m_Tasks = Split(value, ',');
+		else if(option == "--size")
+			valid = ParseDimensionList(value, m_Sizes);
+		else if(option == "--local")
+			valid = ParseDimensionList(value, m_LocalSizes);
+		else if(option == "--iterations")
+		{
+			size_t iterations;
+			valid = ParseValue(value, iterations) && iterations > 0;
+			m_Iterations = (unsigned int)iterations;
+		}
+		else if(option == "--input")
+			m_Inputs = Split(value, ',');
+		else if(option == "--format")
+		{
+			if(value == "text")
+				m_Format = FORMAT_TEXT;
+			else if(value == "csv")
+				m_Format = FORMAT_CSV;
+			else
+				valid = false;
+		}
+		else if(option == "--device")
+			m_DeviceOverride = value;
+		else if(option == "--report")
+			m_ReportFile = value;
+		else if(option == "--baseline")
+			m_BaselineFile = value;
+		else if(option == "--trace")
+			m_TraceFile = value;
+		else if(option == "--kernel-dir")
+			m_KernelDir = value;
+		else if(option == "--preview")
+		{
+			m_PreviewFormat = value;
+			valid = value == "bmp" || value == "ppm" || value == "pgm";
+		}
+		else if(option == "--threshold")
+		{
+			char* end = nullptr;
+			m_Threshold = strtod(value.c_str(), &end);
+			valid = end != value.c_str() && *end == '\0' && m_Threshold >= 0.0;
+		}
+		else
+		{
+			cerr << "Error: unknown option " << option << "." << endl;
+			return false;
+		}
+
+		if(!valid)
+		{
+			cerr << "Error: invalid value '" << value << "' of the option " << option << "." << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void CBenchmarkOptions::PrintUsage(const char* ProgramName, ostream& Out)
+{
+	Out << "Usage: " << ProgramName << " [options]" << endl << endl
+		<< "  --task <name>[,<name>...]    only run the selected tasks (\"name\" also selects \"name.variant\")" << endl
+		<< "  --size <list>                problem sizes, e.g. 16M, 1920x1080 or the sweep 1M:64M:x2" << endl
+		<< "  --local <list>               local work sizes, e.g. 256, 32x16 or the sweep 64:512:x2" << endl
+		<< "  --iterations <n>             timed iterations of the GPU kernels" << endl
+		<< "  --input <file>[,<file>...]   input files, the files of one run are joined with '+'" << endl
+		<< "                               (a directory runs the image tasks over all its images)" << endl
+		<< "  --format <text|csv>          format of the run summary" << endl
+		<< "  --report <file>              write the timings as JSON (*.json) or CSV (otherwise)" << endl
+		<< "  --baseline <file>            compare the timings to a report of an earlier run" << endl
+		<< "  --threshold <percent>        slowdown which counts as a regression (default 5)" << endl
+		<< "  --trace <file>               write a timeline for chrome://tracing or Perfetto" << endl
+		<< "  --kernel-dir <dir>           load the kernel sources (*.cl) from dir instead of the embedded copies" << endl
+		<< "  --preview <bmp|ppm|pgm>      save an 8 bit preview with every result image" << endl
+		<< "  --difference-images          save the difference of the GPU and CPU results of the image tasks" << endl
+		<< "  --device <selection>         platform:device, device index, gpu/cpu/accelerator or a name substring" << endl
+		<< "  --multi-device               split the tasks which support it over all devices of the platform" << endl
+		<< "  --help                       print this text" << endl << endl
+		<< "Sweeps are \"from:to[:step]\", the step \"xN\" multiplies (default x2), \"+N\" adds." << endl
+		<< "Values accept the suffixes K, M and G. Options a task does not use are ignored." << endl;
+}
+
+bool CBenchmarkOptions::IsTaskSelected(const string& Task) const
+{
+	if(m_Tasks.empty())
+		return true;
+
+	for(size_t i = 0; i < m_Tasks.size(); i++)
+	{
+		const string& selected = m_Tasks[i];
+		if(Task == selected || (Task.size() > selected.size() && Task.compare(0, selected.size(), selected) == 0 && Task[selected.size()] == '.'))
+			return true;
+	}
+	return false;
+}
+
+vector<SBenchmarkConfig> CBenchmarkOptions::GetConfigs(const SBenchmarkConfig& Defaults) const
+{
+	// options only multiply the runs if the task actually uses them
+	vector<SDimensions> sizes(1), localSizes(1);
+	for(int d = 0; d < 3; d++)
+	{
+		sizes[0].Value[d] = Defaults.Size[d];
+		localSizes[0].Value[d] = Defaults.LocalWorkSize[d];
+	}
+	if(Defaults.Size[0] != 0 && !m_Sizes.empty())
+		sizes = m_Sizes;
+	if(Defaults.LocalWorkSize[0] != 0 && !m_LocalSizes.empty())
+		localSizes = m_LocalSizes;
+
+	vector<string> inputs(1, Defaults.Input);
+	if(!Defaults.Input.empty() && !m_Inputs.empty())
+		inputs = m_Inputs;
+
+	vector<SBenchmarkConfig> configs;
+	for(size_t s = 0; s < sizes.size(); s++)
+	{
+		for(size_t l = 0; l < localSizes.size(); l++)
+		{
+			for(size_t i = 0; i < inputs.size(); i++)
+			{
+				SBenchmarkConfig config;
+				for(int d = 0; d < 3; d++)
+				{
+					config.Size[d] = sizes[s].Value[d];
+					config.LocalWorkSize[d] = localSizes[l].Value[d];
+				}
+				config.Iterations = m_Iterations > 0 ? m_Iterations : Defaults.Iterations;
+				config.Input = inputs[i];
+				configs.push_back(config);
+			}
+		}
+	}
+	return configs;
+}
+
+vector<string> CBenchmarkOptions::SplitInputFiles(const string& Input)
+{
+	return Split(Input, '+');
+}
+
+bool CBenchmarkOptions::ParseValue(const string& Text, size_t& Value)
+{
+	if(Text.empty() || !isdigit((unsigned char)Text[0]))
+		return false;
+
+	char* end = nullptr;
+	unsigned long long value = strtoull(Text.c_str(), &end, 10);
+	string suffix = end;
+	if(suffix == "K" || suffix == "k")
+		value <<= 10;
+	else if(suffix == "M" || suffix == "m")
+		value <<= 20;
+	else if(suffix == "G" || suffix == "g")
+		value <<= 30;
+	else if(!suffix.empty())
+		return false;
+
+	Value = size_t(value);
+	return true;
+}
+
+bool CBenchmarkOptions::ParseDimensions(const string& Text, SDimensions& Dimensions)
+{
+	vector<string> components = Split(Text, 'x');
+	if(components.empty() || components.size() > 3)
+		return false;
+
+	for(int d = 0; d < 3; d++)
+	{
+		Dimensions.Value[d] = 1;
+		if(size_t(d) < components.size() && (!ParseValue(components[d], Dimensions.Value[d]) || Dimensions.Value[d] == 0))
+			return false;
+	}
+	return true;
+}
+
+bool CBenchmarkOptions::ParseDimensionList(const string& Text, vector<SDimensions>& List)
+{
+	List.clear();
+
+	vector<string> entries = Split(Text, ',');
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		vector<string> range = Split(entries[i], ':');
+		SDimensions dimensions;
+		if(range.size() == 1)
+		{
+			if(!ParseDimensions(range[0], dimensions))
+				return false;
+			List.push_back(dimensions);
+			continue;
+		}
+		if(range.size() > 3)
+			return false;
+
+		// sweep over one-dimensional values
+		size_t from, to, step = 2;
+		bool geometric = true;
+		if(!ParseValue(range[0], from) || !ParseValue(range[1], to) || from == 0 || from > to)
+			return false;
+		if(range.size() == 3)
+		{
+			string stepText = range[2];
+			geometric = !stepText.empty() && stepText[0] == 'x';
+			if(!stepText.empty() && (stepText[0] == 'x' || stepText[0] == '+'))
+				stepText = stepText.substr(1);
+			if(!ParseValue(stepText, step) || step < (geometric ? 2u : 1u))
+				return false;
+		}
+
+		dimensions.Value[1] = dimensions.Value[2] = 1;
+		for(size_t value = from, n = 0; value <= to; value = geometric ? value * step : value + step, n++)
+		{
+			if(n == MAX_SWEEP_STEPS)
+			{
+				cerr << "Error: the sweep " << entries[i] << " has more than " << MAX_SWEEP_STEPS << " steps." << endl;
+				return false;
+			}
+			dimensions.Value[0] = value;
+			List.push_back(dimensions);
+		}
+	}
+	return !List.empty();
+}
+
+vector<string> CBenchmarkOptions::Split(const string& Text, char Separator)
+{
+	vector<string> parts;
+	size_t begin = 0;
+	while(begin <= Text.size())
+	{
+		size_t end = Text.find(Separator, begin);
+		if(end == string::npos)
+			end = Text.size();
+		if(end > begin)
+			parts.push_back(Text.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	return parts;
+}
+
+///////////////////////////////////////////////////////////////////////////////
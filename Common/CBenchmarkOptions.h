@@ -0,0 +1,138 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CBENCHMARK_OPTIONS_H
+#define _CBENCHMARK_OPTIONS_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+//! One benchmark run: the problem size, work-group size, iteration count and input of a task
+/*!
+	Unused dimensions of Size and LocalWorkSize are 1. A task which does not take a
+	problem size (e.g. it processes an image) has Size[0] == 0 in its defaults, a task
+	which chooses its work-group sizes itself has LocalWorkSize[0] == 0 and a task
+	which does not read a file has an empty Input. The corresponding options do not
+	apply to such tasks.
+*/
+struct SBenchmarkConfig
+{
+	size_t			Size[3];
+	size_t			LocalWorkSize[3];
+	unsigned int	Iterations;
+	std::string		Input;
+};
+
+//! Command line options of the assignments
+/*!
+	The options select the tasks and override their default configurations,
+	so other data shapes can be measured without recompiling:
+
+		--task <name>[,<name>...]		only run these tasks ("name" also selects "name.variant")
+		--size <list>					problem sizes, e.g. 16M or 1920x1080
+		--local <list>					local work sizes, e.g. 256 or 32x16
+		--iterations <n>				timed iterations of the GPU kernels
+		--input <file>[,<file>...]		input files, files of one run are joined with '+'
+		--format <text|csv>				format of the run summary
+		--report <file>					write the timings as JSON (*.json) or CSV (otherwise)
+		--baseline <file>				compare the timings to a report of an earlier run
+		--threshold <percent>			slowdown which counts as a regression (default 5)
+		--trace <file>					write a timeline of host and device activity (trace event JSON)
+		--kernel-dir <dir>				load the kernel sources from dir instead of the embedded copies
+		--preview <bmp|ppm|pgm>			save an 8 bit preview with every result image
+		--difference-images				save the difference of the GPU and CPU results of the image tasks
+		--device <selection>			see CAssignmentBase::InitCLContext()
+		--multi-device					split the tasks which support it over all devices
+
+	A list is comma separated, each entry is either a single value or a sweep "from:to[:step]"
+	of one-dimensional values. The step "xN" multiplies (the default is x2), "+N" or "N" adds.
+	Values accept the suffixes K, M and G (powers of 1024), e.g. "--size 1M:64M:x4".
+	Every combination of sizes, local sizes and inputs is run.
+*/
+class CBenchmarkOptions
+{
+public:
+	enum EOutputFormat
+	{
+		FORMAT_TEXT = 0,
+		FORMAT_CSV
+	};
+
+	CBenchmarkOptions();
+
+	//! Returns false and prints the reason if the command line is invalid
+	bool Parse(int argc, char** argv);
+
+	static void PrintUsage(const char* ProgramName, std::ostream& Out);
+
+	//! True if no --task option was given or Task (or its prefix before a '.') was selected
+	bool IsTaskSelected(const std::string& Task) const;
+
+	//! All configurations of a task, options which were not given are taken from Defaults
+	std::vector<SBenchmarkConfig> GetConfigs(const SBenchmarkConfig& Defaults) const;
+
+	//! Splits an input entry of GetConfigs() into the files of a single run
+	static std::vector<std::string> SplitInputFiles(const std::string& Input);
+
+	bool IsHelpRequested() const { return m_Help; }
+	EOutputFormat GetOutputFormat() const { return m_Format; }
+	const std::string& GetDeviceOverride() const { return m_DeviceOverride; }
+	bool IsMultiDevice() const { return m_MultiDevice; }
+	const std::string& GetReportFile() const { return m_ReportFile; }
+	const std::string& GetBaselineFile() const { return m_BaselineFile; }
+	double GetThreshold() const { return m_Threshold; }
+	const std::string& GetTraceFile() const { return m_TraceFile; }
+	const std::string& GetKernelDir() const { return m_KernelDir; }
+	//! Empty if no preview images are requested
+	const std::string& GetPreviewFormat() const { return m_PreviewFormat; }
+	bool IsDifferenceImageRequested() const { return m_DifferenceImages; }
+
+protected:
+	struct SDimensions
+	{
+		size_t		Value[3];
+	};
+
+	static bool ParseValue(const std::string& Text, size_t& Value);
+	static bool ParseDimensions(const std::string& Text, SDimensions& Dimensions);
+	static bool ParseDimensionList(const std::string& Text, std::vector<SDimensions>& List);
+	static std::vector<std::string> Split(const std::string& Text, char Separator);
+
+	std::vector<std::string>	m_Tasks;
+	std::vector<SDimensions>	m_Sizes;
+	std::vector<SDimensions>	m_LocalSizes;
+	//! 0 if the task defaults are used
+	unsigned int				m_Iterations;
+	std::vector<std::string>	m_Inputs;
+	EOutputFormat				m_Format;
+	std::string					m_DeviceOverride;
+	bool						m_MultiDevice;
+	std::string					m_ReportFile;
+	std::string					m_BaselineFile;
+	//! In percent of the baseline time
+	double						m_Threshold;
+	std::string					m_TraceFile;
+	std::string					m_KernelDir;
+	std::string					m_PreviewFormat;
+	bool						m_DifferenceImages;
+	bool						m_Help;
+};
+
+#endif // _CBENCHMARK_OPTIONS_H
@@ -0,0 +1,584 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CBenchmarkReport.h"
+#include "CJsonUtil.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <cstdlib>
+
+using namespace std;
+
+CBenchmarkReport* CBenchmarkReport::s_pActive = nullptr;
+
+namespace
+{
+	//! Minimal JSON document tree, enough to read back the reports written by WriteJSON()
+	struct SJsonValue
+	{
+		enum EType { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		EType										Type = JSON_NULL;
+		double										Number = 0.0;
+		string										String;
+		vector<SJsonValue>							Items;
+		vector<pair<string, SJsonValue> >			Members;
+
+		const SJsonValue* Find(const string& Name) const
+		{
+			for(size_t i = 0; i < Members.size(); i++)
+				if(Members[i].first == Name)
+					return &Members[i].second;
+			return nullptr;
+		}
+	};
+
+	class CJsonParser
+	{
+	public:
+		CJsonParser(const string& Text) : m_Text(Text), m_Pos(0) {}
+
+		bool Parse(SJsonValue& Value)
+		{
+			if(!ParseValue(Value))
+				return false;
+			SkipWhitespace();
+			return m_Pos == m_Text.size();
+		}
+
+	protected:
+		void SkipWhitespace()
+		{
+			while(m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t' || m_Text[m_Pos] == '\n' || m_Text[m_Pos] == '\r'))
+				m_Pos++;
+		}
+
+		bool Expect(char C)
+		{
+			SkipWhitespace();
+			if(m_Pos >= m_Text.size() || m_Text[m_Pos] != C)
+				return false;
+			m_Pos++;
+			return true;
+		}
+
+		bool ParseLiteral(const char* Literal)
+		{
+			string literal = Literal;
+			if(m_Text.compare(m_Pos, literal.size(), literal) != 0)
+				return false;
+			m_Pos += literal.size();
+			return true;
+		}
+
+		bool ParseString(string& String)
+		{
+			if(!Expect('"'))
+				return false;
+			String.clear();
+			while(m_Pos < m_Text.size() && m_Text[m_Pos] != '"')
+			{
+				char c = m_Text[m_Pos++];
+				if(c != '\\')
+				{
+					String += c;
+					continue;
+				}
+				if(m_Pos >= m_Text.size())
+					return false;
+				c = m_Text[m_Pos++];
+				switch(c)
+				{
+				case 'n': String += '\n'; break;
+				case 't': String += '\t'; break;
+				case 'r': String += '\r'; break;
+				case 'b': String += '\b'; break;
+				case 'f': String += '\f'; break;
+				case 'u':
+					{
+						// only ASCII is written by WriteJSON(), anything else is replaced
+						if(m_Pos + 4 > m_Text.size())
+							return false;
+						long code = strtol(m_Text.substr(m_Pos, 4).c_str(), nullptr, 16);
+						String += code < 0x80 ? char(code) : '?';
+						m_Pos += 4;
+					}
+					break;
+				default: String += c; break;
+				}
+			}
+			return Expect('"');
+		}
+
+		bool ParseValue(SJsonValue& Value)
+		{
+			SkipWhitespace();
+			if(m_Pos >= m_Text.size())
+				return false;
+
+			char c = m_Text[m_Pos];
+			if(c == '"')
+			{
+				Value.Type = SJsonValue::JSON_STRING;
+				return ParseString(Value.String);
+			}
+			if(c == '{')
+			{
+				Value.Type = SJsonValue::JSON_OBJECT;
+				m_Pos++;
+				if(Expect('}'))
+					return true;
+				do
+				{
+					pair<string, SJsonValue> member;
+					if(!ParseString(member.first) || !Expect(':') || !ParseValue(member.second))
+						return false;
+					Value.Members.push_back(member);
+				} while(Expect(','));
+				return Expect('}');
+			}
+			if(c == '[')
+			{
+				Value.Type = SJsonValue::JSON_ARRAY;
+				m_Pos++;
+				if(Expect(']'))
+					return true;
+				do
+				{
+					Value.Items.push_back(SJsonValue());
+					if(!ParseValue(Value.Items.back()))
+						return false;
+				} while(Expect(','));
+				return Expect(']');
+			}
+			if(ParseLiteral("true") || ParseLiteral("false"))
+			{
+				Value.Type = SJsonValue::JSON_BOOL;
+				Value.Number = m_Text[m_Pos - 2] == 'u' ? 1.0 : 0.0;
+				return true;
+			}
+			if(ParseLiteral("null"))
+			{
+				Value.Type = SJsonValue::JSON_NULL;
+				return true;
+			}
+
+			const char* begin = m_Text.c_str() + m_Pos;
+			char* end = nullptr;
+			Value.Type = SJsonValue::JSON_NUMBER;
+			Value.Number = strtod(begin, &end);
+			if(end == begin)
+				return false;
+			m_Pos += end - begin;
+			return true;
+		}
+
+		const string&	m_Text;
+		size_t			m_Pos;
+	};
+
+	//! Quotes a CSV field if it contains a separator or a quote
+	string CsvField(const string& Text)
+	{
+		if(Text.find_first_of(",\"\n") == string::npos)
+			return Text;
+		string quoted = "\"";
+		for(size_t i = 0; i < Text.size(); i++)
+		{
+			if(Text[i] == '"')
+				quoted += '"';
+			quoted += Text[i];
+		}
+		return quoted + "\"";
+	}
+
+	vector<string> SplitCsvLine(const string& Line)
+	{
+		vector<string> fields(1);
+		bool quoted = false;
+		for(size_t i = 0; i < Line.size(); i++)
+		{
+			char c = Line[i];
+			if(quoted)
+			{
+				if(c == '"' && i + 1 < Line.size() && Line[i + 1] == '"')
+					fields.back() += Line[++i];
+				else if(c == '"')
+					quoted = false;
+				else
+					fields.back() += c;
+			}
+			else if(c == '"')
+				quoted = true;
+			else if(c == ',')
+				fields.push_back(string());
+			else if(c != '\r')
+				fields.back() += c;
+		}
+		return fields;
+	}
+
+	double Mean(const vector<double>& Samples)
+	{
+		double sum = 0.0;
+		for(size_t i = 0; i < Samples.size(); i++)
+			sum += Samples[i];
+		return Samples.empty() ? 0.0 : sum / double(Samples.size());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CBenchmarkReport
+
+CBenchmarkReport::CBenchmarkReport()
+	: m_RunBegin(0)
+{
+	SBenchmarkConfig config = {{0, 1, 1}, {1, 1, 1}, 0, ""};
+	m_Config = config;
+}
+
+CBenchmarkReport::~CBenchmarkReport()
+{
+	if(s_pActive == this)
+		s_pActive = nullptr;
+}
+
+void CBenchmarkReport::BeginRun(const string& Task, const SBenchmarkConfig& Config)
+{
+	m_Task = Task;
+	m_Config = Config;
+	m_RunBegin = m_Results.size();
+}
+
+void CBenchmarkReport::EndRun(bool Valid)
+{
+	for(size_t i = m_RunBegin; i < m_Results.size(); i++)
+		m_Results[i].Valid = Valid;
+}
+
+void CBenchmarkReport::Add(const string& Variant, const vector<double>& SamplesMs, unsigned int Iterations, double Work, const char* Unit)
+{
+	SBenchmarkResult result;
+	result.Task = m_Task;
+	result.Variant = Variant;
+	result.Device = m_Device;
+	result.Input = m_Config.Input;
+	for(int d = 0; d < 3; d++)
+	{
+		result.Size[d] = m_Config.Size[d];
+		result.LocalWorkSize[d] = m_Config.LocalWorkSize[d];
+	}
+	result.Iterations = Iterations;
+	result.SamplesMs = SamplesMs;
+	result.MeanMs = Mean(SamplesMs);
+	// Work per ms * 1e-6 = billions per second
+	result.Throughput = result.MeanMs > 0.0 ? Work * 1.0e-6 / result.MeanMs : 0.0;
+	result.Unit = Unit;
+	// the validation of the run follows the timings, see EndRun()
+	result.Valid = true;
+	m_Results.push_back(result);
+}
+
+bool CBenchmarkReport::Save(const string& FileName) const
+{
+	ofstream file(FileName.c_str());
+	if(!file)
+	{
+		cerr << "Error: cannot write the benchmark report " << FileName << "." << endl;
+		return false;
+	}
+
+	bool json = FileName.size() >= 5 && FileName.compare(FileName.size() - 5, 5, ".json") == 0;
+	if(json)
+		WriteJSON(file);
+	else
+		WriteCSV(file);
+	return bool(file);
+}
+
+void CBenchmarkReport::WriteJSON(ostream& Out) const
+{
+	streamsize precision = Out.precision(9);
+
+	Out << "{" << endl << "  \"results\": [";
+	for(size_t i = 0; i < m_Results.size(); i++)
+	{
+		const SBenchmarkResult& r = m_Results[i];
+		Out << (i > 0 ? "," : "") << endl << "    {"
+			<< "\"task\": " << CJsonUtil::QuoteString(r.Task)
+			<< ", \"variant\": " << CJsonUtil::QuoteString(r.Variant)
+			<< ", \"device\": " << CJsonUtil::QuoteString(r.Device)
+			<< ", \"input\": " << CJsonUtil::QuoteString(r.Input)
+			<< ", \"size\": [" << r.Size[0] << ", " << r.Size[1] << ", " << r.Size[2] << "]"
+			<< ", \"local_size\": [" << r.LocalWorkSize[0] << ", " << r.LocalWorkSize[1] << ", " << r.LocalWorkSize[2] << "]"
+			<< ", \"iterations\": " << r.Iterations
+			<< ", \"mean_ms\": " << r.MeanMs
+			<< ", \"throughput\": " << r.Throughput
+			<< ", \"unit\": " << CJsonUtil::QuoteString(r.Unit)
+			<< ", \"valid\": " << (r.Valid ? "true" : "false")
+			<< ", \"samples_ms\": [";
+		for(size_t s = 0; s < r.SamplesMs.size(); s++)
+			Out << (s > 0 ? ", " : "") << r.SamplesMs[s];
+		Out << "]}";
+	}
+	Out << endl << "  ]" << endl << "}" << endl;
+
+	Out.precision(precision);
+}
+
+void CBenchmarkReport::WriteCSV(ostream& Out) const
+{
+	streamsize precision = Out.precision(9);
+
+	// the samples are a single field, separated by ';'
+	Out << "task,variant,device,input,size_x,size_y,size_z,local_x,local_y,local_z,iterations,mean_ms,throughput,unit,valid,samples_ms" << endl;
+	for(size_t i = 0; i < m_Results.size(); i++)
+	{
+		const SBenchmarkResult& r = m_Results[i];
+		Out << CsvField(r.Task) << "," << CsvField(r.Variant) << "," << CsvField(r.Device) << "," << CsvField(r.Input) << ","
+			<< r.Size[0] << "," << r.Size[1] << "," << r.Size[2] << ","
+			<< r.LocalWorkSize[0] << "," << r.LocalWorkSize[1] << "," << r.LocalWorkSize[2] << ","
+			<< r.Iterations << "," << r.MeanMs << "," << r.Throughput << "," << CsvField(r.Unit) << ","
+			<< (r.Valid ? "true" : "false") << ",";
+		for(size_t s = 0; s < r.SamplesMs.size(); s++)
+			Out << (s > 0 ? ";" : "") << r.SamplesMs[s];
+		Out << endl;
+	}
+
+	Out.precision(precision);
+}
+
+bool CBenchmarkReport::Load(const string& FileName)
+{
+	ifstream file(FileName.c_str());
+	if(!file)
+	{
+		cerr << "Error: cannot read the benchmark report " << FileName << "." << endl;
+		return false;
+	}
+	stringstream ss;
+	ss << file.rdbuf();
+	string text = ss.str();
+
+	m_Results.clear();
+	size_t first = text.find_first_not_of(" \t\r\n");
+	bool success = first != string::npos && text[first] == '{' ? LoadJSON(text) : LoadCSV(text);
+	if(!success)
+		cerr << "Error: " << FileName << " is not a valid benchmark report." << endl;
+	return success;
+}
+
+bool CBenchmarkReport::LoadJSON(const string& Text)
+{
+	SJsonValue root;
+	if(!CJsonParser(Text).Parse(root))
+		return false;
+
+	const SJsonValue* results = root.Find("results");
+	if(results == nullptr || results->Type != SJsonValue::JSON_ARRAY)
+		return false;
+
+	for(size_t i = 0; i < results->Items.size(); i++)
+	{
+		const SJsonValue& item = results->Items[i];
+		const SJsonValue* task = item.Find("task");
+		const SJsonValue* variant = item.Find("variant");
+		const SJsonValue* device = item.Find("device");
+		// reports written before the input was recorded have none
+		const SJsonValue* input = item.Find("input");
+		const SJsonValue* size = item.Find("size");
+		const SJsonValue* localSize = item.Find("local_size");
+		const SJsonValue* iterations = item.Find("iterations");
+		const SJsonValue* meanMs = item.Find("mean_ms");
+		const SJsonValue* throughput = item.Find("throughput");
+		const SJsonValue* unit = item.Find("unit");
+		// and before the validation was recorded, their results count as valid
+		const SJsonValue* valid = item.Find("valid");
+		const SJsonValue* samples = item.Find("samples_ms");
+		if(!task || !variant || !device || !size || size->Items.size() != 3 || !localSize || localSize->Items.size() != 3 ||
+			!iterations || !meanMs || !throughput || !unit || !samples)
+			return false;
+
+		SBenchmarkResult r;
+		r.Task = task->String;
+		r.Variant = variant->String;
+		r.Device = device->String;
+		if(input != nullptr)
+			r.Input = input->String;
+		for(int d = 0; d < 3; d++)
+		{
+			r.Size[d] = size_t(size->Items[d].Number);
+			r.LocalWorkSize[d] = size_t(localSize->Items[d].Number);
+		}
+		r.Iterations = (unsigned int)iterations->Number;
+		r.MeanMs = meanMs->Number;
+		r.Throughput = throughput->Number;
+		r.Unit = unit->String;
+		r.Valid = valid == nullptr || valid->Number != 0.0;
+		for(size_t s = 0; s < samples->Items.size(); s++)
+			r.SamplesMs.push_back(samples->Items[s].Number);
+		m_Results.push_back(r);
+	}
+	return true;
+}
+
+bool CBenchmarkReport::LoadCSV(const string& Text)
+{
+	stringstream ss(Text);
+	string line;
+	// header
+	if(!getline(ss, line))
+		return false;
+
+	while(getline(ss, line))
+	{
+		if(line.empty() || line == "\r")
+			continue;
+		vector<string> f = SplitCsvLine(line);
+		// reports written before the input was recorded have no input column,
+		// and before the validation was recorded no valid column (their results count as valid)
+		if(f.size() == 14)
+			f.insert(f.begin() + 3, string());
+		if(f.size() == 15)
+			f.insert(f.begin() + 14, string("true"));
+		if(f.size() != 16)
+			return false;
+
+		SBenchmarkResult r;
+		r.Task = f[0];
+		r.Variant = f[1];
+		r.Device = f[2];
+		r.Input = f[3];
+		for(int d = 0; d < 3; d++)
+		{
+			r.Size[d] = size_t(strtoull(f[4 + d].c_str(), nullptr, 10));
+			r.LocalWorkSize[d] = size_t(strtoull(f[7 + d].c_str(), nullptr, 10));
+		}
+		r.Iterations = (unsigned int)strtoul(f[10].c_str(), nullptr, 10);
+		r.MeanMs = strtod(f[11].c_str(), nullptr);
+		r.Throughput = strtod(f[12].c_str(), nullptr);
+		r.Unit = f[13];
+		r.Valid = f[14] != "false" && f[14] != "0";
+		stringstream samples(f[15]);
+		string sample;
+		while(getline(samples, sample, ';'))
+			r.SamplesMs.push_back(strtod(sample.c_str(), nullptr));
+		m_Results.push_back(r);
+	}
+	return true;
+}
+
+string CBenchmarkReport::GetKey(const SBenchmarkResult& Result)
+{
+	stringstream ss;
+	ss << Result.Task << "/" << Result.Variant << " on " << Result.Device;
+	if(!Result.Input.empty())
+		ss << ", input " << Result.Input;
+	ss << ", size " << Result.Size[0] << "x" << Result.Size[1] << "x" << Result.Size[2]
+		<< ", local " << Result.LocalWorkSize[0] << "x" << Result.LocalWorkSize[1] << "x" << Result.LocalWorkSize[2];
+	return ss.str();
+}
+
+bool CBenchmarkReport::Compare(const CBenchmarkReport& Baseline, double ThresholdPercent, ostream& Out) const
+{
+	map<string, const SBenchmarkResult*> baseline;
+	for(size_t i = 0; i < Baseline.m_Results.size(); i++)
+		baseline[GetKey(Baseline.m_Results[i])] = &Baseline.m_Results[i];
+
+	Out << "########################################" << endl
+		<< "Comparison to the baseline (threshold " << ThresholdPercent << "%):" << endl << endl;
+
+	size_t numRegressions = 0, numImprovements = 0, numInvalid = 0, numNew = 0;
+	set<string> current;
+	for(size_t i = 0; i < m_Results.size(); i++)
+	{
+		const SBenchmarkResult& r = m_Results[i];
+		string key = GetKey(r);
+		current.insert(key);
+
+		// the timing of a wrong result means nothing
+		if(!r.Valid)
+		{
+			Out << "  " << key << ": " << r.MeanMs << " ms, INVALID result" << endl;
+			numInvalid++;
+			continue;
+		}
+
+		map<string, const SBenchmarkResult*>::const_iterator it = baseline.find(key);
+		if(it == baseline.end() || !it->second->Valid || it->second->MeanMs <= 0.0)
+		{
+			Out << "  " << key << ": " << r.MeanMs << " ms, NOT IN THE BASELINE" << (it != baseline.end() ? " (no valid timing)" : "") << endl;
+			numNew++;
+			continue;
+		}
+
+		double change = 100.0 * (r.MeanMs - it->second->MeanMs) / it->second->MeanMs;
+		const char* verdict = "";
+		if(change > ThresholdPercent)
+		{
+			verdict = "  REGRESSION";
+			numRegressions++;
+		}
+		else if(change < -ThresholdPercent)
+		{
+			verdict = "  improved";
+			numImprovements++;
+		}
+		Out << "  " << key << ": " << it->second->MeanMs << " ms -> " << r.MeanMs << " ms ("
+			<< (change >= 0.0 ? "+" : "") << change << "%)" << verdict << endl;
+	}
+
+	// results of the baseline which this run did not produce, e.g. a variant that disappeared
+	size_t numMissing = 0;
+	for(map<string, const SBenchmarkResult*>::const_iterator it = baseline.begin(); it != baseline.end(); ++it)
+	{
+		if(current.count(it->first) != 0)
+			continue;
+		Out << "  " << it->first << ": " << it->second->MeanMs << " ms in the baseline, MISSING in this run" << endl;
+		numMissing++;
+	}
+
+	Out << endl << numRegressions << " regression(s), " << numImprovements << " improvement(s), "
+		<< numInvalid << " invalid result(s), " << numNew << " result(s) without baseline, "
+		<< numMissing << " baseline result(s) missing." << endl << endl;
+	return numRegressions == 0 && numInvalid == 0 && numNew == 0 && numMissing == 0;
+}
+
+CBenchmarkReport* CBenchmarkReport::GetActive()
+{
+	return s_pActive;
+}
+
+void CBenchmarkReport::SetActive(CBenchmarkReport* Report)
+{
+	s_pActive = Report;
+}
+
+void CBenchmarkReport::Record(const string& Variant, const vector<double>& SamplesMs, double Work, const char* Unit)
+{
+	if(s_pActive != nullptr)
+		s_pActive->Add(Variant, SamplesMs, (unsigned int)SamplesMs.size(), Work, Unit);
+}
+
+void CBenchmarkReport::Record(const string& Variant, double AverageMs, unsigned int Iterations, double Work, const char* Unit)
+{
+	if(s_pActive != nullptr)
+		s_pActive->Add(Variant, vector<double>(1, AverageMs), Iterations, Work, Unit);
+}
+
+void CBenchmarkReport::SetRunSize(size_t X, size_t Y, size_t Z)
+{
+	if(s_pActive == nullptr)
+		return;
+	s_pActive->m_Config.Size[0] = X;
+	s_pActive->m_Config.Size[1] = Y;
+	s_pActive->m_Config.Size[2] = Z;
+}
+
+///////////////////////////////////////////////////////////////////////////////
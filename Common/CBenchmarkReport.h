@@ -0,0 +1,134 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CBENCHMARK_REPORT_H
+#define _CBENCHMARK_REPORT_H
+
+#include "CBenchmarkOptions.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+//! One timed variant of a benchmark run
+struct SBenchmarkResult
+{
+	std::string				Task;
+	std::string				Variant;
+	std::string				Device;
+	//! Input files of the run, empty if the task has none
+	std::string				Input;
+	//! For tasks whose size is given by their input, the size of the input (e.g. the image dimensions)
+	size_t					Size[3];
+	size_t					LocalWorkSize[3];
+	unsigned int			Iterations;
+	//! Timings in milliseconds per iteration, a single sample if only the average of the iterations was measured
+	std::vector<double>		SamplesMs;
+	double					MeanMs;
+	double					Throughput;
+	std::string				Unit;
+	//! False if the run of the result failed its validation
+	bool					Valid;
+};
+
+//! Machine readable benchmark results and the comparison against a baseline
+/*!
+	CAssignmentBase owns a report and makes it the active one while its context exists,
+	RunBenchmark() sets the task and configuration of the current run. The tasks call the
+	static Record() for each timed variant, which does nothing if no report is active.
+
+	The report is written as JSON or CSV (chosen by the file extension), both formats can
+	be loaded again as the baseline of Compare(). Results are matched by task, variant,
+	device, input, size and local size; a variant is a regression if its mean time grew by more
+	than the threshold. The comparison fails on regressions, on invalid results and if a result
+	has no counterpart in the other report.
+
+	NOTE: not thread-safe.
+*/
+class CBenchmarkReport
+{
+public:
+	CBenchmarkReport();
+
+	~CBenchmarkReport();
+
+	//! Task and configuration of the results recorded from now on
+	void BeginRun(const std::string& Task, const SBenchmarkConfig& Config);
+
+	//! Marks the results recorded since BeginRun() with the validation result of the run
+	void EndRun(bool Valid);
+
+	void SetDevice(const std::string& Device) { m_Device = Device; }
+
+	//! Adds a result of the current run
+	/*!
+		Work is the amount of work of one iteration (elements, pixels or bytes), the
+		throughput is Work / mean time in billions per second, labeled with Unit
+		(e.g. "Gelem/s", "Gpixels/s" or "GB/s").
+	*/
+	void Add(const std::string& Variant, const std::vector<double>& SamplesMs, unsigned int Iterations, double Work, const char* Unit);
+
+	const std::vector<SBenchmarkResult>& GetResults() const { return m_Results; }
+	void Clear() { m_Results.clear(); }
+
+	//! Writes JSON if FileName ends with ".json", CSV otherwise
+	bool Save(const std::string& FileName) const;
+	void WriteJSON(std::ostream& Out) const;
+	void WriteCSV(std::ostream& Out) const;
+
+	//! Loads results written by Save()
+	bool Load(const std::string& FileName);
+
+	//! Prints the comparison to Baseline
+	/*!
+		Returns false if a result regressed by more than ThresholdPercent, if a result is
+		invalid, or if a result of one report is missing in the other one.
+	*/
+	bool Compare(const CBenchmarkReport& Baseline, double ThresholdPercent, std::ostream& Out) const;
+
+	//! The report used by Record(), nullptr if there is none
+	static CBenchmarkReport* GetActive();
+	static void SetActive(CBenchmarkReport* Report);
+
+	//! Add() on the active report
+	static void Record(const std::string& Variant, const std::vector<double>& SamplesMs, double Work, const char* Unit);
+	//! Records the average of Iterations runs as a single sample
+	static void Record(const std::string& Variant, double AverageMs, unsigned int Iterations, double Work, const char* Unit);
+	//! Sets the size of the current run on the active report, for tasks whose size is given by their input
+	static void SetRunSize(size_t X, size_t Y, size_t Z);
+
+protected:
+	static std::string GetKey(const SBenchmarkResult& Result);
+
+	bool LoadJSON(const std::string& Text);
+	bool LoadCSV(const std::string& Text);
+
+	std::vector<SBenchmarkResult>	m_Results;
+
+	// the current run
+	std::string			m_Task;
+	//! Index of the first result of the current run
+	size_t				m_RunBegin;
+	std::string			m_Device;
+	SBenchmarkConfig	m_Config;
+
+	static CBenchmarkReport*	s_pActive;
+};
+
+#endif // _CBENCHMARK_REPORT_H
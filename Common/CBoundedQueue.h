@@ -0,0 +1,87 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+
+#ifndef _CBOUNDED_QUEUE_H
+#define _CBOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+//! Blocking FIFO queue of limited capacity, connects the stages of a pipeline of threads
+/*!
+	Push() waits while the queue is full, Pop() while it is empty. A producer calls Close()
+	after its last item, the consumer then still gets the remaining items and Pop() returns
+	false once the queue is empty. A consumer which stops early closes the queue as well,
+	so a producer waiting in Push() returns false instead of blocking forever.
+*/
+template<typename T>
+class CBoundedQueue
+{
+public:
+	explicit CBoundedQueue(size_t Capacity) : m_Capacity(Capacity > 0 ? Capacity : 1) {}
+
+	//! Appends Item, returns false (and drops Item) if the queue was closed
+	bool Push(T&& Item)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_NotFull.wait(lock, [this]() { return m_Closed || m_Items.size() < m_Capacity; });
+		if(m_Closed)
+			return false;
+		m_Items.push_back(std::move(Item));
+		m_NotEmpty.notify_one();
+		return true;
+	}
+
+	//! Takes the oldest item, returns false if the queue is closed and empty
+	bool Pop(T& Item)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_NotEmpty.wait(lock, [this]() { return m_Closed || !m_Items.empty(); });
+		if(m_Items.empty())
+			return false;
+		Item = std::move(m_Items.front());
+		m_Items.pop_front();
+		m_NotFull.notify_one();
+		return true;
+	}
+
+	//! No more items will be pushed, wakes up all waiting threads
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Closed = true;
+		m_NotEmpty.notify_all();
+		m_NotFull.notify_all();
+	}
+
+protected:
+	CBoundedQueue(const CBoundedQueue&);
+	CBoundedQueue& operator=(const CBoundedQueue&);
+
+	std::mutex					m_Mutex;
+	std::condition_variable		m_NotEmpty;
+	std::condition_variable		m_NotFull;
+	std::deque<T>				m_Items;
+	size_t						m_Capacity;
+	bool						m_Closed = false;
+};
+
+#endif // _CBOUNDED_QUEUE_H
@@ -0,0 +1,211 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CBufferPool.h"
+
+#include "CLUtil.h"
+
+using namespace std;
+
+// default limit of the idle buffers kept by the pool
+#define BUFFER_POOL_DEFAULT_CACHE_LIMIT (size_t(1) << 30)
+
+///////////////////////////////////////////////////////////////////////////////
+// CBufferPool
+
+CBufferPool* CBufferPool::s_pActive = nullptr;
+
+CBufferPool::CBufferPool()
+	: m_CacheLimit(BUFFER_POOL_DEFAULT_CACHE_LIMIT), m_NumAcquisitions(0), m_NumHits(0), m_NumEvictions(0),
+	  m_AllocatedBytes(0), m_PeakBytes(0), m_CachedBytes(0), m_TotalRequestedBytes(0.0), m_TotalClassBytes(0.0)
+{
+}
+
+CBufferPool::~CBufferPool()
+{
+	if(s_pActive == this)
+		s_pActive = nullptr;
+	Clear();
+}
+
+size_t CBufferPool::GetSizeClass(size_t Size)
+{
+	if(Size <= MIN_CLASS_SIZE)
+		return MIN_CLASS_SIZE;
+
+	// four classes between two powers of two
+	size_t powerOfTwo = MIN_CLASS_SIZE;
+	while(powerOfTwo * 2 <= Size)
+		powerOfTwo *= 2;
+	size_t step = powerOfTwo / 4;
+	return (Size + step - 1) / step * step;
+}
+
+size_t CBufferPool::GetMaxAllocSize(cl_context Context)
+{
+	size_t numBytes = 0;
+	if(clGetContextInfo(Context, CL_CONTEXT_DEVICES, 0, NULL, &numBytes) != CL_SUCCESS || numBytes == 0)
+		return 0;
+	vector<cl_device_id> devices(numBytes / sizeof(cl_device_id));
+	if(clGetContextInfo(Context, CL_CONTEXT_DEVICES, numBytes, &devices[0], NULL) != CL_SUCCESS)
+		return 0;
+
+	// the smallest limit of all devices of the context
+	cl_ulong maxAllocSize = 0;
+	for(size_t i = 0; i < devices.size(); i++)
+	{
+		cl_ulong deviceMaxAllocSize = 0;
+		if(clGetDeviceInfo(devices[i], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &deviceMaxAllocSize, NULL) != CL_SUCCESS)
+			continue;
+		if(deviceMaxAllocSize > 0 && (maxAllocSize == 0 || deviceMaxAllocSize < maxAllocSize))
+			maxAllocSize = deviceMaxAllocSize;
+	}
+	return size_t(maxAllocSize);
+}
+
+cl_mem CBufferPool::Acquire(cl_context Context, cl_mem_flags Flags, size_t Size, cl_int* pError)
+{
+	if(pError) *pError = CL_SUCCESS;
+	if(Flags & (CL_MEM_COPY_HOST_PTR | CL_MEM_USE_HOST_PTR))
+	{
+		cerr<<"Error: pooled buffers cannot be created from host memory."<<endl;
+		if(pError) *pError = CL_INVALID_VALUE;
+		return nullptr;
+	}
+
+	SKey key;
+	key.Context = Context;
+	key.Flags = Flags;
+	key.ClassSize = GetSizeClass(Size);
+
+	map<SKey, vector<cl_mem> >::iterator it = m_Free.find(key);
+	if((it == m_Free.end() || it->second.empty()) && key.ClassSize > Size)
+	{
+		// a size class beyond CL_DEVICE_MAX_MEM_ALLOC_SIZE cannot be created, although the
+		// requested size can; such buffers are kept with their exact size as the class
+		size_t maxAllocSize = GetMaxAllocSize(Context);
+		if(maxAllocSize > 0 && key.ClassSize > maxAllocSize && Size <= maxAllocSize)
+		{
+			key.ClassSize = Size;
+			it = m_Free.find(key);
+		}
+	}
+
+	m_NumAcquisitions++;
+	m_TotalRequestedBytes += double(Size);
+	m_TotalClassBytes += double(key.ClassSize);
+
+	cl_mem buffer = nullptr;
+	if(it != m_Free.end() && !it->second.empty())
+	{
+		buffer = it->second.back();
+		it->second.pop_back();
+		m_CachedBytes -= key.ClassSize;
+		m_NumHits++;
+	}
+	else
+	{
+		cl_int clError;
+		buffer = clCreateBuffer(Context, Flags, key.ClassSize, NULL, &clError);
+		if(clError != CL_SUCCESS && m_CachedBytes > 0)
+		{
+			// the device may be out of memory because of the cache, try once more without it
+			Clear();
+			buffer = clCreateBuffer(Context, Flags, key.ClassSize, NULL, &clError);
+		}
+		if(pError) *pError = clError;
+		if(clError != CL_SUCCESS)
+			return nullptr;
+
+		m_AllocatedBytes += key.ClassSize;
+		m_PeakBytes = max(m_PeakBytes, m_AllocatedBytes);
+	}
+
+	SInUse& inUse = m_InUse[buffer];
+	inUse.Key = key;
+	inUse.RequestedSize = Size;
+	return buffer;
+}
+
+void CBufferPool::Return(cl_mem& Buffer)
+{
+	if(Buffer == nullptr)
+		return;
+
+	map<cl_mem, SInUse>::iterator it = m_InUse.find(Buffer);
+	if(it == m_InUse.end())
+	{
+		// not ours
+		clReleaseMemObject(Buffer);
+		Buffer = nullptr;
+		return;
+	}
+
+	SKey key = it->second.Key;
+	m_InUse.erase(it);
+
+	if(m_CachedBytes + key.ClassSize > m_CacheLimit)
+	{
+		clReleaseMemObject(Buffer);
+		m_AllocatedBytes -= key.ClassSize;
+		m_NumEvictions++;
+	}
+	else
+	{
+		m_Free[key].push_back(Buffer);
+		m_CachedBytes += key.ClassSize;
+	}
+	Buffer = nullptr;
+}
+
+void CBufferPool::Clear()
+{
+	for(map<SKey, vector<cl_mem> >::iterator it = m_Free.begin(); it != m_Free.end(); ++it)
+	{
+		for(size_t i = 0; i < it->second.size(); i++)
+			clReleaseMemObject(it->second[i]);
+		m_AllocatedBytes -= it->first.ClassSize * it->second.size();
+	}
+	m_Free.clear();
+	m_CachedBytes = 0;
+}
+
+void CBufferPool::PrintStatistics(std::ostream& Stream) const
+{
+	double hitRate = m_NumAcquisitions > 0 ? 100.0 * double(m_NumHits) / double(m_NumAcquisitions) : 0.0;
+	double fragmentation = m_TotalClassBytes > 0.0 ? 100.0 * (1.0 - m_TotalRequestedBytes / m_TotalClassBytes) : 0.0;
+
+	Stream<<"Buffer pool: "<<m_NumAcquisitions<<" acquisitions, "<<m_NumHits<<" hits ("<<hitRate<<"%), "
+		<<m_NumEvictions<<" evictions"<<endl;
+	Stream<<"  peak allocated: "<<double(m_PeakBytes) / (1024 * 1024)<<" MB, currently cached: "
+		<<double(m_CachedBytes) / (1024 * 1024)<<" MB, lost to size classes: "<<fragmentation<<"%"<<endl;
+}
+
+CBufferPool* CBufferPool::GetActive()
+{
+	return s_pActive;
+}
+
+void CBufferPool::SetActive(CBufferPool* Pool)
+{
+	s_pActive = Pool;
+}
+
+cl_mem CBufferPool::AcquireBuffer(cl_context Context, cl_mem_flags Flags, size_t Size, cl_int* pError)
+{
+	if(s_pActive != nullptr)
+		return s_pActive->Acquire(Context, Flags, Size, pError);
+	return clCreateBuffer(Context, Flags, Size, NULL, pError);
+}
+
+void CBufferPool::ReturnBuffer(cl_mem& Buffer)
+{
+	if(s_pActive != nullptr)
+		s_pActive->Return(Buffer);
+	else
+		SAFE_RELEASE_MEMOBJECT(Buffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,130 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CBUFFER_POOL_H
+#define _CBUFFER_POOL_H
+
+#include "IComputeTask.h"
+
+#include <map>
+#include <vector>
+#include <iostream>
+
+//! Caching allocator for device buffers
+/*!
+	Creating a buffer can take milliseconds on some drivers, and the assignments create
+	fresh tasks (with identical allocations) for every configuration. Returned buffers are
+	kept and handed out again for a later request of the same context, flags and size class.
+
+	Requests are rounded up to size classes with four steps per power of two (at least
+	MIN_CLASS_SIZE bytes), so at most a quarter of a buffer is wasted. A request whose size
+	class exceeds CL_DEVICE_MAX_MEM_ALLOC_SIZE gets a buffer of exactly its size. Buffers from
+	the pool are not initialized and CL_MEM_COPY_HOST_PTR / CL_MEM_USE_HOST_PTR cannot be used.
+
+	CAssignmentBase owns a pool and makes it the active one while its context exists.
+	Tasks use the static AcquireBuffer() / ReturnBuffer(), which fall back to
+	clCreateBuffer() / clReleaseMemObject() if no pool is active.
+
+	NOTE: not thread-safe.
+*/
+class CBufferPool
+{
+public:
+	enum { MIN_CLASS_SIZE = 4096 };
+
+	CBufferPool();
+
+	~CBufferPool();
+
+	//! A buffer of at least Size bytes, nullptr on failure (the error is stored in pError)
+	cl_mem Acquire(cl_context Context, cl_mem_flags Flags, size_t Size, cl_int* pError = nullptr);
+
+	//! Gives the buffer back to the pool and sets Buffer to nullptr
+	void Return(cl_mem& Buffer);
+
+	//! Releases all cached buffers, buffers in use are released when they are returned
+	void Clear();
+
+	//! Cached buffers beyond this limit are released immediately when returned
+	void SetCacheLimit(size_t Bytes) { m_CacheLimit = Bytes; }
+
+	void PrintStatistics(std::ostream& Stream) const;
+
+	//! Hits, misses etc. since the creation of the pool
+	size_t GetNumAcquisitions() const { return m_NumAcquisitions; }
+	size_t GetNumHits() const { return m_NumHits; }
+	size_t GetPeakBytes() const { return m_PeakBytes; }
+
+	static size_t GetSizeClass(size_t Size);
+	//! The smallest CL_DEVICE_MAX_MEM_ALLOC_SIZE of the devices of the context, 0 if unknown
+	static size_t GetMaxAllocSize(cl_context Context);
+
+	//! The pool used by AcquireBuffer() / ReturnBuffer(), nullptr if there is none
+	static CBufferPool* GetActive();
+	static void SetActive(CBufferPool* Pool);
+
+	static cl_mem AcquireBuffer(cl_context Context, cl_mem_flags Flags, size_t Size, cl_int* pError = nullptr);
+	static void ReturnBuffer(cl_mem& Buffer);
+
+protected:
+	// the pool owns cl_mem objects, it cannot be copied
+	CBufferPool(const CBufferPool&);
+	CBufferPool& operator=(const CBufferPool&);
+
+	struct SKey
+	{
+		cl_context		Context;
+		cl_mem_flags	Flags;
+		size_t			ClassSize;
+
+		bool operator<(const SKey& Other) const
+		{
+			if(Context != Other.Context) return Context < Other.Context;
+			if(Flags != Other.Flags) return Flags < Other.Flags;
+			return ClassSize < Other.ClassSize;
+		}
+	};
+
+	struct SInUse
+	{
+		SKey			Key;
+		size_t			RequestedSize;
+	};
+
+	std::map<SKey, std::vector<cl_mem> >	m_Free;
+	std::map<cl_mem, SInUse>				m_InUse;
+
+	size_t				m_CacheLimit;
+
+	// statistics
+	size_t				m_NumAcquisitions;
+	size_t				m_NumHits;
+	size_t				m_NumEvictions;
+	//bytes allocated from the driver (in use + cached)
+	size_t				m_AllocatedBytes;
+	size_t				m_PeakBytes;
+	size_t				m_CachedBytes;
+	//sum over all acquisitions, the difference is lost to the rounding to size classes
+	double				m_TotalRequestedBytes;
+	double				m_TotalClassBytes;
+
+	static CBufferPool*	s_pActive;
+};
+
+#endif // _CBUFFER_POOL_H
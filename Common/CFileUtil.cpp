@@ -0,0 +1,115 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CFileUtil.h"
+
+#include <algorithm>
+#include <cctype>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <direct.h>
+#else
+	#include <dirent.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+	#include <sys/types.h>
+#endif
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CFileUtil
+
+bool CFileUtil::IsDirectory(const std::string& Path)
+{
+	if(Path.empty())
+		return false;
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(Path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat st;
+	return stat(Path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+bool CFileUtil::MakeDirectory(const std::string& Path)
+{
+	if(IsDirectory(Path))
+		return true;
+#ifdef _WIN32
+	return _mkdir(Path.c_str()) == 0;
+#else
+	return mkdir(Path.c_str(), 0755) == 0 || (errno == EEXIST && IsDirectory(Path));
+#endif
+}
+
+bool CFileUtil::ListFiles(const std::string& Directory, const std::string& Extension, std::vector<std::string>& Files)
+{
+	auto hasExtension = [&Extension](const string& Name) {
+		if(Name.size() <= Extension.size())
+			return false;
+		for(size_t i = 0; i < Extension.size(); i++)
+			if(tolower((unsigned char)Name[Name.size() - Extension.size() + i]) != tolower((unsigned char)Extension[i]))
+				return false;
+		return true;
+	};
+
+	vector<string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(JoinPath(Directory, "*").c_str(), &data);
+	if(find == INVALID_HANDLE_VALUE)
+		return false;
+	do
+	{
+		if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 && hasExtension(data.cFileName))
+			names.push_back(data.cFileName);
+	} while(FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(Directory.c_str());
+	if(dir == nullptr)
+		return false;
+	while(struct dirent* entry = readdir(dir))
+	{
+		string name = entry->d_name;
+		struct stat st;
+		if(hasExtension(name) && stat(JoinPath(Directory, name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+			names.push_back(name);
+	}
+	closedir(dir);
+#endif
+
+	// the order of the directory entries is arbitrary
+	sort(names.begin(), names.end());
+	Files.clear();
+	for(size_t i = 0; i < names.size(); i++)
+		Files.push_back(JoinPath(Directory, names[i]));
+	return true;
+}
+
+std::string CFileUtil::JoinPath(const std::string& Directory, const std::string& Name)
+{
+	if(Directory.empty())
+		return Name;
+	char last = Directory[Directory.size() - 1];
+	if(last == '/' || last == '\\')
+		return Directory + Name;
+	return Directory + "/" + Name;
+}
+
+std::string CFileUtil::GetStem(const std::string& Path)
+{
+	size_t start = Path.find_last_of("/\\");
+	start = start == string::npos ? 0 : start + 1;
+	size_t end = Path.rfind('.');
+	if(end == string::npos || end < start)
+		end = Path.size();
+	return Path.substr(start, end - start);
+}
+
+///////////////////////////////////////////////////////////////////////////////
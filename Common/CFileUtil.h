@@ -17,45 +17,35 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
-#ifndef _ICOMPUTE_TASK_H
-#define _ICOMPUTE_TASK_H
-
-// All OpenCL headers
-#if defined(WIN32)
-    #include <CL/opencl.h>
-#elif defined (__APPLE__) || defined(MACOSX)
-    #include <OpenCL/opencl.h>
-#else
-    #include <CL/cl.h>
-#endif 
-
-#include "CommonDefs.h"
-
-//! Common interface for the tasks within the assignment.
-/*!
-	Inherit a new class for each computing task.
-	(There are usually more tasks in each assignment).
-*/
-class IComputeTask
+
+#ifndef _CFILE_UTIL_H
+#define _CFILE_UTIL_H
+
+#include <string>
+#include <vector>
+
+//! Portable helpers for the files and directories of batch runs
+class CFileUtil
 {
 public:
+	//! True if Path exists and is a directory
+	static bool IsDirectory(const std::string& Path);
 
-	virtual ~IComputeTask() {};
-	
-	//! Init any resources specific to the current task
-	virtual bool InitResources(cl_device_id Device, cl_context Context) = 0;
-
-	//! Release everything allocated in InitResources()
-	virtual void ReleaseResources() = 0;
+	//! Creates the directory Path if it does not exist yet (not its parents)
+	static bool MakeDirectory(const std::string& Path);
 
-	//! Perform calculations on the GPU
-	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]) = 0;
+	//! Lists the regular files of Directory whose names end with Extension (e.g. ".pfm", case insensitive)
+	/*!
+		Files receives the paths (Directory + "/" + name) sorted by name, subdirectories are
+		not searched. Returns false if the directory could not be read.
+	*/
+	static bool ListFiles(const std::string& Directory, const std::string& Extension, std::vector<std::string>& Files);
 
-	//! Compute the "golden" solution on the CPU. The GPU results must be equal to this reference
-	virtual void ComputeCPU() = 0;
+	//! Directory + "/" + Name, without doubling a trailing separator of Directory
+	static std::string JoinPath(const std::string& Directory, const std::string& Name);
 
-	//! Compare the GPU solution to the "golden" solution
-	virtual bool ValidateResults() = 0;
+	//! The file name of Path without the directory and the extension, e.g. "frame01" for "Images/frame01.pfm"
+	static std::string GetStem(const std::string& Path);
 };
 
-#endif // _ICOMPUTE_TASK_H
+#endif // _CFILE_UTIL_H
@@ -0,0 +1,151 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CHostBuffer.h"
+
+#include "CLUtil.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+// CL_MEM_USE_HOST_PTR is only zero-copy if the host memory is aligned to a page
+// (and the size is a multiple of a cache line), otherwise the runtime may copy anyway
+#define HOST_BUFFER_ALIGNMENT 4096
+#define HOST_BUFFER_SIZE_GRANULARITY 64
+
+namespace
+{
+	void* AlignedAlloc(size_t Alignment, size_t Size)
+	{
+#ifdef _WIN32
+		return _aligned_malloc(Size, Alignment);
+#else
+		void* p = nullptr;
+		return posix_memalign(&p, Alignment, Size) == 0 ? p : nullptr;
+#endif
+	}
+
+	void AlignedFree(void* p)
+	{
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CHostBuffer
+
+CHostBuffer::CHostBuffer()
+	: m_Size(0), m_pHostMemory(nullptr), m_pMapped(nullptr), m_MappedQueue(nullptr), m_CanInvalidate(false)
+{
+}
+
+CHostBuffer::~CHostBuffer()
+{
+	Release();
+}
+
+bool CHostBuffer::Create(cl_device_id Device, cl_context Context, cl_mem_flags Flags, size_t Size)
+{
+	Release();
+
+	cl_bool unifiedMemory = CL_FALSE;
+	clGetDeviceInfo(Device, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &unifiedMemory, NULL);
+
+	// "OpenCL <major>.<minor> <vendor specific>"
+	char version[256] = "";
+	clGetDeviceInfo(Device, CL_DEVICE_VERSION, sizeof(version) - 1, version, NULL);
+	int major = 0, minor = 0;
+	m_CanInvalidate = sscanf(version, "OpenCL %d.%d", &major, &minor) == 2 && (major > 1 || (major == 1 && minor >= 2));
+
+	cl_int clError;
+	if(unifiedMemory)
+	{
+		cl_uint baseAddressAlign = 0;
+		clGetDeviceInfo(Device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &baseAddressAlign, NULL);
+		size_t alignment = max<size_t>(HOST_BUFFER_ALIGNMENT, baseAddressAlign / 8);
+		size_t allocationSize = (Size + HOST_BUFFER_SIZE_GRANULARITY - 1) / HOST_BUFFER_SIZE_GRANULARITY * HOST_BUFFER_SIZE_GRANULARITY;
+
+		m_pHostMemory = AlignedAlloc(alignment, allocationSize);
+		if(m_pHostMemory == nullptr)
+		{
+			cerr<<"Failed to allocate "<<allocationSize<<" bytes of aligned host memory."<<endl;
+			return false;
+		}
+		m_Mem.Reset(clCreateBuffer(Context, Flags | CL_MEM_USE_HOST_PTR, allocationSize, m_pHostMemory, &clError));
+	}
+	else
+		m_Mem.Reset(clCreateBuffer(Context, Flags | CL_MEM_ALLOC_HOST_PTR, Size, NULL, &clError));
+
+	if(clError != CL_SUCCESS)
+		Release();
+	V_RETURN_FALSE_CL(clError, "Failed to create a host-visible buffer");
+
+	m_Size = Size;
+	return true;
+}
+
+void CHostBuffer::Release()
+{
+	if(m_pMapped != nullptr)
+	{
+		Unmap();
+		clFinish(m_MappedQueue);
+	}
+	m_Mem.Reset();
+	// the host memory must outlive the buffer object using it
+	if(m_pHostMemory != nullptr)
+	{
+		AlignedFree(m_pHostMemory);
+		m_pHostMemory = nullptr;
+	}
+	m_Size = 0;
+}
+
+void* CHostBuffer::Map(cl_command_queue CommandQueue, cl_map_flags Flags)
+{
+	if(m_pMapped != nullptr && !Unmap())
+		return nullptr;
+
+	cl_int clError;
+	void* p = clEnqueueMapBuffer(CommandQueue, m_Mem, CL_TRUE, Flags, 0, m_Size, 0, NULL, NULL, &clError);
+	V_RETURN_0_CL(clError, "Failed to map a host-visible buffer");
+
+	m_pMapped = p;
+	m_MappedQueue = CommandQueue;
+	return p;
+}
+
+void* CHostBuffer::MapForOverwrite(cl_command_queue CommandQueue)
+{
+#ifdef CL_MAP_WRITE_INVALIDATE_REGION
+	if(m_CanInvalidate)
+		return Map(CommandQueue, CL_MAP_WRITE_INVALIDATE_REGION);
+#endif
+	return Map(CommandQueue, CL_MAP_WRITE);
+}
+
+bool CHostBuffer::Unmap()
+{
+	if(m_pMapped == nullptr)
+		return true;
+
+	cl_int clError = clEnqueueUnmapMemObject(m_MappedQueue, m_Mem, m_pMapped, 0, NULL, NULL);
+	m_pMapped = nullptr;
+	V_RETURN_FALSE_CL(clError, "Failed to unmap a host-visible buffer");
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
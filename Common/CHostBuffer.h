@@ -0,0 +1,98 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CHOST_BUFFER_H
+#define _CHOST_BUFFER_H
+
+#include "IComputeTask.h"
+#include "CLHandles.h"
+
+//! A device buffer whose host side is accessed by mapping instead of copying
+/*!
+	On devices which share the memory with the host (CPU runtimes, most integrated GPUs)
+	the buffer is created with CL_MEM_USE_HOST_PTR over a page-aligned host allocation,
+	so mapping and unmapping do not move any data (zero-copy).
+	On other devices it is created with CL_MEM_ALLOC_HOST_PTR, which lets the driver back
+	the host side with pinned memory, so map and unmap are DMA transfers without an
+	additional staging copy.
+
+	Typical use:
+
+		int* p = (int*)buffer.MapForOverwrite(CommandQueue);
+		// fill all of p
+		buffer.Unmap();
+		// enqueue kernels using buffer.GetMem()
+		const int* result = (const int*)buffer.Map(CommandQueue, CL_MAP_READ);
+
+	A buffer which is still mapped is unmapped by Release().
+*/
+class CHostBuffer
+{
+public:
+	CHostBuffer();
+
+	~CHostBuffer();
+
+	//! Allocates Size bytes, Flags are the device access flags (e.g. CL_MEM_READ_ONLY)
+	bool Create(cl_device_id Device, cl_context Context, cl_mem_flags Flags, size_t Size);
+
+	void Release();
+
+	//! Maps the whole buffer (blocking), returns nullptr on failure
+	void* Map(cl_command_queue CommandQueue, cl_map_flags Flags);
+
+	//! Maps the whole buffer for writing only, the previous contents are undefined
+	/*!
+		Uses CL_MAP_WRITE_INVALIDATE_REGION on OpenCL 1.2 devices, so a device with its own
+		memory does not copy the old contents to the host first. Older devices fall back
+		to CL_MAP_WRITE.
+	*/
+	void* MapForOverwrite(cl_command_queue CommandQueue);
+
+	//! Unmaps the buffer on the queue it was mapped with (non-blocking)
+	bool Unmap();
+
+	//! The buffer object, e.g. for clSetKernelArg(Kernel, i, sizeof(cl_mem), buffer.GetMemPtr())
+	cl_mem GetMem() const { return m_Mem; }
+	const cl_mem* GetMemPtr() const { return m_Mem.GetAddressOf(); }
+
+	//! The pointer returned by Map(), nullptr while not mapped
+	void* GetMappedPtr() const { return m_pMapped; }
+
+	size_t GetSize() const { return m_Size; }
+
+	//! True if the host and the device work on the same memory
+	bool IsZeroCopy() const { return m_pHostMemory != nullptr; }
+
+protected:
+	// the buffer owns a cl_mem and possibly host memory, it cannot be copied
+	CHostBuffer(const CHostBuffer&);
+	CHostBuffer& operator=(const CHostBuffer&);
+
+	CLMem				m_Mem;
+	size_t				m_Size;
+	//aligned allocation backing the buffer in zero-copy mode
+	void*				m_pHostMemory;
+	void*				m_pMapped;
+	cl_command_queue	m_MappedQueue;
+	//the device supports CL_MAP_WRITE_INVALIDATE_REGION (OpenCL 1.2)
+	bool				m_CanInvalidate;
+};
+
+#endif // _CHOST_BUFFER_H
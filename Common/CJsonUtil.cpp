@@ -0,0 +1,34 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CJsonUtil.h"
+
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CJsonUtil
+
+string CJsonUtil::QuoteString(const string& Text)
+{
+	stringstream ss;
+	ss << '"';
+	for(size_t i = 0; i < Text.size(); i++)
+	{
+		unsigned char c = (unsigned char)Text[i];
+		if(c == '"' || c == '\\')
+			ss << '\\' << c;
+		else if(c < 0x20 || c >= 0x80)
+			ss << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+		else
+			ss << c;
+	}
+	ss << '"';
+	return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -17,3 +17,23 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
+
+#ifndef _CJSON_UTIL_H
+#define _CJSON_UTIL_H
+
+#include <string>
+
+//! Helpers for the JSON files written by CBenchmarkReport and CTraceRecorder
+class CJsonUtil
+{
+public:
+	//! Text as a quoted JSON string
+	/*!
+		Quotes and backslashes are escaped, control characters and all non-ASCII bytes are
+		written as \u00XX, so the output is plain ASCII (the reader of CBenchmarkReport
+		relies on this).
+	*/
+	static std::string QuoteString(const std::string& Text);
+};
+
+#endif // _CJSON_UTIL_H
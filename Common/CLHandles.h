@@ -0,0 +1,284 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CL_HANDLES_H
+#define _CL_HANDLES_H
+
+#include "IComputeTask.h"
+#include "CLUtil.h"
+#include "CBufferPool.h"
+#include "CTraceRecorder.h"
+
+#include <utility>
+#include <vector>
+#include <cstring>
+
+//! Owning handle of an OpenCL object, released when the handle is destroyed or reset
+/*!
+	Handles can be moved but not copied, so every object has exactly one owner.
+	They convert implicitly to the raw type, so they can be passed to the OpenCL API directly:
+
+		CLKernel kernel(clCreateKernel(program, "Name", &clError));
+		clSetKernelArg(kernel, 0, sizeof(cl_mem), buffer.GetAddressOf());
+		clEnqueueNDRangeKernel(queue, kernel, ...);
+*/
+template<typename T, cl_int (CL_API_CALL *ReleaseFunction)(T)>
+class CLHandle
+{
+public:
+	CLHandle() : m_Handle(nullptr) {}
+
+	//! Takes ownership of Handle
+	explicit CLHandle(T Handle) : m_Handle(Handle) {}
+
+	~CLHandle() { Reset(); }
+
+	CLHandle(CLHandle&& Other) : m_Handle(Other.m_Handle) { Other.m_Handle = nullptr; }
+
+	CLHandle& operator=(CLHandle&& Other)
+	{
+		if(this != &Other)
+		{
+			Reset(Other.m_Handle);
+			Other.m_Handle = nullptr;
+		}
+		return *this;
+	}
+
+	CLHandle(const CLHandle&) = delete;
+	CLHandle& operator=(const CLHandle&) = delete;
+
+	//! Releases the current object and takes ownership of Handle
+	void Reset(T Handle = nullptr)
+	{
+		if(m_Handle != nullptr && m_Handle != Handle)
+			ReleaseFunction(m_Handle);
+		m_Handle = Handle;
+	}
+
+	//! Gives up the ownership without releasing the object
+	T Detach()
+	{
+		T handle = m_Handle;
+		m_Handle = nullptr;
+		return handle;
+	}
+
+	T Get() const { return m_Handle; }
+
+	operator T() const { return m_Handle; }
+
+	//! For kernel arguments and wait lists
+	const T* GetAddressOf() const { return &m_Handle; }
+
+	//! For functions returning a new object through a pointer (e.g. the event of clEnqueue*)
+	T* Receive()
+	{
+		Reset();
+		return &m_Handle;
+	}
+
+private:
+	T		m_Handle;
+};
+
+typedef CLHandle<cl_mem, clReleaseMemObject>				CLMem;
+typedef CLHandle<cl_program, clReleaseProgram>				CLProgram;
+typedef CLHandle<cl_event, clReleaseEvent>					CLEvent;
+typedef CLHandle<cl_command_queue, clReleaseCommandQueue>	CLCommandQueue;
+typedef CLHandle<cl_context, clReleaseContext>				CLContext;
+
+//! Kernel handle which remembers the values of its arguments
+/*!
+	SetArg() skips the clSetKernelArg call if the argument already has exactly the same value,
+	which is what most launch loops do for all but one or two arguments. The cache is only
+	correct if every argument of the kernel is set through SetArg() (or the SetArgs() helpers
+	in CLKernelArgs.h); call InvalidateArgs() after setting arguments with clSetKernelArg directly.
+*/
+class CLKernel : public CLHandle<cl_kernel, clReleaseKernel>
+{
+public:
+	CLKernel() {}
+
+	//! Takes ownership of Kernel
+	explicit CLKernel(cl_kernel Kernel) : CLHandle(Kernel) {}
+
+	CLKernel(CLKernel&& Other) : CLHandle(std::move(Other)), m_Args(std::move(Other.m_Args)) {}
+
+	CLKernel& operator=(CLKernel&& Other)
+	{
+		CLHandle::operator=(std::move(Other));
+		m_Args = std::move(Other.m_Args);
+		return *this;
+	}
+
+	void Reset(cl_kernel Kernel = nullptr)
+	{
+		m_Args.clear();
+		CLHandle::Reset(Kernel);
+	}
+
+	cl_kernel Detach()
+	{
+		m_Args.clear();
+		return CLHandle::Detach();
+	}
+
+	cl_kernel* Receive()
+	{
+		m_Args.clear();
+		return CLHandle::Receive();
+	}
+
+	//! Sets argument Index, unless it already has this value. A null pValue is a local memory argument of Size bytes.
+	cl_int SetArg(cl_uint Index, size_t Size, const void* pValue)
+	{
+		if(Index >= m_Args.size())
+			m_Args.resize(Index + 1);
+
+		SArgValue& arg = m_Args[Index];
+		bool isLocal = pValue == nullptr;
+		if(arg.Valid && arg.Size == Size && arg.IsLocal == isLocal &&
+			(isLocal || memcmp(arg.Bytes.data(), pValue, Size) == 0))
+			return CL_SUCCESS;
+
+		cl_int clError = clSetKernelArg(Get(), Index, Size, pValue);
+		arg.Valid = clError == CL_SUCCESS;
+		arg.Size = Size;
+		arg.IsLocal = isLocal;
+		if(isLocal)
+			arg.Bytes.clear();
+		else
+			arg.Bytes.assign((const unsigned char*)pValue, (const unsigned char*)pValue + Size);
+		return clError;
+	}
+
+	//! Forgets the cached argument values, so the next SetArg() calls reach the driver again
+	void InvalidateArgs() { m_Args.clear(); }
+
+private:
+	struct SArgValue
+	{
+		SArgValue() : Valid(false), IsLocal(false), Size(0) {}
+
+		bool						Valid;
+		bool						IsLocal;
+		size_t						Size;
+		std::vector<unsigned char>	Bytes;
+	};
+
+	std::vector<SArgValue>	m_Args;
+};
+
+//! Typed device buffer which knows its number of elements
+/*!
+	Uninitialized buffers come from the active CBufferPool, so repeated allocations of
+	the same size are cheap. The buffer goes back to the pool when it is released.
+*/
+template<typename T>
+class DeviceBuffer
+{
+public:
+	DeviceBuffer() : m_Mem(nullptr), m_Count(0) {}
+
+	~DeviceBuffer() { Release(); }
+
+	DeviceBuffer(DeviceBuffer&& Other) : m_Mem(Other.m_Mem), m_Count(Other.m_Count)
+	{
+		Other.m_Mem = nullptr;
+		Other.m_Count = 0;
+	}
+
+	DeviceBuffer& operator=(DeviceBuffer&& Other)
+	{
+		if(this != &Other)
+		{
+			Release();
+			std::swap(m_Mem, Other.m_Mem);
+			std::swap(m_Count, Other.m_Count);
+		}
+		return *this;
+	}
+
+	DeviceBuffer(const DeviceBuffer&) = delete;
+	DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+
+	//! Allocates Count elements, initialized with pHostData if it is given
+	bool Create(cl_context Context, cl_mem_flags Flags, size_t Count, const T* pHostData = nullptr)
+	{
+		Release();
+		cl_int clError;
+		if(pHostData != nullptr)
+			m_Mem = clCreateBuffer(Context, Flags | CL_MEM_COPY_HOST_PTR, Count * sizeof(T), (void*)pHostData, &clError);
+		else
+			m_Mem = CBufferPool::AcquireBuffer(Context, Flags, Count * sizeof(T), &clError);
+		V_RETURN_FALSE_CL(clError, "Error allocating a device buffer");
+		m_Count = Count;
+		return true;
+	}
+
+	void Release()
+	{
+		CBufferPool::ReturnBuffer(m_Mem);
+		m_Count = 0;
+	}
+
+	//! Copies Count elements from the host to the elements [Offset, Offset + Count)
+	bool Write(cl_command_queue CommandQueue, const T* pData, size_t Count, size_t Offset = 0, cl_bool Blocking = CL_FALSE,
+		cl_event* pEvent = nullptr)
+	{
+		CLEvent event;
+		V_RETURN_FALSE_CL(clEnqueueWriteBuffer(CommandQueue, m_Mem, Blocking, Offset * sizeof(T), Count * sizeof(T), pData, 0, NULL,
+			TraceEvent(pEvent, event)), "Error copying data from host to device!");
+		CTraceRecorder::TraceDeviceEvent("upload", "transfer", pEvent != nullptr ? *pEvent : event);
+		return true;
+	}
+
+	//! Copies the elements [Offset, Offset + Count) to the host
+	bool Read(cl_command_queue CommandQueue, T* pData, size_t Count, size_t Offset = 0, cl_bool Blocking = CL_TRUE,
+		cl_event* pEvent = nullptr)
+	{
+		CLEvent event;
+		V_RETURN_FALSE_CL(clEnqueueReadBuffer(CommandQueue, m_Mem, Blocking, Offset * sizeof(T), Count * sizeof(T), pData, 0, NULL,
+			TraceEvent(pEvent, event)), "Error reading data from device!");
+		CTraceRecorder::TraceDeviceEvent("readback", "transfer", pEvent != nullptr ? *pEvent : event);
+		return true;
+	}
+
+	size_t GetCount() const { return m_Count; }
+	size_t GetBytes() const { return m_Count * sizeof(T); }
+
+	cl_mem Get() const { return m_Mem; }
+	operator cl_mem() const { return m_Mem; }
+	const cl_mem* GetAddressOf() const { return &m_Mem; }
+
+private:
+	//! The event the caller asked for, or the local Event if the transfer only has to appear on the timeline
+	static cl_event* TraceEvent(cl_event* pEvent, CLEvent& Event)
+	{
+		if(pEvent != nullptr || !CTraceRecorder::IsTracing())
+			return pEvent;
+		return Event.Receive();
+	}
+
+	cl_mem		m_Mem;
+	size_t		m_Count;
+};
+
+#endif // _CL_HANDLES_H
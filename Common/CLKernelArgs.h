@@ -0,0 +1,128 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CL_KERNEL_ARGS_H
+#define _CL_KERNEL_ARGS_H
+
+#include "CLHandles.h"
+#include "CHostBuffer.h"
+
+#include <type_traits>
+
+//! Local memory kernel argument of Bytes bytes
+struct CLLocalMemory
+{
+	explicit CLLocalMemory(size_t Bytes) : Bytes(Bytes) {}
+
+	size_t		Bytes;
+};
+
+//! Variadic kernel argument binding
+/*!
+	The size of every argument is deduced from its type, so a cl_uint can no longer be passed
+	with sizeof(size_t) or a buffer with sizeof(cl_mem*):
+
+		SetArgs(m_Kernel, m_dInput, m_dOutput, CLLocalMemory(sizeof(cl_uint) * lwSize), cl_uint(m_N));
+		SetArgsFrom(m_Kernel, 3, offset);
+		Launch(queue, m_Kernel, 1, &gwSize, &lwSize, m_dInput, m_dOutput, ...);
+
+	Arguments are plain values, DeviceBuffer, CHostBuffer, CLHandle (e.g. CLMem) or CLLocalMemory.
+	With a CLKernel, arguments which did not change since the last call are not set again.
+	Raw cl_kernel handles work as well, but every argument is passed to the driver.
+*/
+namespace CLKernelArgs
+{
+	inline cl_int SetRaw(CLKernel& Kernel, cl_uint Index, size_t Size, const void* pValue)
+	{
+		return Kernel.SetArg(Index, Size, pValue);
+	}
+
+	inline cl_int SetRaw(cl_kernel Kernel, cl_uint Index, size_t Size, const void* pValue)
+	{
+		return clSetKernelArg(Kernel, Index, Size, pValue);
+	}
+
+	template<typename K, typename T>
+	cl_int Set(K& Kernel, cl_uint Index, const T& Value)
+	{
+		static_assert(!std::is_pointer<T>::value, "pass kernel arguments by value, not by address");
+		static_assert(std::is_trivially_copyable<T>::value, "kernel arguments must be trivially copyable");
+		return SetRaw(Kernel, Index, sizeof(T), &Value);
+	}
+
+	template<typename K, typename T>
+	cl_int Set(K& Kernel, cl_uint Index, const DeviceBuffer<T>& Buffer)
+	{
+		return SetRaw(Kernel, Index, sizeof(cl_mem), Buffer.GetAddressOf());
+	}
+
+	template<typename K, typename T, cl_int (CL_API_CALL *ReleaseFunction)(T)>
+	cl_int Set(K& Kernel, cl_uint Index, const CLHandle<T, ReleaseFunction>& Handle)
+	{
+		return SetRaw(Kernel, Index, sizeof(T), Handle.GetAddressOf());
+	}
+
+	template<typename K>
+	cl_int Set(K& Kernel, cl_uint Index, const CHostBuffer& Buffer)
+	{
+		return SetRaw(Kernel, Index, sizeof(cl_mem), Buffer.GetMemPtr());
+	}
+
+	template<typename K>
+	cl_int Set(K& Kernel, cl_uint Index, const CLLocalMemory& Local)
+	{
+		return SetRaw(Kernel, Index, Local.Bytes, nullptr);
+	}
+}
+
+//! Sets the arguments FirstIndex, FirstIndex + 1, ... of Kernel, stops at the first error
+template<typename K>
+cl_int SetArgsFrom(K&, cl_uint)
+{
+	return CL_SUCCESS;
+}
+
+template<typename K, typename A, typename... Rest>
+cl_int SetArgsFrom(K& Kernel, cl_uint FirstIndex, const A& Arg, const Rest&... Args)
+{
+	cl_int clError = CLKernelArgs::Set(Kernel, FirstIndex, Arg);
+	if(clError != CL_SUCCESS)
+		return clError;
+	return SetArgsFrom(Kernel, FirstIndex + 1, Args...);
+}
+
+//! Sets the arguments 0, 1, ... of Kernel
+template<typename K, typename... A>
+cl_int SetArgs(K& Kernel, const A&... Args)
+{
+	return SetArgsFrom(Kernel, 0, Args...);
+}
+
+//! Sets the arguments 0, 1, ... of Kernel and enqueues it on CommandQueue
+template<typename K, typename... A>
+cl_int Launch(cl_command_queue CommandQueue, K& Kernel, cl_uint Dimensions, const size_t* GlobalWorkSize, const size_t* LocalWorkSize,
+	const A&... Args)
+{
+	cl_int clError = SetArgs(Kernel, Args...);
+	if(clError != CL_SUCCESS)
+		return clError;
+	return clEnqueueNDRangeKernel(CommandQueue, Kernel, Dimensions, NULL, GlobalWorkSize, LocalWorkSize, 0, NULL, NULL);
+}
+
+#endif // _CL_KERNEL_ARGS_H
@@ -0,0 +1,520 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CLUtil.h"
+#include "CLHandles.h"
+#include "CTimer.h"
+#include "CTraceRecorder.h"
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CLUtil
+
+size_t CLUtil::GetGlobalWorkSize(size_t DataElemCount, size_t LocalWorkSize)
+{
+	size_t r = DataElemCount % LocalWorkSize;
+	if(r == 0)
+		return DataElemCount;
+	else
+		return DataElemCount + LocalWorkSize - r;
+}
+
+// embedded sources by file name and the override directory, created on first use because
+// the embedded sources are registered during static initialization
+static map<string, string>& GetEmbeddedSources()
+{
+	static map<string, string> sources;
+	return sources;
+}
+
+static string& GetProgramSourceDir()
+{
+	static string directory;
+	return directory;
+}
+
+static bool ReadSourceFile(const string& Path, string& SourceCode)
+{
+	ifstream sourceFile(Path.c_str(), ios::in | ios::binary);
+	if (!sourceFile.is_open())
+		return false;
+
+	// read the entire file into a string
+	sourceFile.seekg(0, ios::end);
+	ifstream::pos_type fileSize = sourceFile.tellg();
+	sourceFile.seekg(0, ios::beg);
+
+	SourceCode.clear();
+	SourceCode.resize((size_t)fileSize);
+	sourceFile.read(&SourceCode[0], fileSize);
+
+	return true;
+}
+
+bool CLUtil::LoadProgramSourceToMemory(const std::string& Path, std::string& SourceCode)
+{
+	CTraceScope scope(Path.c_str(), "io");
+
+	// '/' and '\\' both separate directories on Windows
+	size_t separator = Path.find_last_of("/\\");
+	string name = separator == string::npos ? Path : Path.substr(separator + 1);
+
+	const string& directory = GetProgramSourceDir();
+	if (!directory.empty() && ReadSourceFile(directory + "/" + name, SourceCode))
+		return true;
+
+	map<string, string>::const_iterator embedded = GetEmbeddedSources().find(name);
+	if (embedded != GetEmbeddedSources().end())
+	{
+		SourceCode = embedded->second;
+		return true;
+	}
+
+	if (!ReadSourceFile(Path, SourceCode))
+	{
+		cerr << "Failed to open file '" << Path << "'." << endl;
+		return false;
+	}
+	return true;
+}
+
+void CLUtil::RegisterProgramSource(const std::string& Name, const char* SourceCode, size_t Size)
+{
+	GetEmbeddedSources()[Name] = string(SourceCode, Size);
+}
+
+void CLUtil::SetProgramSourceDir(const std::string& Directory)
+{
+	GetProgramSourceDir() = Directory;
+}
+
+cl_program CLUtil::BuildCLProgramFromMemory(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions)
+{
+	cl_program prog = nullptr;
+
+
+		string srcSolution = SourceCode;
+
+	const char* src = srcSolution.c_str();
+	size_t length = srcSolution.size();
+
+	cl_int clError;
+	prog = clCreateProgramWithSource(Context, 1, &src, &length, &clError);
+	if(CL_SUCCESS != clError)
+	{
+		cerr<<"Failed to create CL program from source.";
+		return nullptr;
+	}
+
+	// program created, now build it:
+	CTraceScope scope("clBuildProgram", "build");
+	const char* pCompileOptions = CompileOptions.size() > 0 ? CompileOptions.c_str() : nullptr;
+	clError = clBuildProgram(prog, 1, &Device, pCompileOptions, NULL, NULL);
+	PrintBuildLog(prog, Device);
+	if(CL_SUCCESS != clError)
+	{
+		cerr<<"Failed to build CL program.";
+		SAFE_RELEASE_PROGRAM(prog);
+		return nullptr;
+	}
+
+
+	return prog;
+}
+
+namespace
+{
+	struct SProgramCacheKey
+	{
+		cl_device_id	Device;
+		cl_context		Context;
+		std::string		Source;
+
+		bool operator<(const SProgramCacheKey& Other) const
+		{
+			if(Device != Other.Device)
+				return Device < Other.Device;
+			if(Context != Other.Context)
+				return Context < Other.Context;
+			return Source < Other.Source;
+		}
+	};
+
+	// the cache owns the programs of its completed builds, failed builds stay as nullptr
+	std::map<SProgramCacheKey, std::shared_future<cl_program> > g_ProgramCache;
+	// builds may be requested from several threads
+	std::mutex g_ProgramCacheMutex;
+	// keeps the build logs of concurrent builds apart
+	std::mutex g_BuildLogMutex;
+
+	// the asynchronous builds wait in a queue for one of at most GetMaxBuildWorkers() workers
+	std::deque<std::packaged_task<cl_program()> > g_PendingBuilds;
+	std::vector<std::future<void> > g_BuildWorkers;
+	size_t g_NumActiveBuildWorkers = 0;
+	std::mutex g_BuildQueueMutex;
+
+	size_t GetMaxBuildWorkers()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//! Runs queued builds until the queue is empty
+	void RunBuildWorker()
+	{
+		for(;;)
+		{
+			std::packaged_task<cl_program()> build;
+			{
+				std::lock_guard<std::mutex> lock(g_BuildQueueMutex);
+				if(g_PendingBuilds.empty())
+				{
+					g_NumActiveBuildWorkers--;
+					return;
+				}
+				build = std::move(g_PendingBuilds.front());
+				g_PendingBuilds.pop_front();
+			}
+			build();
+		}
+	}
+
+	//! Queues Build and starts another worker if there are fewer than GetMaxBuildWorkers()
+	std::shared_future<cl_program> QueueBuild(std::packaged_task<cl_program()> Build)
+	{
+		std::shared_future<cl_program> result = Build.get_future().share();
+
+		std::lock_guard<std::mutex> lock(g_BuildQueueMutex);
+		g_PendingBuilds.push_back(std::move(Build));
+		if(g_NumActiveBuildWorkers < GetMaxBuildWorkers())
+		{
+			// the futures of finished workers can go, destroying them does not block
+			for(size_t i = g_BuildWorkers.size(); i-- > 0; )
+			{
+				if(g_BuildWorkers[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+					g_BuildWorkers.erase(g_BuildWorkers.begin() + i);
+			}
+			g_NumActiveBuildWorkers++;
+			g_BuildWorkers.push_back(std::async(std::launch::async, RunBuildWorker));
+		}
+		return result;
+	}
+
+	//! The cached build of the program, if there is none yet it is queued (Async) or deferred until it is needed
+	std::shared_future<cl_program> GetCachedBuild(cl_device_id Device, cl_context Context, const std::string& SourceCode,
+		const std::string& CompileOptions, bool Async)
+	{
+		SProgramCacheKey key;
+		key.Device = Device;
+		key.Context = Context;
+		key.Source = CompileOptions + "\n" + SourceCode;
+
+		std::lock_guard<std::mutex> lock(g_ProgramCacheMutex);
+		std::map<SProgramCacheKey, std::shared_future<cl_program> >::iterator it = g_ProgramCache.find(key);
+		if(it != g_ProgramCache.end())
+			return it->second;
+
+		auto buildProgram = [=]() {
+			return CLUtil::BuildCLProgramFromMemory(Device, Context, SourceCode, CompileOptions);
+		};
+		std::shared_future<cl_program> build = Async
+			? QueueBuild(std::packaged_task<cl_program()>(buildProgram))
+			: std::async(std::launch::deferred, buildProgram).share();
+		g_ProgramCache[key] = build;
+		return build;
+	}
+}
+
+cl_program CLUtil::BuildCachedCLProgram(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions)
+{
+	// a build which was not started asynchronously runs on this thread
+	cl_program prog = GetCachedBuild(Device, Context, SourceCode, CompileOptions, false).get();
+	if(prog == nullptr)
+		return nullptr;
+
+	// one reference for the cache, one for the caller
+	clRetainProgram(prog);
+	return prog;
+}
+
+std::shared_future<cl_program> CLUtil::BuildCachedCLProgramAsync(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions)
+{
+	return GetCachedBuild(Device, Context, SourceCode, CompileOptions, true);
+}
+
+void CLUtil::WaitForProgramBuilds()
+{
+	std::lock_guard<std::mutex> lock(g_ProgramCacheMutex);
+	std::map<SProgramCacheKey, std::shared_future<cl_program> >::iterator it;
+	for(it = g_ProgramCache.begin(); it != g_ProgramCache.end(); ++it)
+	{
+		if(it->second.wait_for(std::chrono::seconds(0)) != std::future_status::deferred)
+			it->second.wait();
+	}
+}
+
+void CLUtil::ReleaseProgramCache()
+{
+	std::lock_guard<std::mutex> lock(g_ProgramCacheMutex);
+	std::map<SProgramCacheKey, std::shared_future<cl_program> >::iterator it;
+	for(it = g_ProgramCache.begin(); it != g_ProgramCache.end(); ++it)
+	{
+		// a deferred build which nobody waited for has not been started
+		if(it->second.wait_for(std::chrono::seconds(0)) == std::future_status::deferred)
+			continue;
+		cl_program prog = it->second.get();
+		if(prog != nullptr)
+			clReleaseProgram(prog);
+	}
+	g_ProgramCache.clear();
+
+	// all builds are done, the workers have returned or are about to,
+	// their futures wait for them when destroyed (outside of the lock the workers need)
+	std::vector<std::future<void> > workers;
+	{
+		std::lock_guard<std::mutex> queueLock(g_BuildQueueMutex);
+		workers.swap(g_BuildWorkers);
+	}
+}
+
+cl_program CLUtil::BuildCLProgramForDevices(const std::vector<cl_device_id>& Devices, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions)
+{
+	const char* src = SourceCode.c_str();
+	size_t length = SourceCode.size();
+	cl_int clError;
+	cl_program prog = clCreateProgramWithSource(Context, 1, &src, &length, &clError);
+	if(CL_SUCCESS != clError)
+	{
+		cerr << "Failed to create CL program from source.";
+		return nullptr;
+	}
+
+	CTraceScope scope("clBuildProgram", "build");
+	const char* pCompileOptions = CompileOptions.size() > 0 ? CompileOptions.c_str() : nullptr;
+	clError = clBuildProgram(prog, cl_uint(Devices.size()), &Devices[0], pCompileOptions, NULL, NULL);
+	if(CL_SUCCESS != clError)
+	{
+		for(size_t i = 0; i < Devices.size(); i++)
+			PrintBuildLog(prog, Devices[i]);
+		cerr << "Failed to build CL program.";
+		SAFE_RELEASE_PROGRAM(prog);
+		return nullptr;
+	}
+
+	return prog;
+}
+
+std::vector<size_t> CLUtil::PartitionWork(size_t Total, const std::vector<double>& Weights, size_t Granularity)
+{
+	double sum = 0.0;
+	for(size_t i = 0; i < Weights.size(); i++)
+		sum += max(0.0, Weights[i]);
+
+	std::vector<size_t> offsets(Weights.size() + 1, 0);
+	double accumulated = 0.0;
+	for(size_t i = 0; i + 1 < Weights.size(); i++)
+	{
+		accumulated += max(0.0, Weights[i]);
+		// without any measurement, every device gets the same share
+		double fraction = sum > 0.0 ? accumulated / sum : double(i + 1) / double(Weights.size());
+		size_t offset = size_t(fraction * double(Total) + 0.5);
+		offset = min(Total, (offset + Granularity / 2) / Granularity * Granularity);
+		offsets[i + 1] = max(offsets[i], offset);
+	}
+	offsets[Weights.size()] = Total;
+
+	return offsets;
+}
+
+std::vector<double> CLUtil::MeasureDeviceThroughput(const std::vector<cl_command_queue>& CommandQueues, size_t Total, size_t Granularity,
+	const std::function<bool(size_t Device, size_t Begin, size_t End)>& Run)
+{
+	CTraceScope scope("MeasureDeviceThroughput", "multi-device");
+
+	size_t numDevices = CommandQueues.size();
+	std::vector<size_t> offsets = PartitionWork(Total, std::vector<double>(numDevices, 1.0), Granularity);
+	std::vector<double> throughput(numDevices, 0.0);
+
+	for(size_t i = 0; i < numDevices; i++)
+	{
+		size_t count = offsets[i + 1] - offsets[i];
+		if(count == 0)
+			continue;
+
+		// the first run includes one-time costs such as the kernel upload
+		if(!Run(i, offsets[i], offsets[i + 1]) || clFinish(CommandQueues[i]) != CL_SUCCESS)
+			return std::vector<double>();
+
+		CTimer timer;
+		timer.Start();
+		if(!Run(i, offsets[i], offsets[i + 1]) || clFinish(CommandQueues[i]) != CL_SUCCESS)
+			return std::vector<double>();
+		timer.Stop();
+
+		throughput[i] = double(count) / max(1.0e-3, timer.GetElapsedMilliseconds());
+	}
+
+	return throughput;
+}
+
+void CLUtil::PrintBuildLog(cl_program Program, cl_device_id Device)
+{
+	std::lock_guard<std::mutex> lock(g_BuildLogMutex);
+
+	cl_build_status buildStatus;
+	clGetProgramBuildInfo(Program, Device, CL_PROGRAM_BUILD_STATUS, sizeof(cl_build_status), &buildStatus, NULL);
+
+	// let's print out possible warnings even if the kernel compiled..
+	//if(buildStatus == CL_SUCCESS)
+	//	return;
+
+	//there were some errors.
+	size_t logSize;
+	clGetProgramBuildInfo(Program, Device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+	string buildLog(logSize, ' ');
+
+	clGetProgramBuildInfo(Program, Device, CL_PROGRAM_BUILD_LOG, logSize, &buildLog[0], NULL);
+	buildLog[logSize] = '\0';
+
+	if(buildStatus != CL_SUCCESS)
+		cout<<"There were build errors!"<<endl;
+	cout<<"Build log:"<<endl;
+	cout<<buildLog<<endl;
+}
+
+double CLUtil::ProfileKernel(cl_command_queue CommandQueue, cl_kernel Kernel, cl_uint Dimensions, 
+		const size_t* pGlobalWorkSize, const size_t* pLocalWorkSize, int NIterations,
+		CSamplingTimer* pSamples, unsigned int WarmupIterations)
+{
+	CTraceScope scope("ProfileKernel", "kernel");
+	CSamplingTimer samples(WarmupIterations);
+	cl_int clErr;
+
+	cl_command_queue_properties properties = 0;
+	clGetCommandQueueInfo(CommandQueue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, NULL);
+	bool profiling = (properties & CL_QUEUE_PROFILING_ENABLE) != 0;
+
+	// wait until the command queue is empty...
+	// Should not be used in production code, but this synchronizes HOST and DEVICE
+	clErr = clFinish(CommandQueue);
+
+	int nRuns = int(WarmupIterations) + NIterations;
+	if(profiling)
+	{
+		// the runs are enqueued back to back and timed on the device, so even short kernels
+		// are measured without the launch and synchronization overhead of the host
+		vector<CLEvent> events(nRuns);
+		for(int i = 0; i < nRuns; i++)
+			clErr |= clEnqueueNDRangeKernel(CommandQueue, Kernel, Dimensions, NULL, pGlobalWorkSize, pLocalWorkSize, 0, NULL, events[i].Receive());
+		clErr |= clFinish(CommandQueue);
+
+		for(int i = 0; i < nRuns && clErr == CL_SUCCESS; i++)
+		{
+			cl_ulong start = 0, end = 0;
+			clErr |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+			clErr |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+			samples.AddSample(1.0e-6 * double(end - start));
+		}
+
+		// every run appears on the timeline of the queue, under the name of the kernel
+		if(CTraceRecorder::IsTracing())
+		{
+			char kernelName[256] = "";
+			clGetKernelInfo(Kernel, CL_KERNEL_FUNCTION_NAME, sizeof(kernelName) - 1, kernelName, NULL);
+			for(int i = 0; i < nRuns; i++)
+				CTraceRecorder::TraceDeviceEvent(kernelName, i < int(WarmupIterations) ? "warmup" : "kernel", events[i]);
+		}
+	}
+	else
+	{
+		// without profiling every run has to be synchronized with the host
+		for(int i = 0; i < nRuns; i++)
+		{
+			samples.Start();
+			clErr |= clEnqueueNDRangeKernel(CommandQueue, Kernel, Dimensions, NULL, pGlobalWorkSize, pLocalWorkSize, 0, NULL, NULL);
+			clErr |= clFinish(CommandQueue);
+			samples.Stop();
+		}
+	}
+
+	if(clErr != CL_SUCCESS)
+	{
+		string errorString = GetCLErrorString(clErr);
+		cerr<<"Kernel execution failure: "<<errorString<<endl;
+	}
+
+	if(pSamples != nullptr)
+		*pSamples = samples;
+
+	return samples.GetMean();
+}
+
+#define CL_ERROR(x) case (x): return #x;
+
+const char* CLUtil::GetCLErrorString(cl_int CLErrorCode)
+{
+	switch(CLErrorCode)
+	{
+        CL_ERROR(CL_SUCCESS);
+        CL_ERROR(CL_DEVICE_NOT_FOUND);
+        CL_ERROR(CL_DEVICE_NOT_AVAILABLE);
+        CL_ERROR(CL_COMPILER_NOT_AVAILABLE);
+        CL_ERROR(CL_MEM_OBJECT_ALLOCATION_FAILURE);
+        CL_ERROR(CL_OUT_OF_RESOURCES);
+        CL_ERROR(CL_OUT_OF_HOST_MEMORY);
+        CL_ERROR(CL_PROFILING_INFO_NOT_AVAILABLE);
+        CL_ERROR(CL_MEM_COPY_OVERLAP);
+        CL_ERROR(CL_IMAGE_FORMAT_MISMATCH);
+        CL_ERROR(CL_IMAGE_FORMAT_NOT_SUPPORTED);
+        CL_ERROR(CL_BUILD_PROGRAM_FAILURE);
+        CL_ERROR(CL_MAP_FAILURE);
+        CL_ERROR(CL_INVALID_VALUE);
+        CL_ERROR(CL_INVALID_DEVICE_TYPE);
+        CL_ERROR(CL_INVALID_PLATFORM);
+        CL_ERROR(CL_INVALID_DEVICE);
+        CL_ERROR(CL_INVALID_CONTEXT);
+        CL_ERROR(CL_INVALID_QUEUE_PROPERTIES);
+        CL_ERROR(CL_INVALID_COMMAND_QUEUE);
+        CL_ERROR(CL_INVALID_HOST_PTR);
+        CL_ERROR(CL_INVALID_MEM_OBJECT);
+        CL_ERROR(CL_INVALID_IMAGE_FORMAT_DESCRIPTOR);
+        CL_ERROR(CL_INVALID_IMAGE_SIZE);
+        CL_ERROR(CL_INVALID_SAMPLER);
+        CL_ERROR(CL_INVALID_BINARY);
+        CL_ERROR(CL_INVALID_BUILD_OPTIONS);
+        CL_ERROR(CL_INVALID_PROGRAM);
+        CL_ERROR(CL_INVALID_PROGRAM_EXECUTABLE);
+        CL_ERROR(CL_INVALID_KERNEL_NAME);
+        CL_ERROR(CL_INVALID_KERNEL_DEFINITION);
+        CL_ERROR(CL_INVALID_KERNEL);
+        CL_ERROR(CL_INVALID_ARG_INDEX);
+        CL_ERROR(CL_INVALID_ARG_VALUE);
+        CL_ERROR(CL_INVALID_ARG_SIZE);
+        CL_ERROR(CL_INVALID_KERNEL_ARGS);
+        CL_ERROR(CL_INVALID_WORK_DIMENSION);
+        CL_ERROR(CL_INVALID_WORK_GROUP_SIZE);
+        CL_ERROR(CL_INVALID_WORK_ITEM_SIZE);
+        CL_ERROR(CL_INVALID_GLOBAL_OFFSET);
+        CL_ERROR(CL_INVALID_EVENT_WAIT_LIST);
+        CL_ERROR(CL_INVALID_EVENT);
+        CL_ERROR(CL_INVALID_OPERATION);
+        CL_ERROR(CL_INVALID_GL_OBJECT);
+        CL_ERROR(CL_INVALID_BUFFER_SIZE);
+        CL_ERROR(CL_INVALID_MIP_LEVEL);
+        default:
+			return "Unknown error code";
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,162 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef CL_UTIL_H
+#define CL_UTIL_H
+
+// All OpenCL headers
+#if defined(WIN32)
+    #include <CL/opencl.h>
+#elif defined (__APPLE__) || defined(MACOSX)
+    #include <OpenCL/opencl.h>
+#else
+    #include <CL/cl.h>
+#endif 
+
+#include "CommonDefs.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <functional>
+#include <future>
+
+class CSamplingTimer;
+
+//! Utility class for frequently-needed OpenCL tasks
+// TO DO: replace this with a nicer OpenCL wrapper
+class CLUtil
+{
+public:
+	//! Determines the OpenCL global work size given the number of data elements and threads per workgroup
+	static size_t GetGlobalWorkSize(size_t DataElemCount, size_t LocalWorkSize);
+
+	//! Loads a program source to memory as a string
+	/*!
+		Only the file name of Path is used to find the source: it is read from the directory
+		given with SetProgramSourceDir(), if there is one and the file exists in it, otherwise
+		the copy compiled into the executable (see cmake/EmbedKernels.cmake) is used. Sources
+		which were not embedded are read from Path itself.
+	*/
+	static bool LoadProgramSourceToMemory(const std::string& Path, std::string& SourceCode);
+
+	//! Makes a program source available to LoadProgramSourceToMemory() under the file name Name
+	static void RegisterProgramSource(const std::string& Name, const char* SourceCode, size_t Size);
+
+	//! Program sources in Directory take precedence over the embedded ones (empty to disable)
+	/*!
+		Kernels can be edited this way without rebuilding the executable.
+	*/
+	static void SetProgramSourceDir(const std::string& Directory);
+
+	//! Builds a CL program
+	static cl_program BuildCLProgramFromMemory(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
+
+	//! Builds a CL program only once per device, context, source and compile options
+	/*!
+		Generated kernels are often requested again with an identical source, so the built
+		programs are kept in a cache. The returned program holds its own reference and has
+		to be released by the caller as usual.
+	*/
+	static cl_program BuildCachedCLProgram(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
+
+	//! Starts BuildCachedCLProgram() on a worker thread and returns immediately
+	/*!
+		Several programs build concurrently this way (see IAsyncBuildComputeTask), at most
+		one per hardware thread, further builds wait in a queue. A later
+		BuildCachedCLProgram() with the same arguments waits for the running build instead
+		of starting another one. The future yields the program owned by the cache, nullptr
+		if the build failed.
+	*/
+	static std::shared_future<cl_program> BuildCachedCLProgramAsync(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
+
+	//! Waits until all builds started with BuildCachedCLProgramAsync() are finished
+	static void WaitForProgramBuilds();
+
+	//! Drops the references held by the program cache (call before releasing the context)
+	/*!
+		Waits for the builds which are still running.
+	*/
+	static void ReleaseProgramCache();
+
+	//! Builds a CL program for several devices of the same context
+	static cl_program BuildCLProgramForDevices(const std::vector<cl_device_id>& Devices, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
+
+	//! Splits Total work items into one consecutive range per device, proportional to Weights
+	/*!
+		Returns Weights.size() + 1 offsets, device i gets [offsets[i], offsets[i + 1]).
+		All offsets except the last one are multiples of Granularity.
+	*/
+	static std::vector<size_t> PartitionWork(size_t Total, const std::vector<double>& Weights, size_t Granularity = 1);
+
+	//! Measures the throughput (work items per millisecond) of every device
+	/*!
+		Run(i, Begin, End) has to enqueue the work items [Begin, End) on CommandQueues[i].
+		Each device gets an equal share and is timed on its own, after an untimed warm-up run.
+		Returns an empty vector if Run() fails.
+	*/
+	static std::vector<double> MeasureDeviceThroughput(const std::vector<cl_command_queue>& CommandQueues, size_t Total, size_t Granularity,
+		const std::function<bool(size_t Device, size_t Begin, size_t End)>& Run);
+
+	static void PrintBuildLog(cl_program Program, cl_device_id Device);
+
+	//! Measures the execution time of a kernel by executing it N times and returning the average time in milliseconds.
+	/*!
+		Each run is timed on its own, with cl_event profiling if the queue was created with
+		CL_QUEUE_PROFILING_ENABLE (as the queues of CAssignmentBase are), otherwise on the host.
+		The first WarmupIterations runs are not counted. pSamples receives the times of the
+		individual runs, e.g. for the median or the percentiles.
+	*/
+	static double ProfileKernel(cl_command_queue CommandQueue, cl_kernel Kernel, cl_uint Dimensions, 
+		const size_t* pGlobalWorkSize, const size_t* pLocalWorkSize, int NIterations,
+		CSamplingTimer* pSamples = nullptr, unsigned int WarmupIterations = 1);
+
+	static const char* GetCLErrorString(cl_int CLErrorCode);
+};
+
+//! Registers an embedded program source during static initialization
+/*!
+	The sources generated by embed_kernels() create one instance per .cl file.
+*/
+class CLEmbeddedSource
+{
+public:
+	CLEmbeddedSource(const char* Name, const unsigned char* SourceCode, size_t Size)
+	{
+		CLUtil::RegisterProgramSource(Name, reinterpret_cast<const char*>(SourceCode), Size);
+	}
+};
+
+// Some useful shortcuts for handling pointers and validating function calls
+#define V_RETURN_FALSE_CL(expr, errmsg) do {cl_int e=(expr);if(CL_SUCCESS!=e){std::cerr<<"Error: "<<errmsg<<" ["<<CLUtil::GetCLErrorString(e)<<"]"<<std::endl; return false; }} while(0)
+#define V_RETURN_0_CL(expr, errmsg) do {cl_int e=(expr);if(CL_SUCCESS!=e){std::cerr<<"Error: "<<errmsg<<" ["<<CLUtil::GetCLErrorString(e)<<"]"<<std::endl; return 0; }} while(0)
+#define V_RETURN_CL(expr, errmsg) do {cl_int e=(expr);if(CL_SUCCESS!=e){std::cerr<<"Error: "<<errmsg<<" ["<<CLUtil::GetCLErrorString(e)<<"]"<<std::endl; return; }} while(0)
+
+#define SAFE_DELETE(ptr) do {if(ptr){ delete ptr; ptr = NULL; }} while(0)
+#define SAFE_DELETE_ARRAY(x) do {if(x){delete [] x; x = NULL;}} while(0)
+
+#define SAFE_RELEASE_KERNEL(ptr)    do {if(ptr){ clReleaseKernel(ptr); ptr = NULL; }} while(0)
+#define SAFE_RELEASE_PROGRAM(ptr)   do {if(ptr){ clReleaseProgram(ptr); ptr = NULL; }} while(0)
+#define SAFE_RELEASE_MEMOBJECT(ptr) do {if(ptr){ clReleaseMemObject(ptr); ptr = NULL; }} while(0)
+#define SAFE_RELEASE_SAMPLER(ptr)   do {if(ptr){ clReleaseSampler(ptr); ptr = NULL; }} while(0)
+
+#define ARRAYLEN(a) (sizeof(a)/sizeof(a[0]))
+
+#endif // CL_UTIL_H
@@ -0,0 +1,168 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CTimer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+#ifndef _WIN32
+	#ifdef CLOCK_MONOTONIC_RAW
+		#define TIMER_CLOCK CLOCK_MONOTONIC_RAW
+	#else
+		#define TIMER_CLOCK CLOCK_MONOTONIC
+	#endif
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// CTimer
+
+void CTimer::Start()
+{
+#ifdef _WIN32
+	QueryPerformanceCounter(&m_StartTime);
+#else
+	clock_gettime(TIMER_CLOCK, &m_StartTime);
+#endif
+}
+
+void CTimer::Stop()
+{
+#ifdef _WIN32
+	QueryPerformanceCounter(&m_EndTime);
+#else
+	clock_gettime(TIMER_CLOCK, &m_EndTime);
+#endif
+}
+
+double CTimer::GetElapsedMilliseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq;
+	if(QueryPerformanceFrequency(&freq))
+	{
+		return 1000.0 * double(m_EndTime.QuadPart - m_StartTime.QuadPart) / double(freq.QuadPart);
+	}
+	else
+	{
+		return -1;
+	}
+#else
+	// the seconds are subtracted first, so the nanoseconds do not lose precision
+	double delta = double(m_EndTime.tv_sec - m_StartTime.tv_sec) +
+		1.0e-9 * double(m_EndTime.tv_nsec - m_StartTime.tv_nsec);
+	return 1000.0 * delta;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CSamplingTimer
+
+CSamplingTimer::CSamplingTimer(unsigned int WarmupIterations)
+	: m_WarmupIterations(WarmupIterations), m_NumDiscarded(0)
+{
+}
+
+void CSamplingTimer::Start()
+{
+	m_Timer.Start();
+}
+
+void CSamplingTimer::Stop()
+{
+	m_Timer.Stop();
+	AddSample(m_Timer.GetElapsedMilliseconds());
+}
+
+void CSamplingTimer::AddSample(double Milliseconds)
+{
+	if(m_NumDiscarded < m_WarmupIterations)
+		m_NumDiscarded++;
+	else
+		m_Samples.push_back(Milliseconds);
+}
+
+void CSamplingTimer::Accumulate(const CSamplingTimer& Other)
+{
+	if(m_Samples.empty())
+	{
+		m_Samples = Other.m_Samples;
+		return;
+	}
+
+	m_Samples.resize(min(m_Samples.size(), Other.m_Samples.size()));
+	for(size_t i = 0; i < m_Samples.size(); i++)
+		m_Samples[i] += Other.m_Samples[i];
+}
+
+void CSamplingTimer::Reset()
+{
+	m_NumDiscarded = 0;
+	m_Samples.clear();
+}
+
+double CSamplingTimer::GetMean() const
+{
+	if(m_Samples.empty())
+		return 0.0;
+
+	double sum = 0.0;
+	for(size_t i = 0; i < m_Samples.size(); i++)
+		sum += m_Samples[i];
+	return sum / double(m_Samples.size());
+}
+
+double CSamplingTimer::GetStdDev() const
+{
+	if(m_Samples.size() < 2)
+		return 0.0;
+
+	// sample standard deviation
+	double mean = GetMean();
+	double sum = 0.0;
+	for(size_t i = 0; i < m_Samples.size(); i++)
+		sum += (m_Samples[i] - mean) * (m_Samples[i] - mean);
+	return sqrt(sum / double(m_Samples.size() - 1));
+}
+
+double CSamplingTimer::GetMin() const
+{
+	return m_Samples.empty() ? 0.0 : *min_element(m_Samples.begin(), m_Samples.end());
+}
+
+double CSamplingTimer::GetMax() const
+{
+	return m_Samples.empty() ? 0.0 : *max_element(m_Samples.begin(), m_Samples.end());
+}
+
+double CSamplingTimer::GetPercentile(double Percent) const
+{
+	return GetPercentile(m_Samples, Percent);
+}
+
+double CSamplingTimer::GetPercentile(vector<double> Samples, double Percent)
+{
+	if(Samples.empty())
+		return 0.0;
+
+	sort(Samples.begin(), Samples.end());
+	double rank = min(max(Percent, 0.0), 100.0) / 100.0 * double(Samples.size() - 1);
+	size_t lower = size_t(rank);
+	if(lower + 1 >= Samples.size())
+		return Samples.back();
+	double fraction = rank - double(lower);
+	return Samples[lower] + fraction * (Samples[lower + 1] - Samples[lower]);
+}
+
+void CSamplingTimer::PrintStatistics(ostream& Out) const
+{
+	Out << "mean " << GetMean() << " ms, stddev " << GetStdDev() << " ms, median " << GetMedian()
+		<< " ms, p5 " << GetPercentile(5.0) << " ms, p95 " << GetPercentile(95.0) << " ms ("
+		<< GetNumSamples() << " samples)";
+}
+
+///////////////////////////////////////////////////////////////////////////////
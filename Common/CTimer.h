@@ -0,0 +1,137 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTIMER_H
+#define _CTIMER_H
+
+//Simple wrapper class that can be used to measure time intervals
+//using the built-in precision timer of the OS
+
+// We reverted from std::chrono, because that timer implementation seems to be very imprecise
+// (at least under windows)
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+#else
+
+// a monotonic clock with nanosecond resolution, unlike gettimeofday() it does not jump when the
+// system time is adjusted (CLOCK_MONOTONIC_RAW is not even slewed by NTP)
+#include <time.h>
+
+#endif
+
+#include <vector>
+#include <ostream>
+
+//! Simple wrapper class for the measurement of time intervals
+/*!
+	Use this timer to measure elapsed time on the HOST side.
+	Not suitable for measuring the execution of DEVICE code
+	without synchronization with the HOST.
+
+	NOTE: An instance is not thread-safe. Some tasks do use CPU threads (the
+	CPU references, CImagePipeline, CImageComparison), so give every thread its
+	own timer, like the reader and writer stages of CImagePipeline do. Reading
+	the clock itself is safe from any thread.
+*/
+class CTimer
+{
+public:
+
+	CTimer(){};
+
+	~CTimer(){};
+
+	void Start();
+
+	void Stop();
+
+	//! Returns the elapsed time between Start() and Stop() in ms.
+	double GetElapsedMilliseconds();
+
+protected:
+
+#ifdef WIN32
+	LARGE_INTEGER		m_StartTime;
+	LARGE_INTEGER		m_EndTime;
+#else
+	struct timespec		m_StartTime;
+	struct timespec		m_EndTime;
+#endif
+};
+
+//! Timer which keeps the time of every iteration
+/*!
+	Dividing the total time of a loop by the number of iterations hides the variance and
+	includes the first, cold runs (program upload, caches, clock ramp-up). Time every
+	iteration with Start() / Stop() or add externally measured times (e.g. from cl_event
+	profiling) with AddSample(). The first WarmupIterations samples are discarded.
+*/
+class CSamplingTimer
+{
+public:
+	explicit CSamplingTimer(unsigned int WarmupIterations = 0);
+
+	void Start();
+
+	//! Ends an iteration, its time is a sample unless it is one of the warmup iterations
+	void Stop();
+
+	//! Adds the time of an iteration in ms, the warmup iterations are discarded here as well
+	void AddSample(double Milliseconds);
+
+	//! Adds the samples of Other to the samples with the same index
+	/*!
+		For iterations whose stages (e.g. the passes or channels of an image) are timed
+		separately: accumulating the timers of all stages gives the time of every iteration.
+		The first call takes over the samples of Other, surplus samples are dropped.
+	*/
+	void Accumulate(const CSamplingTimer& Other);
+
+	//! Discards all samples, the next WarmupIterations samples are warmup again
+	void Reset();
+
+	const std::vector<double>& GetSamples() const { return m_Samples; }
+	size_t GetNumSamples() const { return m_Samples.size(); }
+
+	// statistics of the samples in ms, 0 if there are none
+	double GetMean() const;
+	double GetStdDev() const;
+	double GetMin() const;
+	double GetMax() const;
+	double GetMedian() const { return GetPercentile(50.0); }
+	//! Linear interpolation between the closest ranks, Percent in [0, 100]
+	double GetPercentile(double Percent) const;
+
+	//! Prints mean, standard deviation, median, 5th / 95th percentile and the number of samples
+	void PrintStatistics(std::ostream& Out) const;
+
+	//! GetPercentile() of an arbitrary set of samples
+	static double GetPercentile(std::vector<double> Samples, double Percent);
+
+protected:
+	CTimer					m_Timer;
+	unsigned int			m_WarmupIterations;
+	unsigned int			m_NumDiscarded;
+	std::vector<double>		m_Samples;
+};
+
+#endif // _CTIMER_H
@@ -0,0 +1,284 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CTraceRecorder.h"
+#include "CLHandles.h"
+#include "CJsonUtil.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+using namespace std;
+
+// round trips of the clock calibration, the shortest one is used
+#define CALIBRATION_ROUNDS 5
+
+CTraceRecorder* CTraceRecorder::s_pActive = nullptr;
+
+namespace
+{
+	//! Metadata event naming a process or a track
+	void WriteName(ostream& Out, const char* Kind, int Process, int Track, const string& Name)
+	{
+		Out << "," << endl << "    {\"name\": \"" << Kind << "\", \"ph\": \"M\", \"pid\": " << Process
+			<< ", \"tid\": " << Track << ", \"args\": {\"name\": " << CJsonUtil::QuoteString(Name) << "}}";
+	}
+
+#ifdef CL_VERSION_1_2
+	//! True if the device supports OpenCL 1.2, which replaced clEnqueueMarker()
+	bool SupportsOpenCL12(cl_device_id Device)
+	{
+		// "OpenCL <major>.<minor> <vendor specific>"
+		char version[256] = "";
+		clGetDeviceInfo(Device, CL_DEVICE_VERSION, sizeof(version) - 1, version, NULL);
+		int major = 0, minor = 0;
+		return sscanf(version, "OpenCL %d.%d", &major, &minor) == 2 && (major > 1 || (major == 1 && minor >= 2));
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTraceRecorder
+
+CTraceRecorder::CTraceRecorder()
+	: m_NumDropped(0)
+{
+	m_Origin.Start();
+}
+
+CTraceRecorder::~CTraceRecorder()
+{
+	Clear();
+	if(s_pActive == this)
+		s_pActive = nullptr;
+}
+
+void CTraceRecorder::Clear()
+{
+	lock_guard<mutex> lock(m_Mutex);
+	for(size_t i = 0; i < m_PendingEvents.size(); i++)
+		clReleaseEvent(m_PendingEvents[i].Event);
+	m_PendingEvents.clear();
+	m_Spans.clear();
+	m_NumDropped = 0;
+	m_HostTracks.clear();
+	m_QueueTracks.clear();
+	m_QueueNames.clear();
+	m_DeviceOffsets.clear();
+	m_Origin.Start();
+}
+
+double CTraceRecorder::GetHostTime() const
+{
+	CTimer now = m_Origin;
+	now.Stop();
+	return 1000.0 * now.GetElapsedMilliseconds();
+}
+
+void CTraceRecorder::AddHostSpan(const string& Name, const char* Category, double StartUs, double EndUs)
+{
+	lock_guard<mutex> lock(m_Mutex);
+
+	thread::id id = this_thread::get_id();
+	map<thread::id, int>::iterator track = m_HostTracks.find(id);
+	if(track == m_HostTracks.end())
+		track = m_HostTracks.insert(make_pair(id, int(m_HostTracks.size()))).first;
+
+	SSpan span = { Name, Category, HOST_PROCESS, track->second, StartUs, EndUs - StartUs };
+	m_Spans.push_back(span);
+}
+
+void CTraceRecorder::AddDeviceEvent(const string& Name, const char* Category, cl_event Event)
+{
+	if(Event == nullptr || clRetainEvent(Event) != CL_SUCCESS)
+		return;
+
+	lock_guard<mutex> lock(m_Mutex);
+	SPendingEvent pending = { Name, Category, Event };
+	m_PendingEvents.push_back(pending);
+}
+
+void CTraceRecorder::Flush()
+{
+	lock_guard<mutex> lock(m_Mutex);
+
+	for(size_t i = 0; i < m_PendingEvents.size(); i++)
+	{
+		SPendingEvent& pending = m_PendingEvents[i];
+
+		cl_command_queue queue = nullptr;
+		cl_device_id device = nullptr;
+		cl_ulong start = 0, end = 0;
+		cl_int clError = clWaitForEvents(1, &pending.Event);
+		clError |= clGetEventInfo(pending.Event, CL_EVENT_COMMAND_QUEUE, sizeof(queue), &queue, NULL);
+		clError |= clGetCommandQueueInfo(queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL);
+		clError |= clGetEventProfilingInfo(pending.Event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+		clError |= clGetEventProfilingInfo(pending.Event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+		clReleaseEvent(pending.Event);
+
+		// the first event of a device calibrates its clock on the queue of the event
+		map<cl_device_id, double>::iterator offset = m_DeviceOffsets.end();
+		if(clError == CL_SUCCESS)
+		{
+			offset = m_DeviceOffsets.find(device);
+			double offsetUs;
+			if(offset == m_DeviceOffsets.end() && Calibrate(queue, device, offsetUs))
+				offset = m_DeviceOffsets.insert(make_pair(device, offsetUs)).first;
+		}
+		if(offset == m_DeviceOffsets.end())
+		{
+			// e.g. a queue without CL_QUEUE_PROFILING_ENABLE
+			m_NumDropped++;
+			continue;
+		}
+
+		SSpan span = { pending.Name, pending.Category, DEVICE_PROCESS, GetQueueTrack(queue, device),
+			1.0e-3 * double(start) + offset->second, 1.0e-3 * double(end - start) };
+		m_Spans.push_back(span);
+	}
+	m_PendingEvents.clear();
+}
+
+bool CTraceRecorder::Save(const string& FileName)
+{
+	Flush();
+
+	ofstream file(FileName.c_str());
+	if(!file)
+	{
+		cerr << "Failed to open the trace file '" << FileName << "'." << endl;
+		return false;
+	}
+	WriteJSON(file);
+
+	lock_guard<mutex> lock(m_Mutex);
+	if(m_NumDropped > 0)
+		cerr << "Warning: " << m_NumDropped << " device events without profiling information are missing in the trace." << endl;
+	cout << "Trace with " << m_Spans.size() << " spans written to " << FileName << endl;
+	return bool(file);
+}
+
+void CTraceRecorder::WriteJSON(ostream& Out) const
+{
+	lock_guard<mutex> lock(m_Mutex);
+
+	ios::fmtflags flags = Out.setf(ios::fixed, ios::floatfield);
+	streamsize precision = Out.precision(3);
+
+	// timestamps and durations are in microseconds
+	Out << "{" << endl << "  \"displayTimeUnit\": \"ms\"," << endl << "  \"traceEvents\": [" << endl
+		<< "    {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << HOST_PROCESS << ", \"args\": {\"name\": \"Host\"}}";
+	WriteName(Out, "process_name", DEVICE_PROCESS, 0, "OpenCL devices");
+	for(map<thread::id, int>::const_iterator it = m_HostTracks.begin(); it != m_HostTracks.end(); ++it)
+		WriteName(Out, "thread_name", HOST_PROCESS, it->second, it->second == 0 ? string("main thread") : "thread " + to_string(it->second));
+	for(size_t i = 0; i < m_QueueNames.size(); i++)
+		WriteName(Out, "thread_name", DEVICE_PROCESS, int(i), m_QueueNames[i]);
+
+	for(size_t i = 0; i < m_Spans.size(); i++)
+	{
+		const SSpan& s = m_Spans[i];
+		Out << "," << endl << "    {\"name\": " << CJsonUtil::QuoteString(s.Name)
+			<< ", \"cat\": " << CJsonUtil::QuoteString(s.Category) << ", \"ph\": \"X\", \"pid\": " << s.Process << ", \"tid\": " << s.Track
+			<< ", \"ts\": " << s.StartUs << ", \"dur\": " << s.DurationUs << "}";
+	}
+	Out << endl << "  ]" << endl << "}" << endl;
+
+	Out.precision(precision);
+	Out.flags(flags);
+}
+
+bool CTraceRecorder::Calibrate(cl_command_queue Queue, cl_device_id Device, double& OffsetUs) const
+{
+	// only the traced events have completed, later commands may still be queued; the round
+	// trips have to start on an idle queue, otherwise they would include that work
+	if(clFinish(Queue) != CL_SUCCESS)
+		return false;
+
+#ifdef CL_VERSION_1_2
+	bool markerWithWaitList = SupportsOpenCL12(Device);
+#endif
+
+	double bestRoundTrip = -1.0;
+	for(int i = 0; i < CALIBRATION_ROUNDS; i++)
+	{
+		CLEvent marker;
+		double before = GetHostTime();
+		cl_int clError;
+#ifdef CL_VERSION_1_2
+		if(markerWithWaitList)
+			clError = clEnqueueMarkerWithWaitList(Queue, 0, NULL, marker.Receive());
+		else
+#endif
+			clError = clEnqueueMarker(Queue, marker.Receive());
+		if(clError != CL_SUCCESS || clFinish(Queue) != CL_SUCCESS)
+			return false;
+		double after = GetHostTime();
+
+		cl_ulong end = 0;
+		if(clGetEventProfilingInfo(marker, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL) != CL_SUCCESS)
+			return false;
+
+		if(bestRoundTrip < 0.0 || after - before < bestRoundTrip)
+		{
+			bestRoundTrip = after - before;
+			OffsetUs = 0.5 * (before + after) - 1.0e-3 * double(end);
+		}
+	}
+	return true;
+}
+
+int CTraceRecorder::GetQueueTrack(cl_command_queue Queue, cl_device_id Device)
+{
+	map<cl_command_queue, int>::iterator track = m_QueueTracks.find(Queue);
+	if(track != m_QueueTracks.end())
+		return track->second;
+
+	char deviceName[256] = "";
+	clGetDeviceInfo(Device, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, NULL);
+
+	int index = int(m_QueueNames.size());
+	m_QueueNames.push_back(string(deviceName) + " queue " + to_string(index));
+	m_QueueTracks[Queue] = index;
+	return index;
+}
+
+CTraceRecorder* CTraceRecorder::GetActive()
+{
+	return s_pActive;
+}
+
+void CTraceRecorder::SetActive(CTraceRecorder* Recorder)
+{
+	s_pActive = Recorder;
+}
+
+void CTraceRecorder::TraceDeviceEvent(const string& Name, const char* Category, cl_event Event)
+{
+	if(s_pActive != nullptr)
+		s_pActive->AddDeviceEvent(Name, Category, Event);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTraceScope
+
+CTraceScope::CTraceScope(const char* Name, const char* Category)
+	: m_pRecorder(CTraceRecorder::GetActive()), m_Category(Category), m_StartUs(0.0)
+{
+	if(m_pRecorder != nullptr)
+	{
+		m_Name = Name;
+		m_StartUs = m_pRecorder->GetHostTime();
+	}
+}
+
+CTraceScope::~CTraceScope()
+{
+	if(m_pRecorder != nullptr)
+		m_pRecorder->AddHostSpan(m_Name, m_Category, m_StartUs, m_pRecorder->GetHostTime());
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,154 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTRACE_RECORDER_H
+#define _CTRACE_RECORDER_H
+
+#include "IComputeTask.h"
+#include "CTimer.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <ostream>
+
+//! Timeline of the host and device activity in the trace event format (chrome://tracing, Perfetto)
+/*!
+	CAssignmentBase owns a recorder and makes it the active one while its context exists if a
+	trace file was requested (--trace). Host code marks its phases with CTraceScope, device
+	commands are added by their cl_event (the queue needs CL_QUEUE_PROFILING_ENABLE). The static
+	functions do nothing if no recorder is active, so the instrumentation can stay in place.
+
+	The device timestamps are read in Flush(), after the commands have completed, and are moved
+	onto the host time axis with an offset per device. It is calibrated with markers on the
+	drained queue, the end of a marker is matched to the middle of the shortest host round trip.
+
+	Every host thread and every command queue gets its own track. Categories are not copied,
+	they have to be string literals.
+*/
+class CTraceRecorder
+{
+public:
+	CTraceRecorder();
+
+	~CTraceRecorder();
+
+	//! Discards all spans and pending events, the time axis starts now
+	void Clear();
+
+	//! Host time in microseconds since Clear()
+	double GetHostTime() const;
+
+	//! A host span on the track of the calling thread
+	void AddHostSpan(const std::string& Name, const char* Category, double StartUs, double EndUs);
+
+	//! A device command, Event is retained until Flush()
+	void AddDeviceEvent(const std::string& Name, const char* Category, cl_event Event);
+
+	//! Waits for the pending device events and converts their timestamps
+	/*!
+		Call this before the queues of the events are released, CAssignmentBase does so
+		at the end of every RunComputeTask() and CImagePipeline after every image of a batch.
+	*/
+	void Flush();
+
+	//! Writes the trace event JSON, Flush() is called first
+	bool Save(const std::string& FileName);
+	void WriteJSON(std::ostream& Out) const;
+
+	//! The recorder used by the static functions, nullptr if there is none
+	static CTraceRecorder* GetActive();
+	static void SetActive(CTraceRecorder* Recorder);
+
+	static bool IsTracing() { return s_pActive != nullptr; }
+
+	//! AddDeviceEvent() on the active recorder
+	static void TraceDeviceEvent(const std::string& Name, const char* Category, cl_event Event);
+
+protected:
+	enum { HOST_PROCESS = 1, DEVICE_PROCESS = 2 };
+
+	struct SSpan
+	{
+		std::string		Name;
+		const char*		Category;
+		int				Process;
+		int				Track;
+		double			StartUs;
+		double			DurationUs;
+	};
+
+	struct SPendingEvent
+	{
+		std::string		Name;
+		const char*		Category;
+		cl_event		Event;
+	};
+
+	//! Host time minus device time in microseconds, the Queue is drained first
+	bool Calibrate(cl_command_queue Queue, cl_device_id Device, double& OffsetUs) const;
+
+	//! Index of the track of a queue, it is named after the device on the first use
+	int GetQueueTrack(cl_command_queue Queue, cl_device_id Device);
+
+	CTimer									m_Origin;
+	std::vector<SSpan>						m_Spans;
+	std::vector<SPendingEvent>				m_PendingEvents;
+	unsigned int							m_NumDropped;
+
+	std::map<std::thread::id, int>			m_HostTracks;
+	std::map<cl_command_queue, int>			m_QueueTracks;
+	std::vector<std::string>				m_QueueNames;
+	std::map<cl_device_id, double>			m_DeviceOffsets;
+
+	// host spans and device events may be added from worker threads
+	mutable std::mutex						m_Mutex;
+
+	static CTraceRecorder*	s_pActive;
+};
+
+//! Adds a host span from the construction to the destruction to the active recorder
+/*!
+	Usage:
+		{
+			CTraceScope scope("InitResources");
+			...
+		}
+	Only a pointer check if no recorder is active, Name and Category are copied then.
+*/
+class CTraceScope
+{
+public:
+	explicit CTraceScope(const char* Name, const char* Category = "host");
+
+	~CTraceScope();
+
+	CTraceScope(const CTraceScope&) = delete;
+	CTraceScope& operator=(const CTraceScope&) = delete;
+
+private:
+	CTraceRecorder*		m_pRecorder;
+	std::string			m_Name;
+	const char*			m_Category;
+	double				m_StartUs;
+};
+
+#endif // _CTRACE_RECORDER_H
@@ -17,33 +17,30 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
-#ifndef _IGUI_ENABLED_COMPUTE_TASK_H
-#define _IGUI_ENABLED_COMPUTE_TASK_H
+#ifndef _IASYNC_BUILD_COMPUTE_TASK_H
+#define _IASYNC_BUILD_COMPUTE_TASK_H
 
 #include "IComputeTask.h"
 
-//! Common interface for task that have and OpenGL UI
+//! Optional interface for tasks which can start building their programs before InitResources()
 /*!
-	Currently we only use this interface in Assignment4
-	to perform GL rendering and respond to user input with keyboard and mouse.
+	CAssignmentBase::AddBenchmark() creates the tasks of all queued runs up front and calls
+	StartProgramBuilds() on those implementing this interface besides IComputeTask, so all
+	programs of an assignment compile concurrently instead of one after another (and not
+	in the middle of the timed runs).
+
+	The builds are started with CLUtil::BuildCachedCLProgramAsync(). InitResources() requests
+	the same programs (identical source and compile options) with CLUtil::BuildCachedCLProgram(),
+	which only waits for the build started here.
 */
-class IGUIEnabledComputeTask : public IComputeTask
+class IAsyncBuildComputeTask
 {
 public:
-	virtual ~IGUIEnabledComputeTask() {};
 
-	// OpenGL render callback
-	virtual void Render() = 0;
+	virtual ~IAsyncBuildComputeTask() {};
 
-	virtual void OnKeyboard(int Key, int Action) = 0;
-
-	virtual void OnMouse(int Button, int Action) = 0;
-	virtual void OnMouseMove(int X, int Y) = 0;
-
-	virtual void OnIdle(double Time, float ElapsedTime) = 0;
-
-	virtual void OnWindowResized(int Width, int Height) = 0;
+	//! Starts the builds of the programs InitResources() will need, should return quickly
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context) = 0;
 };
 
-
-#endif // _IGUI_ENABLED_COMPUTE_TASK_H
+#endif // _IASYNC_BUILD_COMPUTE_TASK_H
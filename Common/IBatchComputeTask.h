@@ -17,48 +17,35 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
-#ifndef _CASSIGNMENT_BASE_H
-#define _CASSIGNMENT_BASE_H
 
-#include "IComputeTask.h"
-
-#include "CommonDefs.h"
+#ifndef _IBATCH_COMPUTE_TASK_H
+#define _IBATCH_COMPUTE_TASK_H
 
-//! Base class for all assignments
-/*! 
-	Inherit a new class for each specific assignment.
-	This class is abstract.
+#include "IComputeTask.h"
 
-	Usage of class: from your main CPP you typically call
-	EnterMainLoop(). This returns when the assignment is finished.
+#include <string>
 
-	Internally the assignment class should initialize the context,
-	run one or more compute tasks and then release the context.
+//! Optional interface for tasks which process a whole directory of inputs in one run
+/*!
+	If the input of a benchmark run (--input) is a directory and the task implements this
+	interface besides IComputeTask, RunBenchmarks() calls ComputeBatch() instead of
+	RunComputeTask(). The task loads, computes and saves every input of the directory.
+	Computing a CPU reference for every input would dominate the run time, so a task
+	validates only a sample of the inputs, e.g. the first one and every input with
+	another size than the one before it.
 */
-class CAssignmentBase
+class IBatchComputeTask
 {
 public:
-	CAssignmentBase();
-
-	virtual ~CAssignmentBase();
-
-	//! Main loop. You only need to overload this if you do some rendering in your assignment.
-	virtual bool EnterMainLoop(int argc, char** argv);
-
-	//! You need to overload this to define a specific behavior for your assignments
-	virtual bool DoCompute() = 0;
-
-protected:	
-	virtual bool InitCLContext();
-
-	virtual void ReleaseCLContext();
 
-	virtual bool RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]);
+	virtual ~IBatchComputeTask() {};
 
-	cl_platform_id		m_CLPlatform;
-	cl_device_id		m_CLDevice;
-	cl_context			m_CLContext;
-	cl_command_queue	m_CLCommandQueue;
+	//! Processes all inputs of Directory, returns false if one of them could not be processed
+	/*!
+		Valid is set to true if inputs were validated and all of them matched their CPU reference.
+	*/
+	virtual bool ComputeBatch(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue,
+		const std::string& Directory, size_t LocalWorkSize[3], bool& Valid) = 0;
 };
 
-#endif // _CASSIGNMENT_BASE_H
+#endif // _IBATCH_COMPUTE_TASK_H
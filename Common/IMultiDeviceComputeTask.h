@@ -17,48 +17,38 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
-#ifndef _CASSIGNMENT_BASE_H
-#define _CASSIGNMENT_BASE_H
+#ifndef _IMULTI_DEVICE_COMPUTE_TASK_H
+#define _IMULTI_DEVICE_COMPUTE_TASK_H
 
 #include "IComputeTask.h"
 
-#include "CommonDefs.h"
+#include <vector>
 
-//! Base class for all assignments
-/*! 
-	Inherit a new class for each specific assignment.
-	This class is abstract.
+//! Optional interface for tasks which can split their work over several devices
+/*!
+	In the multi-device mode of CAssignmentBase (command line option --multi-device)
+	the context contains all available devices of the selected platform. Tasks which
+	implement this interface besides IComputeTask are run on all of them, the other
+	tasks only on the first device.
 
-	Usage of class: from your main CPP you typically call
-	EnterMainLoop(). This returns when the assignment is finished.
-
-	Internally the assignment class should initialize the context,
-	run one or more compute tasks and then release the context.
+	InitResources() is still called with the first device, before InitMultiDeviceResources().
+	ReleaseResources() has to release the resources of both.
 */
-class CAssignmentBase
+class IMultiDeviceComputeTask
 {
 public:
-	CAssignmentBase();
-
-	virtual ~CAssignmentBase();
-
-	//! Main loop. You only need to overload this if you do some rendering in your assignment.
-	virtual bool EnterMainLoop(int argc, char** argv);
-
-	//! You need to overload this to define a specific behavior for your assignments
-	virtual bool DoCompute() = 0;
-
-protected:	
-	virtual bool InitCLContext();
 
-	virtual void ReleaseCLContext();
+	virtual ~IMultiDeviceComputeTask() {};
 
-	virtual bool RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]);
+	//! Init the resources needed on every device of the context
+	virtual bool InitMultiDeviceResources(cl_context Context, const std::vector<cl_device_id>& Devices) = 0;
 
-	cl_platform_id		m_CLPlatform;
-	cl_device_id		m_CLDevice;
-	cl_context			m_CLContext;
-	cl_command_queue	m_CLCommandQueue;
+	//! Perform the calculations on all devices, CommandQueues[i] belongs to Devices[i]
+	/*!
+		This is called instead of ComputeGPU() and has to leave the merged result
+		where ValidateResults() expects it.
+	*/
+	virtual void ComputeGPUMultiDevice(cl_context Context, const std::vector<cl_command_queue>& CommandQueues, size_t LocalWorkSize[3]) = 0;
 };
 
-#endif // _CASSIGNMENT_BASE_H
+#endif // _IMULTI_DEVICE_COMPUTE_TASK_H
@@ -17,33 +17,30 @@
                                 dP                                    d8888P  
 ******************************************************************************/
 
-#ifndef _IGUI_ENABLED_COMPUTE_TASK_H
-#define _IGUI_ENABLED_COMPUTE_TASK_H
+#ifndef _IOVERLAPPED_COMPUTE_TASK_H
+#define _IOVERLAPPED_COMPUTE_TASK_H
 
 #include "IComputeTask.h"
 
-//! Common interface for task that have and OpenGL UI
+//! Optional interface for tasks which overlap host-device transfers with kernel execution
 /*!
-	Currently we only use this interface in Assignment4
-	to perform GL rendering and respond to user input with keyboard and mouse.
+	CAssignmentBase creates a second, in-order command queue on the device which is only
+	used for transfers. Commands on the two queues may execute concurrently, so the
+	dependencies between them have to be expressed with events, e.g. a readback waits for
+	the event of the kernel that produced the data.
+
+	Tasks implementing this interface besides IComputeTask get ComputeGPUOverlapped()
+	called instead of ComputeGPU() (in single device mode).
 */
-class IGUIEnabledComputeTask : public IComputeTask
+class IOverlappedComputeTask
 {
 public:
-	virtual ~IGUIEnabledComputeTask() {};
-
-	// OpenGL render callback
-	virtual void Render() = 0;
-
-	virtual void OnKeyboard(int Key, int Action) = 0;
 
-	virtual void OnMouse(int Button, int Action) = 0;
-	virtual void OnMouseMove(int X, int Y) = 0;
+	virtual ~IOverlappedComputeTask() {};
 
-	virtual void OnIdle(double Time, float ElapsedTime) = 0;
-
-	virtual void OnWindowResized(int Width, int Height) = 0;
+	//! Perform the calculations with kernels on ComputeQueue and transfers on TransferQueue
+	virtual void ComputeGPUOverlapped(cl_context Context, cl_command_queue ComputeQueue, cl_command_queue TransferQueue,
+		size_t LocalWorkSize[3]) = 0;
 };
 
-
-#endif // _IGUI_ENABLED_COMPUTE_TASK_H
+#endif // _IOVERLAPPED_COMPUTE_TASK_H
@@ -7,6 +7,7 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CSimpleArraysTask.h"
 #include "CMatrixRotateTask.h"
+#include "CFusedElementwiseTask.h"
 
 #include <iostream>
 
@@ -17,28 +18,109 @@ using namespace std;
 
 bool CAssignment1::DoCompute()
 {
+	// the defaults below can be overridden on the command line, e.g. --task rotate.single --size 4096x4096 --local 32x8,32x16
+	// (the tile of the optimized rotation kernels is the local size)
+	// AddBenchmark() skips the runs which were not selected with --task, a section is only printed if one of its runs is queued
+
 	// Task 1: simple array addition.
-	cout << "Running vector addition example..." << endl << endl;
 	{
-		size_t localWorkSize[5] = {64, 128, 256, 512, 1024};
-		CSimpleArraysTask task(1048576);
-		RunComputeTask(task, localWorkSize);
+		AddBenchmarkSection("Running vector addition example...");
+		{
+			// bandwidth reference: sweep over local sizes and elements per work-item
+			SBenchmarkConfig defaults = {{1048576 * 16, 1, 1}, {256, 1, 1}, 10000, ""};
+			AddBenchmark("arrays.sweep", defaults, [](const SBenchmarkConfig& Config) {
+				CSimpleArraysTask* task = new CSimpleArraysTask(Config.Size[0], true);
+				task->SetIterations(Config.Iterations);
+				return unique_ptr<IComputeTask>(task);
+			});
+		}
+		{
+			SBenchmarkConfig defaults = {{1048576, 1, 1}, {512, 1, 1}, 10000, ""};
+			AddBenchmark("arrays.simple", defaults, [](const SBenchmarkConfig& Config) {
+				CSimpleArraysTask* task = new CSimpleArraysTask(Config.Size[0]);
+				task->SetIterations(Config.Iterations);
+				return unique_ptr<IComputeTask>(task);
+			});
+		}
 	}
+
+	// Generalized vector operations: a chain of elementwise steps fused into one generated kernel.
 	{
-		size_t LocalWorkSize[3] = {512, 1, 1};
-		CSimpleArraysTask task(1048576);
-		RunComputeTask(task, LocalWorkSize);
+		AddBenchmarkSection("Running fused elementwise examples...");
+
+		typedef CElementwiseExpression E;
+		E a = E::Scalar(0), b = E::Scalar(1);
+		E x = E::Input(0), y = E::Input(1), c = E::Input(2);
+
+		SBenchmarkConfig defaults = {{1048576 * 4, 1, 1}, {256, 1, 1}, 1000, ""};
+		{
+			E expression = a * x + b * y - c;
+			AddBenchmark("fused.int", defaults, [expression](const SBenchmarkConfig& Config) {
+				CFusedElementwiseTask<cl_int>* task = new CFusedElementwiseTask<cl_int>(Config.Size[0], expression);
+				task->SetIterations(Config.Iterations);
+				return unique_ptr<IComputeTask>(task);
+			});
+		}
+		{
+			E expression = E::Max(a * x + b * y - c, 0.0) * (x + 0.5);
+			AddBenchmark("fused.float", defaults, [expression](const SBenchmarkConfig& Config) {
+				CFusedElementwiseTask<cl_float>* task = new CFusedElementwiseTask<cl_float>(Config.Size[0], expression);
+				task->SetIterations(Config.Iterations);
+				return unique_ptr<IComputeTask>(task);
+			});
+		}
 	}
 
+	// the matrix rotations take the width and height from the size, the element size and the
+	// number of matrices per batch are fixed for each benchmark
+	auto addRotation = [&](const string& Name, const SBenchmarkConfig& Defaults, CMatrixRotateTask::ERotationMode Mode,
+		size_t ElementSize, size_t BatchSize, bool InPlace) {
+		AddBenchmark(Name, Defaults, [=](const SBenchmarkConfig& Config) {
+			size_t TileSize[2] = {Config.LocalWorkSize[0], Config.LocalWorkSize[1]};
+			CMatrixRotateTask* task = new CMatrixRotateTask(Config.Size[0], Config.Size[1], TileSize, Mode, ElementSize, BatchSize, InPlace);
+			task->SetIterations(Config.Iterations);
+			return unique_ptr<IComputeTask>(task);
+		});
+	};
+
 	// Task 2: matrix rotation.
-	std::cout << "Running matrix rotation example..." << std::endl << std::endl;
 	{
-		size_t LocalWorkSize[3] = {32, 16, 1};
-		CMatrixRotateTask task(2048, 1025);
-		RunComputeTask(task, LocalWorkSize);
+		AddBenchmarkSection("Running matrix rotation example...");
+
+		SBenchmarkConfig defaults = {{2048, 1025, 1}, {32, 16, 1}, 100, ""};
+		addRotation("rotate.single", defaults, CMatrixRotateTask::ROTATE_90, sizeof(float), 1, false);
+	}
+
+	// Other rotations, element sizes and batches of matrices.
+	{
+		AddBenchmarkSection("Running batched matrix rotation examples...");
+
+		// 8 bit grayscale frames
+		SBenchmarkConfig defaults = {{1920, 1080, 1}, {32, 8, 1}, 100, ""};
+		addRotation("rotate.batch.gray8", defaults, CMatrixRotateTask::ROTATE_180, 1, 4, false);
+		// RGBA frames
+		addRotation("rotate.batch.rgba8", defaults, CMatrixRotateTask::ROTATE_270, 4, 4, false);
+		// 16 bit RGBA frames
+		SBenchmarkConfig defaults16 = {{1023, 777, 1}, {32, 8, 1}, 100, ""};
+		addRotation("rotate.batch.rgba16", defaults16, CMatrixRotateTask::TRANSPOSE, 8, 2, false);
+		// float RGBA frames
+		SBenchmarkConfig defaultsFloat = {{640, 480, 1}, {16, 16, 1}, 100, ""};
+		addRotation("rotate.batch.rgba32f", defaultsFloat, CMatrixRotateTask::ROTATE_90, 16, 2, false);
+	}
+
+	// In-place rotations, which only need a single matrix buffer on the device.
+	{
+		AddBenchmarkSection("Running in-place matrix rotation examples...");
+
+		// square matrix: tile pair swaps followed by a flip
+		SBenchmarkConfig defaultsSquare = {{4096, 4096, 1}, {32, 8, 1}, 1, ""};
+		addRotation("rotate.inplace.square", defaultsSquare, CMatrixRotateTask::ROTATE_90, 4, 1, true);
+		// non-square matrix: cycle following
+		SBenchmarkConfig defaultsCycles = {{1920, 1080, 1}, {32, 8, 1}, 1, ""};
+		addRotation("rotate.inplace.cycles", defaultsCycles, CMatrixRotateTask::ROTATE_270, 1, 2, true);
 	}
 
-	return true;
+	return RunBenchmarks();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
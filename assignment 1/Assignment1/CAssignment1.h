@@ -20,7 +20,7 @@
 #ifndef _CASSIGNMENT1_H
 #define _CASSIGNMENT1_H
 
-#include "../Common/CAssignmentBase.h"
+#include "../../Common/CAssignmentBase.h"
 
 //! Assignment1 solution
 class CAssignment1 : public CAssignmentBase
@@ -0,0 +1,207 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CElementwiseExpression.h"
+
+#include <sstream>
+#include <limits>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CElementwiseExpression
+
+CElementwiseExpression::CElementwiseExpression(double Value)
+{
+	shared_ptr<SNode> node = make_shared<SNode>();
+	node->Op = OP_CONSTANT;
+	node->Index = 0;
+	node->Value = Value;
+	m_Node = node;
+}
+
+CElementwiseExpression CElementwiseExpression::Input(unsigned int Index)
+{
+	shared_ptr<SNode> node = make_shared<SNode>();
+	node->Op = OP_INPUT;
+	node->Index = Index;
+	node->Value = 0.0;
+	return CElementwiseExpression(NodePtr(node));
+}
+
+CElementwiseExpression CElementwiseExpression::Scalar(unsigned int Index)
+{
+	shared_ptr<SNode> node = make_shared<SNode>();
+	node->Op = OP_SCALAR;
+	node->Index = Index;
+	node->Value = 0.0;
+	return CElementwiseExpression(NodePtr(node));
+}
+
+CElementwiseExpression CElementwiseExpression::MakeBinary(EOperation Op, const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	shared_ptr<SNode> node = make_shared<SNode>();
+	node->Op = Op;
+	node->Index = 0;
+	node->Value = 0.0;
+	node->Left = A.m_Node;
+	node->Right = B.m_Node;
+	return CElementwiseExpression(NodePtr(node));
+}
+
+CElementwiseExpression CElementwiseExpression::Min(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return MakeBinary(OP_MIN, A, B);
+}
+
+CElementwiseExpression CElementwiseExpression::Max(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return MakeBinary(OP_MAX, A, B);
+}
+
+CElementwiseExpression operator+(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return CElementwiseExpression::MakeBinary(CElementwiseExpression::OP_ADD, A, B);
+}
+
+CElementwiseExpression operator-(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return CElementwiseExpression::MakeBinary(CElementwiseExpression::OP_SUB, A, B);
+}
+
+CElementwiseExpression operator*(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return CElementwiseExpression::MakeBinary(CElementwiseExpression::OP_MUL, A, B);
+}
+
+CElementwiseExpression operator/(const CElementwiseExpression& A, const CElementwiseExpression& B)
+{
+	return CElementwiseExpression::MakeBinary(CElementwiseExpression::OP_DIV, A, B);
+}
+
+void CElementwiseExpression::CountArguments(const SNode& Node, unsigned int& NumInputs, unsigned int& NumScalars)
+{
+	if(Node.Op == OP_INPUT)
+		NumInputs = max(NumInputs, Node.Index + 1);
+	else if(Node.Op == OP_SCALAR)
+		NumScalars = max(NumScalars, Node.Index + 1);
+
+	if(Node.Left)
+		CountArguments(*Node.Left, NumInputs, NumScalars);
+	if(Node.Right)
+		CountArguments(*Node.Right, NumInputs, NumScalars);
+}
+
+unsigned int CElementwiseExpression::GetNumInputs() const
+{
+	unsigned int numInputs = 0, numScalars = 0;
+	CountArguments(*m_Node, numInputs, numScalars);
+	return numInputs;
+}
+
+unsigned int CElementwiseExpression::GetNumScalars() const
+{
+	unsigned int numInputs = 0, numScalars = 0;
+	CountArguments(*m_Node, numInputs, numScalars);
+	return numScalars;
+}
+
+unsigned int CElementwiseExpression::CountUnfusedAccesses(const SNode& Node)
+{
+	if(!Node.Left)
+		return 0;
+
+	// every operation writes a temporary array and reads its array operands
+	unsigned int accesses = 1;
+	const SNode* operands[2] = {Node.Left.get(), Node.Right.get()};
+	for(int i = 0; i < 2; i++)
+	{
+		if(operands[i]->Op != OP_SCALAR && operands[i]->Op != OP_CONSTANT)
+			accesses++;
+		accesses += CountUnfusedAccesses(*operands[i]);
+	}
+	return accesses;
+}
+
+unsigned int CElementwiseExpression::GetUnfusedAccessesPerElement() const
+{
+	// a bare input still has to be copied once
+	return m_Node->Left ? CountUnfusedAccesses(*m_Node) : 2;
+}
+
+void CElementwiseExpression::GenerateExpression(const SNode& Node, const string& TypeName, string& Code)
+{
+	stringstream ss;
+	switch(Node.Op)
+	{
+	case OP_INPUT:
+		ss << "v" << Node.Index;
+		Code += ss.str();
+		return;
+	case OP_SCALAR:
+		ss << "s" << Node.Index;
+		Code += ss.str();
+		return;
+	case OP_CONSTANT:
+		if(TypeName == "float")
+		{
+			ss.precision(numeric_limits<float>::max_digits10);
+			ss << "(" << showpoint << Node.Value << "f)";
+		}
+		else
+			ss << "((" << TypeName << ")" << (long long)Node.Value << ")";
+		Code += ss.str();
+		return;
+	case OP_MIN:
+	case OP_MAX:
+		Code += Node.Op == OP_MIN ? "min(" : "max(";
+		GenerateExpression(*Node.Left, TypeName, Code);
+		Code += ", ";
+		GenerateExpression(*Node.Right, TypeName, Code);
+		Code += ")";
+		return;
+	default:
+		break;
+	}
+
+	const char* op = Node.Op == OP_ADD ? " + " : Node.Op == OP_SUB ? " - " : Node.Op == OP_MUL ? " * " : " / ";
+	Code += "(";
+	GenerateExpression(*Node.Left, TypeName, Code);
+	Code += op;
+	GenerateExpression(*Node.Right, TypeName, Code);
+	Code += ")";
+}
+
+string CElementwiseExpression::GenerateKernel(const string& KernelName, const string& TypeName) const
+{
+	unsigned int numInputs = 0, numScalars = 0;
+	CountArguments(*m_Node, numInputs, numScalars);
+
+	stringstream ss;
+	ss << "__kernel void " << KernelName << "(";
+	for(unsigned int i = 0; i < numInputs; i++)
+		ss << "__global const " << TypeName << "* in" << i << ", ";
+	ss << "__global " << TypeName << "* out, ";
+	for(unsigned int i = 0; i < numScalars; i++)
+		ss << TypeName << " s" << i << ", ";
+	ss << "uint N)" << endl;
+	ss << "{" << endl;
+	ss << "\tuint i = get_global_id(0);" << endl;
+	ss << "\tif (i >= N)" << endl;
+	ss << "\t\treturn;" << endl << endl;
+
+	// every input is read exactly once, even if the expression uses it several times
+	for(unsigned int i = 0; i < numInputs; i++)
+		ss << "\t" << TypeName << " v" << i << " = in" << i << "[i];" << endl;
+
+	string expression;
+	GenerateExpression(*m_Node, TypeName, expression);
+	ss << "\tout[i] = " << expression << ";" << endl;
+	ss << "}" << endl;
+
+	return ss.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
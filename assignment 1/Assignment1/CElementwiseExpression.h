@@ -0,0 +1,169 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CELEMENTWISE_EXPRESSION_H
+#define _CELEMENTWISE_EXPRESSION_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+//! Host-side expression tree for elementwise operations on arrays
+/*!
+	Build an expression with the usual operators, e.g.
+
+		CElementwiseExpression a = CElementwiseExpression::Scalar(0), x = CElementwiseExpression::Input(0);
+		CElementwiseExpression out = a * x + b * y - c;
+
+	GenerateKernel() turns the whole tree into a single OpenCL kernel which reads each
+	input array once and writes the result once. Evaluating the same chain step by step
+	would need a full pass over memory (and a temporary array) for every operation.
+
+	Inputs are arrays of N elements, scalars are kernel arguments and constants are
+	compiled into the kernel. The kernel arguments are: all inputs, the output,
+	all scalars and finally the number of elements.
+*/
+class CElementwiseExpression
+{
+public:
+	enum EOperation
+	{
+		OP_INPUT = 0,
+		OP_SCALAR,
+		OP_CONSTANT,
+		OP_ADD,
+		OP_SUB,
+		OP_MUL,
+		OP_DIV,
+		OP_MIN,
+		OP_MAX
+	};
+
+	//! A compile-time constant
+	CElementwiseExpression(double Value = 0.0);
+
+	//! The element of input array Index
+	static CElementwiseExpression Input(unsigned int Index);
+
+	//! The scalar kernel argument Index
+	static CElementwiseExpression Scalar(unsigned int Index);
+
+	static CElementwiseExpression Min(const CElementwiseExpression& A, const CElementwiseExpression& B);
+	static CElementwiseExpression Max(const CElementwiseExpression& A, const CElementwiseExpression& B);
+
+	friend CElementwiseExpression operator+(const CElementwiseExpression& A, const CElementwiseExpression& B);
+	friend CElementwiseExpression operator-(const CElementwiseExpression& A, const CElementwiseExpression& B);
+	friend CElementwiseExpression operator*(const CElementwiseExpression& A, const CElementwiseExpression& B);
+	friend CElementwiseExpression operator/(const CElementwiseExpression& A, const CElementwiseExpression& B);
+
+	//! Number of input arrays (highest referenced index + 1)
+	unsigned int GetNumInputs() const;
+
+	//! Number of scalar arguments (highest referenced index + 1)
+	unsigned int GetNumScalars() const;
+
+	//! Global memory accesses per element of the fused kernel
+	unsigned int GetFusedAccessesPerElement() const { return GetNumInputs() + 1; }
+
+	//! Global memory accesses per element if every operation were a separate pass over memory
+	unsigned int GetUnfusedAccessesPerElement() const;
+
+	//! Generates the OpenCL source of the fused kernel for the element type TypeName ("int" or "float")
+	std::string GenerateKernel(const std::string& KernelName, const std::string& TypeName) const;
+
+	//! Evaluates the expression on the host, one operation at a time (CPU reference)
+	template<typename T>
+	void Evaluate(const std::vector<const T*>& Inputs, const std::vector<T>& Scalars, size_t Count, T* Out) const;
+
+protected:
+	struct SNode
+	{
+		EOperation								Op;
+		unsigned int							Index;
+		double									Value;
+		std::shared_ptr<const SNode>			Left, Right;
+	};
+	typedef std::shared_ptr<const SNode> NodePtr;
+
+	explicit CElementwiseExpression(const NodePtr& Node) : m_Node(Node) {}
+
+	static CElementwiseExpression MakeBinary(EOperation Op, const CElementwiseExpression& A, const CElementwiseExpression& B);
+
+	static void CountArguments(const SNode& Node, unsigned int& NumInputs, unsigned int& NumScalars);
+	static unsigned int CountUnfusedAccesses(const SNode& Node);
+	static void GenerateExpression(const SNode& Node, const std::string& TypeName, std::string& Code);
+
+	template<typename T>
+	static void EvaluateNode(const SNode& Node, const std::vector<const T*>& Inputs, const std::vector<T>& Scalars,
+		size_t Count, std::vector<T>& Out);
+
+	NodePtr		m_Node;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Host evaluation
+
+template<typename T>
+void CElementwiseExpression::Evaluate(const std::vector<const T*>& Inputs, const std::vector<T>& Scalars, size_t Count, T* Out) const
+{
+	std::vector<T> result;
+	EvaluateNode(*m_Node, Inputs, Scalars, Count, result);
+	std::copy(result.begin(), result.end(), Out);
+}
+
+template<typename T>
+void CElementwiseExpression::EvaluateNode(const SNode& Node, const std::vector<const T*>& Inputs, const std::vector<T>& Scalars,
+	size_t Count, std::vector<T>& Out)
+{
+	switch(Node.Op)
+	{
+	case OP_INPUT:
+		Out.assign(Inputs[Node.Index], Inputs[Node.Index] + Count);
+		return;
+	case OP_SCALAR:
+		Out.assign(Count, Scalars[Node.Index]);
+		return;
+	case OP_CONSTANT:
+		Out.assign(Count, T(Node.Value));
+		return;
+	default:
+		break;
+	}
+
+	std::vector<T> right;
+	EvaluateNode(*Node.Left, Inputs, Scalars, Count, Out);
+	EvaluateNode(*Node.Right, Inputs, Scalars, Count, right);
+
+	for(size_t i = 0; i < Count; i++)
+	{
+		switch(Node.Op)
+		{
+		case OP_ADD: Out[i] = Out[i] + right[i]; break;
+		case OP_SUB: Out[i] = Out[i] - right[i]; break;
+		case OP_MUL: Out[i] = Out[i] * right[i]; break;
+		case OP_DIV: Out[i] = Out[i] / right[i]; break;
+		case OP_MIN: Out[i] = std::min(Out[i], right[i]); break;
+		case OP_MAX: Out[i] = std::max(Out[i], right[i]); break;
+		default: break;
+		}
+	}
+}
+
+#endif // _CELEMENTWISE_EXPRESSION_H
@@ -0,0 +1,176 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CFusedElementwiseTask.h"
+
+#include "../../Common/CLUtil.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CFusedElementwiseTask
+
+template<>
+const char* CFusedElementwiseTask<cl_int>::GetTypeName() { return "int"; }
+
+template<>
+const char* CFusedElementwiseTask<cl_float>::GetTypeName() { return "float"; }
+
+//! Random test data: small integers, so the integer expressions do not overflow
+template<typename T>
+static T RandomValue();
+
+template<>
+cl_int RandomValue<cl_int>() { return rand() % 1024; }
+
+template<>
+cl_float RandomValue<cl_float>() { return float(rand()) / float(RAND_MAX); }
+
+template<typename T>
+CFusedElementwiseTask<T>::CFusedElementwiseTask(size_t ArraySize, const CElementwiseExpression& Expression)
+	: m_ArraySize(ArraySize), m_Expression(Expression)
+{
+}
+
+template<typename T>
+CFusedElementwiseTask<T>::~CFusedElementwiseTask()
+{
+	ReleaseResources();
+}
+
+template<typename T>
+bool CFusedElementwiseTask<T>::InitResources(cl_device_id Device, cl_context Context)
+{
+	unsigned int numInputs = m_Expression.GetNumInputs();
+	unsigned int numScalars = m_Expression.GetNumScalars();
+
+	//CPU resources
+	m_hInputs.resize(numInputs);
+	for(unsigned int i = 0; i < numInputs; i++)
+	{
+		m_hInputs[i].resize(m_ArraySize);
+		for(size_t j = 0; j < m_ArraySize; j++)
+			m_hInputs[i][j] = RandomValue<T>();
+	}
+	m_hScalars.resize(numScalars);
+	for(unsigned int i = 0; i < numScalars; i++)
+		m_hScalars[i] = RandomValue<T>();
+	m_hResult.resize(m_ArraySize);
+	m_hGPUResult.resize(m_ArraySize);
+
+	//device resources
+	cl_int clError;
+	m_dInputs.resize(numInputs);
+	for(unsigned int i = 0; i < numInputs; i++)
+	{
+		if(!m_dInputs[i].Create(Context, CL_MEM_READ_ONLY, m_ArraySize))
+			return false;
+	}
+	if(!m_dResult.Create(Context, CL_MEM_WRITE_ONLY, m_ArraySize))
+		return false;
+
+	//generate the fused kernel, an identical expression is only compiled once
+	string programCode = m_Expression.GenerateKernel("FusedElementwise", GetTypeName());
+	m_Program.Reset(CLUtil::BuildCachedCLProgram(Device, Context, programCode));
+	if(m_Program == nullptr)
+	{
+		cerr << "Generated kernel:" << endl << programCode << endl;
+		return false;
+	}
+
+	m_Kernel.Reset(clCreateKernel(m_Program, "FusedElementwise", &clError));
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: FusedElementwise");
+
+	//arguments: inputs, output, scalars, number of elements
+	cl_uint arg = 0;
+	clError = CL_SUCCESS;
+	for(unsigned int i = 0; i < numInputs; i++)
+		clError |= clSetKernelArg(m_Kernel, arg++, sizeof(cl_mem), m_dInputs[i].GetAddressOf());
+	clError |= clSetKernelArg(m_Kernel, arg++, sizeof(cl_mem), m_dResult.GetAddressOf());
+	for(unsigned int i = 0; i < numScalars; i++)
+		clError |= clSetKernelArg(m_Kernel, arg++, sizeof(T), (void*)&m_hScalars[i]);
+	cl_uint arraySize = cl_uint(m_ArraySize);
+	clError |= clSetKernelArg(m_Kernel, arg++, sizeof(cl_uint), (void*)&arraySize);
+	V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: FusedElementwise");
+
+	return true;
+}
+
+template<typename T>
+void CFusedElementwiseTask<T>::ReleaseResources()
+{
+	//CPU resources
+	m_hInputs.clear();
+	m_hScalars.clear();
+	m_hResult.clear();
+	m_hGPUResult.clear();
+
+	//GPU resources
+	m_dInputs.clear();
+	m_dResult.Release();
+
+	m_Kernel.Reset();
+	m_Program.Reset();
+}
+
+template<typename T>
+void CFusedElementwiseTask<T>::ComputeCPU()
+{
+	vector<const T*> inputs(m_hInputs.size());
+	for(size_t i = 0; i < m_hInputs.size(); i++)
+		inputs[i] = &m_hInputs[i][0];
+
+	m_Expression.Evaluate(inputs, m_hScalars, m_ArraySize, &m_hResult[0]);
+}
+
+template<typename T>
+void CFusedElementwiseTask<T>::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	for(size_t i = 0; i < m_dInputs.size(); i++)
+	{
+		clErr = clEnqueueWriteBuffer(CommandQueue, m_dInputs[i], CL_FALSE, 0, m_ArraySize * sizeof(T), &m_hInputs[i][0], 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error copying data from host to device!");
+	}
+
+	size_t globalWorkSize = CLUtil::GetGlobalWorkSize(m_ArraySize, LocalWorkSize[0]);
+	double ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, LocalWorkSize, m_Iterations);
+
+	//bytes moved by the fused kernel, and by the same chain with one pass per operation
+	double fusedBytes = double(m_Expression.GetFusedAccessesPerElement()) * sizeof(T) * m_ArraySize;
+	double unfusedBytes = double(m_Expression.GetUnfusedAccessesPerElement()) * sizeof(T) * m_ArraySize;
+	cout << endl << "Fused " << GetTypeName() << " kernel executed in " << ms << " ms ("
+		<< fusedBytes * 1.0e-6 / ms << " GB/s), memory traffic " << fusedBytes / (1024 * 1024) << " MB instead of "
+		<< unfusedBytes / (1024 * 1024) << " MB unfused." << endl;
+
+	clErr = clEnqueueReadBuffer(CommandQueue, m_dResult, CL_TRUE, 0, m_ArraySize * sizeof(T), &m_hGPUResult[0], 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error reading data back from device");
+}
+
+template<typename T>
+bool CFusedElementwiseTask<T>::ValidateResults()
+{
+	for(size_t i = 0; i < m_ArraySize; i++)
+	{
+		// the device may contract a * b + c into a fused multiply-add, so floats get a small tolerance
+		double ref = double(m_hResult[i]);
+		if(fabs(double(m_hGPUResult[i]) - ref) > (numeric_limits<T>::is_integer ? 0.0 : 1.0e-5 * max(1.0, fabs(ref))))
+		{
+			cout << "Mismatch at element " << i << ": " << m_hGPUResult[i] << " (expected " << m_hResult[i] << ")" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+template class CFusedElementwiseTask<cl_int>;
+template class CFusedElementwiseTask<cl_float>;
+
+///////////////////////////////////////////////////////////////////////////////
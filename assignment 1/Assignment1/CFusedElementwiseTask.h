@@ -0,0 +1,80 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CFUSED_ELEMENTWISE_TASK_H
+#define _CFUSED_ELEMENTWISE_TASK_H
+
+#include "../../Common/IComputeTask.h"
+#include "../../Common/CLHandles.h"
+
+#include "CElementwiseExpression.h"
+
+#include <vector>
+
+//! A1/T1: Generalized vector addition
+/*!
+	Evaluates an arbitrary elementwise expression over arrays of ArraySize elements
+	with a single generated kernel. T is cl_int or cl_float.
+*/
+template<typename T>
+class CFusedElementwiseTask : public IComputeTask
+{
+public:
+	CFusedElementwiseTask(size_t ArraySize, const CElementwiseExpression& Expression);
+	virtual ~CFusedElementwiseTask();
+
+	//! Number of timed runs of the kernel
+	void SetIterations(unsigned int Iterations) { m_Iterations = Iterations; }
+
+	// IComputeTask
+
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+	//! OpenCL name of the element type
+	static const char* GetTypeName();
+
+	size_t						m_ArraySize;
+	CElementwiseExpression		m_Expression;
+	unsigned int				m_Iterations = 1000;
+
+	//input arrays and scalars on the CPU
+	std::vector<std::vector<T> >	m_hInputs;
+	std::vector<T>					m_hScalars;
+	std::vector<T>					m_hResult;
+	std::vector<T>					m_hGPUResult;
+
+	//arrays on the GPU
+	std::vector<DeviceBuffer<T> >	m_dInputs;
+	DeviceBuffer<T>					m_dResult;
+
+	//OpenCL program and kernel
+	CLProgram					m_Program;
+	CLKernel					m_Kernel;
+};
+
+#endif // _CFUSED_ELEMENTWISE_TASK_H
@@ -5,20 +5,85 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CMatrixRotateTask.h"
 
-#include "../Common/CLUtil.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
 
 #include <string.h>
+#include <sstream>
+#include <algorithm>
 
 using namespace std;
 
+// the cycle leaders of the in-place transposition may take at most this fraction of a matrix
+#define MAX_CYCLE_TABLE_FRACTION 16
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache-blocked CPU reference
+
+//! Copies every element of a SizeX x SizeY matrix to Out[Base + x * StrideX + y * StrideY].
+/*!
+	Reading row by row while writing column by column would touch a new cache line
+	for every written element. Processing the matrix in small square blocks keeps
+	the written lines in the cache until they are filled up.
+*/
+template<typename T>
+static void PermuteBlocked(const T* In, T* Out, unsigned int SizeX, unsigned int SizeY,
+	ptrdiff_t Base, ptrdiff_t StrideX, ptrdiff_t StrideY)
+{
+	// at least one cache line per block row
+	const unsigned int blockSize = max<unsigned int>(16, 64 / sizeof(T));
+
+	for(unsigned int by = 0; by < SizeY; by += blockSize)
+	{
+		unsigned int endY = min(SizeY, by + blockSize);
+		for(unsigned int bx = 0; bx < SizeX; bx += blockSize)
+		{
+			unsigned int endX = min(SizeX, bx + blockSize);
+			for(unsigned int y = by; y < endY; y++)
+			{
+				const T* src = In + size_t(y) * SizeX;
+				T* dst = Out + Base + ptrdiff_t(y) * StrideY;
+				for(unsigned int x = bx; x < endX; x++)
+					dst[ptrdiff_t(x) * StrideX] = src[x];
+			}
+		}
+	}
+}
+
+template<typename T>
+static void RotateBatch(const cl_uchar* In, cl_uchar* Out, unsigned int SizeX, unsigned int SizeY,
+	size_t BatchSize, CMatrixRotateTask::ERotationMode Mode)
+{
+	const ptrdiff_t w = SizeX, h = SizeY;
+	ptrdiff_t base, strideX, strideY;
+	switch(Mode)
+	{
+	case CMatrixRotateTask::ROTATE_90:	base = h - 1;				strideX = h;	strideY = -1;	break;
+	case CMatrixRotateTask::ROTATE_180:	base = (h - 1) * w + w - 1;	strideX = -1;	strideY = -w;	break;
+	case CMatrixRotateTask::ROTATE_270:	base = (w - 1) * h;			strideX = -h;	strideY = 1;	break;
+	default:							base = 0;					strideX = h;	strideY = 1;	break;
+	}
+
+	const size_t matrixSize = size_t(SizeX) * SizeY;
+	for(size_t i = 0; i < BatchSize; i++)
+	{
+		PermuteBlocked(reinterpret_cast<const T*>(In) + i * matrixSize, reinterpret_cast<T*>(Out) + i * matrixSize,
+			SizeX, SizeY, base, strideX, strideY);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CMatrixRotateTask
 
-CMatrixRotateTask::CMatrixRotateTask(size_t SizeX, size_t SizeY)
-	:m_SizeX(static_cast<unsigned>(SizeX)), m_SizeY(static_cast<unsigned>(SizeY)), m_hM(NULL), m_hMR(NULL), m_dM(NULL),
-	m_dMR(NULL), m_hGPUResultNaive(NULL), m_hGPUResultOpt(NULL), m_Program(NULL),
-	m_NaiveKernel(NULL), m_OptimizedKernel(NULL)
+CMatrixRotateTask::CMatrixRotateTask(size_t SizeX, size_t SizeY, size_t TileSize[2], ERotationMode Mode,
+	size_t ElementSize, size_t BatchSize, bool InPlace)
+	:m_SizeX(static_cast<unsigned>(SizeX)), m_SizeY(static_cast<unsigned>(SizeY)), m_Mode(Mode),
+	m_ElementSize(ElementSize), m_BatchSize(BatchSize), m_InPlace(InPlace), m_Iterations(100), m_hM(NULL), m_hMR(NULL),
+	m_hGPUResultNaive(NULL), m_hGPUResultOpt(NULL), m_NumCycles(0)
 {
+	m_TileSize[0] = TileSize[0];
+	m_TileSize[1] = TileSize[1];
 }
 
 CMatrixRotateTask::~CMatrixRotateTask()
@@ -28,20 +93,121 @@ CMatrixRotateTask::~CMatrixRotateTask()
 
 bool CMatrixRotateTask::InitResources(cl_device_id Device, cl_context Context)
 {
+	const char* elementType = NULL;
+	switch(m_ElementSize)
+	{
+	case 1: elementType = "uchar"; break;
+	case 2: elementType = "ushort"; break;
+	case 4: elementType = "uint"; break;
+	case 8: elementType = "uint2"; break;
+	case 16: elementType = "uint4"; break;
+	default:
+		cerr<<"Unsupported element size: "<<m_ElementSize<<" bytes."<<endl;
+		return false;
+	}
+
+	//the padded tile(s) of the optimized kernels have to fit into the local memory
+	//(the in-place transposition holds two tiles)
+	cl_ulong localMemorySize = 0;
+	clGetDeviceInfo(Device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMemorySize, NULL);
+	if((m_InPlace ? 2 : 1) * m_TileSize[0] * (m_TileSize[0] + 1) * m_ElementSize > localMemorySize)
+	{
+		cerr<<"A tile of "<<m_TileSize[0]<<" x "<<m_TileSize[0]<<" elements does not fit into the local memory."<<endl;
+		return false;
+	}
+
 	//CPU resources
-	m_hM = new float[m_SizeX * m_SizeY];
-	m_hMR = new float[m_SizeX * m_SizeY];
-	m_hGPUResultNaive = new float[m_SizeX * m_SizeY];
-	m_hGPUResultOpt = new float[m_SizeX * m_SizeY];
+	size_t dataSize = GetDataSize();
+	m_hM = new cl_uchar[dataSize];
+	m_hMR = new cl_uchar[dataSize];
+	if(!m_InPlace)
+		m_hGPUResultNaive = new cl_uchar[dataSize];
+	m_hGPUResultOpt = new cl_uchar[dataSize];
+
+	//fill the matrices with random bytes
+	for(size_t i = 0; i < dataSize; i++)
+	{
+		m_hM[i] = cl_uchar(rand());
+	}
 
-	//fill the matrix with random floats
-	for(unsigned int i = 0; i < m_SizeX * m_SizeY; i++)
+	//device resources
+	cl_int clError;
+	if(!m_dM.Create(Context, m_InPlace ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY, dataSize))
+		return false;
+	if(!m_InPlace)
 	{
-		m_hM[i] = float(rand()) / float(RAND_MAX);
+		if(!m_dMR.Create(Context, CL_MEM_WRITE_ONLY, dataSize))
+			return false;
+	}
+	else if(m_SizeX != m_SizeY && m_Mode != ROTATE_180)
+	{
+		if(size_t(m_SizeX) * m_SizeY > 0xFFFFFFFFu)
+		{
+			cerr<<"The in-place transposition of non-square matrices is limited to 2^32 elements."<<endl;
+			return false;
+		}
+
+		//the table of cycle leaders must stay small compared to the matrix, or in-place is pointless
+		size_t maxLeaders = size_t(m_SizeX) * m_SizeY * m_ElementSize / (MAX_CYCLE_TABLE_FRACTION * sizeof(cl_uint));
+		vector<cl_uint> leaders;
+		if(!FindTranspositionCycles(leaders, maxLeaders))
+		{
+			cerr<<"The in-place transposition of "<<m_SizeX<<" x "<<m_SizeY<<" matrices has too many cycles,"
+				<<" use the out-of-place mode."<<endl;
+			return false;
+		}
+		m_NumCycles = cl_uint(leaders.size());
+		if(m_NumCycles > 0)
+		{
+			if(!m_dCycleLeaders.Create(Context, CL_MEM_READ_ONLY, leaders.size(), &leaders[0]))
+				return false;
+		}
 	}
 
-	// TO DO: allocate all device resources here
-	
+	//load and compile kernels
+	string programCode;
+	if(!CLUtil::LoadProgramSourceToMemory("MatrixRot.cl", programCode))
+		return false;
+
+	//the element type, the permutation and the tile size are compile time constants of the kernels
+	stringstream compileOptions;
+	compileOptions<<"-D ELEM_TYPE="<<elementType
+		<<" -D ROTATION_MODE="<<int(m_Mode)
+		<<" -D TILE_DIM="<<m_TileSize[0]<<" -D TILE_ROWS="<<m_TileSize[1];
+
+	m_Program.Reset(CLUtil::BuildCLProgramFromMemory(Device, Context, programCode, compileOptions.str()));
+	if(m_Program == nullptr)
+		return false;
+
+	if(m_InPlace)
+	{
+		m_TransposeInPlaceKernel.Reset(clCreateKernel(m_Program, "MatrixTransposeInPlace", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: MatrixTransposeInPlace");
+		m_TransposeCyclesKernel.Reset(clCreateKernel(m_Program, "MatrixTransposeCycles", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: MatrixTransposeCycles");
+		m_FlipInPlaceKernel.Reset(clCreateKernel(m_Program, "MatrixFlipInPlace", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: MatrixFlipInPlace");
+
+		//the size arguments of the flip kernel depend on the pass and are set in ComputeGPUInPlace()
+		clError  = SetArgs(m_TransposeInPlaceKernel, m_dM, m_SizeX);
+		clError |= SetArgs(m_TransposeCyclesKernel, m_dM, m_dCycleLeaders, m_NumCycles, m_SizeX, m_SizeY);
+		clError |= SetArgs(m_FlipInPlaceKernel, m_dM);
+		V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: in-place kernels");
+
+		return true;
+	}
+
+	m_NaiveKernel.Reset(clCreateKernel(m_Program, "MatrixRotNaive", &clError));
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: MatrixRotNaive");
+	m_OptimizedKernel.Reset(clCreateKernel(m_Program, "MatrixRotOptimized", &clError));
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: MatrixRotOptimized");
+
+	//bind kernel arguments
+	clError = SetArgs(m_NaiveKernel, m_dM, m_dMR, m_SizeX, m_SizeY);
+	V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: MatrixRotNaive");
+
+	clError = SetArgs(m_OptimizedKernel, m_dM, m_dMR, m_SizeX, m_SizeY);
+	V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: MatrixRotOptimized");
 
 	return true;
 }
@@ -54,57 +220,193 @@ void CMatrixRotateTask::ReleaseResources()
 	SAFE_DELETE_ARRAY(m_hGPUResultNaive);
 	SAFE_DELETE_ARRAY(m_hGPUResultOpt);
 
-	// TO DO: release device resources
+	//device resources
+	m_dM.Release();
+	m_dMR.Release();
+	m_dCycleLeaders.Release();
 
+	m_NaiveKernel.Reset();
+	m_OptimizedKernel.Reset();
+	m_TransposeInPlaceKernel.Reset();
+	m_TransposeCyclesKernel.Reset();
+	m_FlipInPlaceKernel.Reset();
+	m_Program.Reset();
 }
 
 void CMatrixRotateTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
-	// TO DO: write input data to the GPU
+	if(m_InPlace)
+	{
+		ComputeGPUInPlace(CommandQueue);
+		return;
+	}
+
+	size_t dataSize = GetDataSize();
 
-	//launch kernels
+	//every element is read and written once
+	double gigaBytes = 2.0 * 1.0e-9 * double(dataSize);
 
-	// TO DO: detemine the necessary number of global work items
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dM, CL_FALSE, 0, dataSize, m_hM, 0, NULL, NULL),
+		"Error copying data from host (m_hM) to device (m_dM)!");
+
+	//naive kernel: one work-item per input element
+	size_t naiveLocalWorkSize[3] = {LocalWorkSize[0], LocalWorkSize[1], 1};
+	size_t naiveGlobalWorkSize[3] = {
+		CLUtil::GetGlobalWorkSize(m_SizeX, naiveLocalWorkSize[0]),
+		CLUtil::GetGlobalWorkSize(m_SizeY, naiveLocalWorkSize[1]),
+		m_BatchSize
+	};
+
+	double time = CLUtil::ProfileKernel(CommandQueue, m_NaiveKernel, 3, naiveGlobalWorkSize, naiveLocalWorkSize, m_Iterations);
+	cout<<"Executed naive kernel in "<<time<<" ms ("<<gigaBytes / (1.0e-3 * time)<<" GB/s)."<<endl;
 
-	double time = 0;
-	
-	//naive kernel
-	// TO DO: time = CLUtil::ProfileKernel...
-	cout<<"Executed naive kernel in "<<time<<" ms."<<endl;
-	
-	// TO DO: read back the results synchronously.
 	//this command has to be blocking, since we want to check the valid data
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dMR, CL_TRUE, 0, dataSize, m_hGPUResultNaive, 0, NULL, NULL),
+		"Error reading back the results of the naive kernel!");
 
-	//optimized kernel
-	
-	// TO DO: allocate shared (local) memory for the kernel
+	//optimized kernel: one work-group per TILE_DIM x TILE_DIM tile of the output,
+	//each work-item moves TILE_DIM / TILE_ROWS elements
+	size_t optLocalWorkSize[3] = {m_TileSize[0], m_TileSize[1], 1};
+	size_t optGlobalWorkSize[3] = {
+		CLUtil::GetGlobalWorkSize(GetResultSizeX(), m_TileSize[0]),
+		CLUtil::GetGlobalWorkSize(GetResultSizeY(), m_TileSize[0]) / m_TileSize[0] * m_TileSize[1],
+		m_BatchSize
+	};
 
-	// run kernel
-	// TO DO: time = GLUtil::ProfileKernel...
-	cout<<"Executed optimized kernel in "<<time<<" ms."<<endl;
+	time = CLUtil::ProfileKernel(CommandQueue, m_OptimizedKernel, 3, optGlobalWorkSize, optLocalWorkSize, m_Iterations);
+	cout<<"Executed optimized kernel in "<<time<<" ms ("<<gigaBytes / (1.0e-3 * time)<<" GB/s)."<<endl;
 
-	// TO DO: read back the data to the host
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dMR, CL_TRUE, 0, dataSize, m_hGPUResultOpt, 0, NULL, NULL),
+		"Error reading back the results of the optimized kernel!");
 }
 
-void CMatrixRotateTask::ComputeCPU()
+void CMatrixRotateTask::ComputeGPUInPlace(cl_command_queue CommandQueue)
+{
+	size_t dataSize = GetDataSize();
+	cl_int clErr;
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dM, CL_TRUE, 0, dataSize, m_hM, 0, NULL, NULL),
+		"Error copying data from host (m_hM) to device (m_dM)!");
+
+	//every pass modifies the matrices, so we time exactly one rotation
+	CTimer timer;
+	timer.Start();
+
+	//the dimensions of the matrices after the transposition pass
+	cl_uint sizeX = m_SizeX;
+	cl_uint sizeY = m_SizeY;
+
+	if(m_Mode != ROTATE_180)
+	{
+		if(m_SizeX == m_SizeY)
+		{
+			size_t nTiles = CLUtil::GetGlobalWorkSize(m_SizeX, m_TileSize[0]) / m_TileSize[0];
+			size_t localWorkSize[3] = {m_TileSize[0], m_TileSize[1], 1};
+			size_t globalWorkSize[3] = {nTiles * m_TileSize[0], nTiles * m_TileSize[1], m_BatchSize};
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_TransposeInPlaceKernel, 3, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+			V_RETURN_CL(clErr, "Error executing kernel MatrixTransposeInPlace!");
+		}
+		else if(m_NumCycles > 0)
+		{
+			size_t localWorkSize[2] = {64, 1};
+			size_t globalWorkSize[2] = {CLUtil::GetGlobalWorkSize(m_NumCycles, localWorkSize[0]), m_BatchSize};
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_TransposeCyclesKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+			V_RETURN_CL(clErr, "Error executing kernel MatrixTransposeCycles!");
+		}
+		swap(sizeX, sizeY);
+	}
+
+	if(m_Mode != TRANSPOSE)
+	{
+		clErr = SetArgsFrom(m_FlipInPlaceKernel, 1, sizeX, sizeY);
+		V_RETURN_CL(clErr, "Failed to set Kernel args: MatrixFlipInPlace");
+
+		size_t localWorkSize[3] = {m_TileSize[0], m_TileSize[1], 1};
+		size_t globalWorkSize[3] = {
+			CLUtil::GetGlobalWorkSize(sizeX, localWorkSize[0]),
+			CLUtil::GetGlobalWorkSize(sizeY, localWorkSize[1]),
+			m_BatchSize
+		};
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_FlipInPlaceKernel, 3, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing kernel MatrixFlipInPlace!");
+	}
+
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+	timer.Stop();
+
+	double time = timer.GetElapsedMilliseconds();
+	cout<<"Executed in-place rotation in "<<time<<" ms ("<<2.0 * 1.0e-9 * double(dataSize) / (1.0e-3 * time)<<" GB/s)."<<endl;
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dM, CL_TRUE, 0, dataSize, m_hGPUResultOpt, 0, NULL, NULL),
+		"Error reading back the results of the in-place rotation!");
+}
+
+bool CMatrixRotateTask::FindTranspositionCycles(vector<cl_uint>& Leaders, size_t MaxLeaders)
 {
-	for(unsigned int x = 0; x < m_SizeX; x++)
+	// the first and the last element never move
+	const size_t last = size_t(m_SizeX) * m_SizeY - 1;
+	vector<bool> visited(last + 1, false);
+
+	for(size_t i = 1; i < last; i++)
 	{
-		for(unsigned int y = 0; y < m_SizeY; y++)
+		if(visited[i])
+			continue;
+
+		size_t j = i;
+		do
+		{
+			visited[j] = true;
+			j = (j * m_SizeY) % last;
+		} while(j != i);
+
+		if((i * m_SizeY) % last != i)
 		{
-			m_hMR[ x * m_SizeY + (m_SizeY - y - 1) ] = m_hM[ y * m_SizeX + x ];
+			if(Leaders.size() == MaxLeaders)
+				return false;
+			Leaders.push_back(cl_uint(i));
 		}
 	}
+	return true;
+}
+
+void CMatrixRotateTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	switch(m_ElementSize)
+	{
+	case 1: RotateBatch<cl_uchar>(m_hM, m_hMR, m_SizeX, m_SizeY, m_BatchSize, m_Mode); break;
+	case 2: RotateBatch<cl_ushort>(m_hM, m_hMR, m_SizeX, m_SizeY, m_BatchSize, m_Mode); break;
+	case 4: RotateBatch<cl_uint>(m_hM, m_hMR, m_SizeX, m_SizeY, m_BatchSize, m_Mode); break;
+	case 8: RotateBatch<cl_ulong>(m_hM, m_hMR, m_SizeX, m_SizeY, m_BatchSize, m_Mode); break;
+	case 16: RotateBatch<cl_uint4>(m_hM, m_hMR, m_SizeX, m_SizeY, m_BatchSize, m_Mode); break;
+	}
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds();
+	cout<<"  CPU time: "<<ms<<" ms ("<<2.0 * 1.0e-9 * double(GetDataSize()) / (1.0e-3 * ms)<<" GB/s)."<<endl;
 }
 
 bool CMatrixRotateTask::ValidateResults()
 {
-	if(!(memcmp(m_hMR, m_hGPUResultNaive, m_SizeX * m_SizeY * sizeof(float)) == 0))
+	if(m_InPlace)
+	{
+		if(!(memcmp(m_hMR, m_hGPUResultOpt, GetDataSize()) == 0))
+		{
+			cout<<"Results of the in-place rotation are incorrect!"<<endl;
+			return false;
+		}
+		return true;
+	}
+
+	if(!(memcmp(m_hMR, m_hGPUResultNaive, GetDataSize()) == 0))
 	{
 		cout<<"Results of the naive kernel are incorrect!"<<endl;
 		return false;
 	}
-	if(!(memcmp(m_hMR, m_hGPUResultOpt, m_SizeX * m_SizeY * sizeof(float)) == 0))
+	if(!(memcmp(m_hMR, m_hGPUResultOpt, GetDataSize()) == 0))
 	{
 		cout<<"Results of the optimized kernel are incorrect!"<<endl;
 		return false;
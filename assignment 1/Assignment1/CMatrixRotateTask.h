@@ -20,15 +20,48 @@
 #ifndef _CMATRIX_ROTATE_TASK_H
 #define _CMATRIX_ROTATE_TASK_H
 
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/CLHandles.h"
+
+#include <vector>
 
 //! A1/T2: Matrix rotation
+/*!
+	Rotates (or transposes) a batch of SizeX x SizeY matrices in one launch.
+	The elements are treated as raw data of ElementSize bytes (1, 2, 4, 8 or 16),
+	so the same code moves single channel floats or packed RGBA pixels.
+
+	In the in-place mode the result overwrites the input on the device, which halves
+	the device memory. Square matrices are transposed by swapping tile pairs across
+	the diagonal, other shapes by following the cycles of the permutation.
+	Rotations add a mirroring pass after the transposition.
+
+	The cycle following needs a table of the cycle leaders (one cl_uint per cycle), which
+	is limited to 1/16 of a matrix (MAX_CYCLE_TABLE_FRACTION), shapes with more cycles are
+	rejected. Every cycle is walked serially by one work-item, so the parallelism is the
+	number of cycles (50 for 1920 x 1080) and the longest cycle bounds the run time:
+	this variant saves device memory, it is not faster than the out-of-place kernels.
+*/
 class CMatrixRotateTask : public IComputeTask
 {
 public:
-	CMatrixRotateTask(size_t SizeX, size_t SizeY);
+	//! Supported permutations, rotations are clockwise
+	enum ERotationMode
+	{
+		ROTATE_90 = 0,
+		ROTATE_180,
+		ROTATE_270,
+		TRANSPOSE
+	};
+
+	//! TileSize is the work-group size of the optimized kernel (tile width, rows per work-group)
+	CMatrixRotateTask(size_t SizeX, size_t SizeY, size_t TileSize[2], ERotationMode Mode = ROTATE_90,
+		size_t ElementSize = sizeof(float), size_t BatchSize = 1, bool InPlace = false);
 	virtual ~CMatrixRotateTask();
 
+	//! Number of timed runs of each out-of-place kernel (the in-place rotation is timed once)
+	void SetIterations(unsigned int Iterations) { m_Iterations = Iterations; }
+
 	// IComputeTask
 	virtual bool InitResources(cl_device_id Device, cl_context Context);
 	
@@ -41,26 +74,54 @@ public:
 	virtual bool ValidateResults();
 
 protected:
+	//! Dimensions of the rotated matrix
+	unsigned int GetResultSizeX() const { return m_Mode == ROTATE_180 ? m_SizeX : m_SizeY; }
+	unsigned int GetResultSizeY() const { return m_Mode == ROTATE_180 ? m_SizeY : m_SizeX; }
+
+	//! Size of the whole batch in bytes
+	size_t GetDataSize() const { return size_t(m_SizeX) * m_SizeY * m_ElementSize * m_BatchSize; }
+
+	void ComputeGPUInPlace(cl_command_queue CommandQueue);
+
+	//! Collects the smallest index of every cycle of the in-place transposition (fixed points excluded)
+	/*!
+		Returns false if there are more than MaxLeaders cycles.
+	*/
+	bool FindTranspositionCycles(std::vector<cl_uint>& Leaders, size_t MaxLeaders);
+
 	//NOTE: we have two memory address spaces, so we mark pointers with a prefix
 	//to avoid confusions: 'h' - host, 'd' - device
 
 	unsigned int		m_SizeX;
 	unsigned int		m_SizeY;
+	size_t				m_TileSize[2];
+	ERotationMode		m_Mode;
+	size_t				m_ElementSize;
+	size_t				m_BatchSize;
+	bool				m_InPlace;
+	unsigned int		m_Iterations;
 
-	//float data on the CPU
-	//M: original matrix, MR: rotated matrix
-	float				*m_hM, *m_hMR;
+	//raw element data on the CPU
+	//M: original matrices, MR: rotated matrices
+	cl_uchar			*m_hM, *m_hMR;
 
 	//pointers on the GPU
-	//(result buffers for both kernels)
-	cl_mem				m_dM, m_dMR;
-	//(..and a pointer to read back the result)
-	float				*m_hGPUResultNaive, *m_hGPUResultOpt;
+	//(result buffers for both kernels, m_dMR is not used in the in-place mode)
+	DeviceBuffer<cl_uchar>	m_dM, m_dMR;
+	//(..and a pointer to read back the result, the in-place result goes to m_hGPUResultOpt)
+	cl_uchar			*m_hGPUResultNaive, *m_hGPUResultOpt;
+
+	//in-place transposition of non-square matrices
+	DeviceBuffer<cl_uint>	m_dCycleLeaders;
+	cl_uint				m_NumCycles;
 
 	//OpenCL program and kernels
-	cl_program			m_Program;
-	cl_kernel			m_NaiveKernel;
-	cl_kernel			m_OptimizedKernel;
+	CLProgram			m_Program;
+	CLKernel			m_NaiveKernel;
+	CLKernel			m_OptimizedKernel;
+	CLKernel			m_TransposeInPlaceKernel;
+	CLKernel			m_TransposeCyclesKernel;
+	CLKernel			m_FlipInPlaceKernel;
 };
 
 #endif // _CMATRIX_ROTATE_TASK_H
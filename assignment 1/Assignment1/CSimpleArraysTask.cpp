@@ -5,9 +5,11 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CSimpleArraysTask.h"
 
-#include "../Common/CLUtil.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CTimer.h"
 
 #include <string.h>
+#include <sstream>
 
 //including signal for "debugging"(showing if error) from application
 #include <csignal>
@@ -18,8 +20,8 @@ using namespace std;
 ///////////////////////////////////////////////////////////////////////////////
 // CSimpleArraysTask
 
-CSimpleArraysTask::CSimpleArraysTask(size_t ArraySize)
-	: m_ArraySize(ArraySize)
+CSimpleArraysTask::CSimpleArraysTask(size_t ArraySize, bool Sweep, double TheoreticalBandwidth)
+	: m_ArraySize(ArraySize), m_Sweep(Sweep), m_TheoreticalBandwidth(TheoreticalBandwidth)
 {
 }
 
@@ -34,7 +36,6 @@ bool CSimpleArraysTask::InitResources(cl_device_id Device, cl_context Context)
 	m_hA = new int[m_ArraySize];
 	m_hB = new int[m_ArraySize];
 	m_hC = new int[m_ArraySize];
-	m_hGPUResult = new int[m_ArraySize];
 	
 	//fill A and B with random integers
 	for(unsigned int i = 0; i < m_ArraySize; i++)
@@ -50,34 +51,56 @@ bool CSimpleArraysTask::InitResources(cl_device_id Device, cl_context Context)
 
 	//TO DO: allocate arrays!
 	cl_int clError;
-	m_dA = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_int) * m_ArraySize, NULL, &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create device-buffer for m_dA");
-	m_dB = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_int) * m_ArraySize, NULL, &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create device-buffer for m_dB");
-	m_dC = clCreateBuffer(Context, CL_MEM_WRITE_ONLY, sizeof(cl_int) * m_ArraySize, NULL, &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create device-buffer for m_dC");
+	if(!m_dA.Create(Device, Context, CL_MEM_READ_ONLY, sizeof(cl_int) * m_ArraySize)) return false;
+	if(!m_dB.Create(Device, Context, CL_MEM_READ_ONLY, sizeof(cl_int) * m_ArraySize)) return false;
+	if(!m_dC.Create(Device, Context, CL_MEM_WRITE_ONLY, sizeof(cl_int) * m_ArraySize)) return false;
+	cout << "Host-visible buffers: " << (m_dA.IsZeroCopy() ? "zero-copy (unified memory)" : "pinned host memory") << endl;
 
 
 	/////////////////////////////////////////
 	// Sect. 4.6.
 	
 	//TO DO: load and compile kernels
-	size_t programSize = 0;
 	string programCode;
-	if (!CLUtil::LoadProgramSourceToMemory("../../Assignment1/VectorAdd.cl", programCode)) return false;
-	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	if (!CLUtil::LoadProgramSourceToMemory("VectorAdd.cl", programCode)) return false;
+	m_Program.Reset(CLUtil::BuildCLProgramFromMemory(Device, Context, programCode));
 	if (m_Program == nullptr) return false;
 	//std::raise(SIGINT);
-	m_Kernel = clCreateKernel(m_Program, "VecAdd", &clError);
+	m_Kernel.Reset(clCreateKernel(m_Program, "VecAdd", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: VecAdd");
 	
 	//TO DO: bind kernel arguments
-	clError = clSetKernelArg(m_Kernel, 0, sizeof(cl_mem), (void*)&m_dA);
-	clError = clSetKernelArg(m_Kernel, 1, sizeof(cl_mem), (void*)&m_dB);
-	clError = clSetKernelArg(m_Kernel, 2, sizeof(cl_mem), (void*)&m_dC);
-	clError = clSetKernelArg(m_Kernel, 3, sizeof(cl_int), (void*)&m_ArraySize);
+	cl_int numElements = cl_int(m_ArraySize);
+	clError  = clSetKernelArg(m_Kernel, 0, sizeof(cl_mem), m_dA.GetMemPtr());
+	clError |= clSetKernelArg(m_Kernel, 1, sizeof(cl_mem), m_dB.GetMemPtr());
+	clError |= clSetKernelArg(m_Kernel, 2, sizeof(cl_mem), m_dC.GetMemPtr());
+	clError |= clSetKernelArg(m_Kernel, 3, sizeof(cl_int), (void*)&numElements);
 	V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: VecAdd");
 
+	if(m_Sweep)
+	{
+		clGetDeviceInfo(Device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &m_MaxWorkGroupSize, NULL);
+		clGetDeviceInfo(Device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &m_ComputeUnits, NULL);
+
+		//one specialized program per vector width
+		for(int i = 0; i < NUM_COARSENING; i++)
+		{
+			stringstream compileOptions;
+			compileOptions << "-D ELEMS_PER_ITEM=" << (1 << i);
+			m_CoarsenedPrograms[i].Reset(CLUtil::BuildCLProgramFromMemory(Device, Context, programCode, compileOptions.str()));
+			if(m_CoarsenedPrograms[i] == nullptr) return false;
+
+			m_CoarsenedKernels[i].Reset(clCreateKernel(m_CoarsenedPrograms[i], "VecAddCoarsened", &clError));
+			V_RETURN_FALSE_CL(clError, "Failed to create kernel: VecAddCoarsened");
+
+			clError  = clSetKernelArg(m_CoarsenedKernels[i], 0, sizeof(cl_mem), m_dA.GetMemPtr());
+			clError |= clSetKernelArg(m_CoarsenedKernels[i], 1, sizeof(cl_mem), m_dB.GetMemPtr());
+			clError |= clSetKernelArg(m_CoarsenedKernels[i], 2, sizeof(cl_mem), m_dC.GetMemPtr());
+			clError |= clSetKernelArg(m_CoarsenedKernels[i], 3, sizeof(cl_int), (void*)&numElements);
+			V_RETURN_FALSE_CL(clError, "Failed to set Kernel args: VecAddCoarsened");
+		}
+	}
+
 
 	return true;
 }
@@ -88,18 +111,24 @@ void CSimpleArraysTask::ReleaseResources()
 	SAFE_DELETE_ARRAY(m_hA);
 	SAFE_DELETE_ARRAY(m_hB);
 	SAFE_DELETE_ARRAY(m_hC);
-	SAFE_DELETE_ARRAY(m_hGPUResult);
 
 	/////////////////////////////////////////////////
 	// Sect. 4.5., 4.6.	
 
 	// TO DO: free resources on the GPU
-	clReleaseMemObject(m_dA);
-	SAFE_DELETE_ARRAY(m_dA);
-	clReleaseMemObject(m_dB);
-	SAFE_DELETE_ARRAY(m_dB);
-	clReleaseMemObject(m_dC);
-	SAFE_DELETE_ARRAY(m_dC);
+	// m_hGPUResult is the mapped m_dC, which is unmapped here
+	m_dA.Release();
+	m_dB.Release();
+	m_dC.Release();
+	m_hGPUResult = nullptr;
+
+	m_Kernel.Reset();
+	m_Program.Reset();
+	for(int i = 0; i < NUM_COARSENING; i++)
+	{
+		m_CoarsenedKernels[i].Reset();
+		m_CoarsenedPrograms[i].Reset();
+	}
 }
 
 void CSimpleArraysTask::ComputeCPU()
@@ -115,11 +144,14 @@ void CSimpleArraysTask::ComputeGPU(cl_context Context, cl_command_queue CommandQ
 	/////////////////////////////////////////////////
 	// Sect. 4.5
 	// TO DO: Write input data to the GPU
-	cl_int clErr;
-	clErr = clEnqueueWriteBuffer(CommandQueue, m_dA, CL_FALSE, 0, m_ArraySize * sizeof(int), m_hA, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error copying data from host (m_hA) to device (m_dA)!");
-	clErr = clEnqueueWriteBuffer(CommandQueue, m_dB, CL_FALSE, 0, m_ArraySize * sizeof(int), m_hB, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error copying data from host (m_hB) to device (m_dB)!");
+	//the inputs are written through the mapped buffers, unmapping them is free on unified memory
+	//and a DMA transfer from pinned memory otherwise
+	int* pA = (int*)m_dA.MapForOverwrite(CommandQueue);
+	int* pB = (int*)m_dB.MapForOverwrite(CommandQueue);
+	if(pA == nullptr || pB == nullptr) return;
+	memcpy(pA, m_hA, m_ArraySize * sizeof(int));
+	memcpy(pB, m_hB, m_ArraySize * sizeof(int));
+	if(!m_dA.Unmap() || !m_dB.Unmap()) return;
 
 
 	/////////////////////////////////////////
@@ -134,24 +166,14 @@ void CSimpleArraysTask::ComputeGPU(cl_context Context, cl_command_queue CommandQ
 	//V_RETURN_CL(clErr, "Error executing kernel");
 
 	double ms;
-	unsigned int iterations = 10000;
-
-	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[0], iterations);
-	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[0] << " and " << iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
-	nGroups = globalWorkSize / LocalWorkSize[1];
-	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[1], iterations);
-	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[1] << " and " << iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
-	nGroups = globalWorkSize / LocalWorkSize[2];
-	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[2], iterations);
-	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[2] << " and " << iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
-	nGroups = globalWorkSize / LocalWorkSize[3];
-	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[3], iterations);
-	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[3] << " and " << iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
-	nGroups = globalWorkSize / LocalWorkSize[4];
-	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[4], iterations);
-	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[4] << " and " << iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
 
-	
+	ms = CLUtil::ProfileKernel(CommandQueue, m_Kernel, 1, &globalWorkSize, &LocalWorkSize[0], m_Iterations);
+	cout << "kernel run with " << nGroups << " groups of size " << LocalWorkSize[0] << " and " << m_Iterations << " iterations " << " executed in " << ms << " miliseconds." << endl;
+
+	// the sweep leaves the result of the best coarsened configuration in m_dC, so it is validated as well
+	if(m_Sweep)
+		SweepWorkSizes(CommandQueue);
+
 
 			// Sect. 4.7.: rewrite the kernel call to use our ProfileKernel()
 			//				utility function to measure execution time.
@@ -162,14 +184,105 @@ void CSimpleArraysTask::ComputeGPU(cl_context Context, cl_command_queue CommandQ
 
 
 	// TO DO: read back results synchronously.
-	//This command has to be blocking, since we need the data
-	clErr = clEnqueueReadBuffer(CommandQueue, m_dC, CL_TRUE, 0, m_ArraySize * sizeof(int), m_hGPUResult, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error reading data back from device");
+	//The map is blocking, since we need the data. The result stays mapped until ReleaseResources().
+	m_hGPUResult = (int*)m_dC.Map(CommandQueue, CL_MAP_READ);
+}
+
+void CSimpleArraysTask::SweepWorkSizes(cl_command_queue CommandQueue)
+{
+	const unsigned int iterations = 100;
+	const size_t localWorkSizes[] = {64, 128, 256, 512, 1024};
+
+	// 2 reads and 1 write per element
+	double dataSize = 3.0 * double(m_ArraySize) * sizeof(cl_int);
+	double copyBandwidth = MeasureCopyBandwidth(CommandQueue);
+
+	cout << endl << "Bandwidth sweep over " << dataSize / (1024 * 1024) << " MB per run" << endl;
+	cout << "  device-to-device copy: " << copyBandwidth << " GB/s";
+	if(m_TheoreticalBandwidth > 0.0)
+		cout << ", theoretical peak: " << m_TheoreticalBandwidth << " GB/s";
+	cout << endl;
+
+	double bestBandwidth = 0.0;
+	int bestCoarsening = -1;
+	size_t bestLocalWorkSize = 0, bestGlobalWorkSize = 0;
+
+	for(int c = 0; c < NUM_COARSENING; c++)
+	{
+		int elemsPerItem = 1 << c;
+
+		size_t kernelWorkGroupSize = m_MaxWorkGroupSize;
+		clGetKernelWorkGroupInfo(m_CoarsenedKernels[c], NULL, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &kernelWorkGroupSize, NULL);
+
+		for(size_t l = 0; l < ARRAYLEN(localWorkSizes); l++)
+		{
+			size_t localWorkSize = localWorkSizes[l];
+			if(localWorkSize > min(m_MaxWorkGroupSize, kernelWorkGroupSize))
+				continue;
+
+			// enough work-groups to keep every compute unit busy, the grid-stride loop covers the rest
+			size_t numVectors = max<size_t>(1, m_ArraySize / elemsPerItem);
+			size_t maxGroups = max<size_t>(1, m_ComputeUnits) * 32;
+			size_t globalWorkSize = min(CLUtil::GetGlobalWorkSize(numVectors, localWorkSize), maxGroups * localWorkSize);
+
+			double ms = CLUtil::ProfileKernel(CommandQueue, m_CoarsenedKernels[c], 1, &globalWorkSize, &localWorkSize, iterations);
+			if(ms <= 0.0)
+				continue;
+			double bandwidth = dataSize * 1.0e-6 / ms;
+
+			cout << "  " << elemsPerItem << " elements/item, local size " << localWorkSize << ", "
+				<< globalWorkSize / localWorkSize << " groups: " << ms << " ms, " << bandwidth << " GB/s ("
+				<< 100.0 * bandwidth / copyBandwidth << "% of copy";
+			if(m_TheoreticalBandwidth > 0.0)
+				cout << ", " << 100.0 * bandwidth / m_TheoreticalBandwidth << "% of peak";
+			cout << ")" << endl;
+
+			if(bandwidth > bestBandwidth)
+			{
+				bestBandwidth = bandwidth;
+				bestCoarsening = c;
+				bestLocalWorkSize = localWorkSize;
+				bestGlobalWorkSize = globalWorkSize;
+			}
+		}
+	}
+
+	if(bestCoarsening < 0)
+	{
+		cerr << "No configuration of the coarsened kernel could be executed." << endl;
+		return;
+	}
+
+	cout << "Best configuration: " << (1 << bestCoarsening) << " elements/item, local size " << bestLocalWorkSize
+		<< ", global size " << bestGlobalWorkSize << " with " << bestBandwidth << " GB/s" << endl;
+
+	// the copy measurement has overwritten m_dC, compute the result once more with the best configuration
+	V_RETURN_CL(clEnqueueNDRangeKernel(CommandQueue, m_CoarsenedKernels[bestCoarsening], 1, NULL, &bestGlobalWorkSize, &bestLocalWorkSize, 0, NULL, NULL),
+		"Error executing kernel VecAddCoarsened!");
+}
+
+double CSimpleArraysTask::MeasureCopyBandwidth(cl_command_queue CommandQueue)
+{
+	const unsigned int iterations = 100;
+	size_t size = m_ArraySize * sizeof(cl_int);
+
+	cl_int clErr = clFinish(CommandQueue);
+	CTimer timer;
+	timer.Start();
+	for(unsigned int i = 0; i < iterations; i++)
+		clErr |= clEnqueueCopyBuffer(CommandQueue, m_dA.GetMem(), m_dC.GetMem(), 0, 0, size, 0, NULL, NULL);
+	clErr |= clFinish(CommandQueue);
+	timer.Stop();
+	V_RETURN_0_CL(clErr, "Error copying buffers on the device");
+
+	// one read and one write per element
+	double ms = timer.GetElapsedMilliseconds() / double(iterations);
+	return 2.0 * double(size) * 1.0e-6 / ms;
 }
 
 bool CSimpleArraysTask::ValidateResults()
 {
-	return (memcmp(m_hC, m_hGPUResult, m_ArraySize * sizeof(float)) == 0);
+	return (m_hGPUResult != nullptr && memcmp(m_hC, m_hGPUResult, m_ArraySize * sizeof(int)) == 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -20,15 +20,27 @@
 #ifndef _CSIMPLE_ARRAYS_TASK_H
 #define _CSIMPLE_ARRAYS_TASK_H
 
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/CHostBuffer.h"
+#include "../../Common/CLHandles.h"
 
 //! A1/T1: Simple vector addition
+/*!
+	In the sweep mode the task also runs the coarsened kernel with 1, 2, 4 and 8 elements
+	per work-item over a range of local sizes, and reports the bandwidth of every configuration.
+	As the addition does nothing but stream memory, the best configuration is the
+	bandwidth reference for the other kernels.
+*/
 class CSimpleArraysTask : public IComputeTask
 {
 public:
-	CSimpleArraysTask(size_t ArraySize);
+	//! TheoreticalBandwidth in GB/s, 0 if unknown (the device-to-device copy is always used as a reference)
+	CSimpleArraysTask(size_t ArraySize, bool Sweep = false, double TheoreticalBandwidth = 0.0);
 	virtual ~CSimpleArraysTask();
 
+	//! Number of timed runs of the kernel (the sweep uses a fixed number per configuration)
+	void SetIterations(unsigned int Iterations) { m_Iterations = Iterations; }
+
 	// IComputeTask
 	
 	virtual bool InitResources(cl_device_id Device, cl_context Context);
@@ -42,22 +54,39 @@ public:
 	virtual bool ValidateResults();
 
 protected:
+	//! Runs all configurations of the coarsened kernel and reports the fastest one
+	void SweepWorkSizes(cl_command_queue CommandQueue);
+
+	//! Bandwidth of clEnqueueCopyBuffer in GB/s, the practical peak of the device memory
+	double MeasureCopyBandwidth(cl_command_queue CommandQueue);
+
 	//NOTE: we have two memory address spaces, so we mark pointers with a prefix
 	//to avoid confusions: 'h' - host, 'd' - device
 	
 	//number of array elements
 	size_t				m_ArraySize = 0;
+	unsigned int		m_Iterations = 10000;
 
 	//integer arrays on the CPU
 	int					*m_hA = nullptr, *m_hB = nullptr, *m_hC = nullptr;
 
-	//integer arrays on the GPU (and a buffer to read the result back to the host)
-	cl_mem				m_dA = nullptr, m_dB = nullptr, m_dC = nullptr;
+	//integer arrays on the GPU, the host accesses them by mapping (zero-copy or pinned memory)
+	CHostBuffer			m_dA, m_dB, m_dC;
+	//the mapped result buffer m_dC
 	int					*m_hGPUResult = nullptr;
 
 	//OpenCL program and kernels
-	cl_program			m_Program = nullptr;
-	cl_kernel			m_Kernel = nullptr;
+	CLProgram			m_Program;
+	CLKernel			m_Kernel;
+
+	//sweep mode: one coarsened kernel per number of elements per work-item (1, 2, 4, 8)
+	static const int	NUM_COARSENING = 4;
+	bool				m_Sweep = false;
+	double				m_TheoreticalBandwidth = 0.0;
+	CLProgram			m_CoarsenedPrograms[NUM_COARSENING];
+	CLKernel			m_CoarsenedKernels[NUM_COARSENING];
+	size_t				m_MaxWorkGroupSize = 0;
+	cl_uint				m_ComputeUnits = 0;
 };
 
 #endif // _CSIMPLE_ARRAYS_TASK_H
@@ -1,21 +1,236 @@
 
-// Rotate the matrix CLOCKWISE
+// Rotate the matrix CLOCKWISE (by 90, 180 or 270 degrees) or transpose it.
+// A batch of equally sized matrices is stored back to back and processed in a single launch,
+// the third NDRange dimension selects the matrix.
+
+/* These macros will be defined dynamically during building the program
+
+// element type: uchar, ushort, uint, uint2 or uint4 for 1, 2, 4, 8 or 16 byte elements
+#define ELEM_TYPE		uint
+// one of the ROTATE_* / TRANSPOSE constants below
+#define ROTATION_MODE	0
+
+// the optimized kernel moves square TILE_DIM x TILE_DIM tiles with work-groups of TILE_DIM x TILE_ROWS
+#define TILE_DIM		32
+#define TILE_ROWS		16
+
+*/
+
+#define ROTATE_90		0
+#define ROTATE_180		1
+#define ROTATE_270		2
+#define TRANSPOSE		3
 
 //naive implementation: move the elements of the matrix directly to their destinations
 //this will cause unaligned memory accessed which - as we will see - should be avoided on the GPU
 
-__kernel void MatrixRotNaive(__global const float* M, __global float* MR, uint SizeX, uint SizeY)
+__kernel void MatrixRotNaive(__global const ELEM_TYPE* M, __global ELEM_TYPE* MR, uint SizeX, uint SizeY)
 {
-	// TO DO: Add kernel code
+	uint x = get_global_id(0);
+	uint y = get_global_id(1);
+
+	if (x >= SizeX || y >= SizeY)
+		return;
+
+	size_t batchOffset = (size_t)get_global_id(2) * SizeX * SizeY;
+
+#if ROTATION_MODE == ROTATE_90
+	size_t dst = (size_t)x * SizeY + (SizeY - y - 1);
+#elif ROTATION_MODE == ROTATE_180
+	size_t dst = (size_t)(SizeY - y - 1) * SizeX + (SizeX - x - 1);
+#elif ROTATION_MODE == ROTATE_270
+	size_t dst = (size_t)(SizeX - x - 1) * SizeY + y;
+#else
+	size_t dst = (size_t)x * SizeY + y;
+#endif
+
+	MR[batchOffset + dst] = M[batchOffset + (size_t)y * SizeX + x];
 }
 
 //this kernel does the same thing, however, the local memory is used to
 //transform a small chunk of the matrix locally
 //then write it back after synchronization in a coalesced access pattern
 
-__kernel void MatrixRotOptimized(__global const float* M, __global float* MR, uint SizeX, uint SizeY,
-							__local float* block)
+//Each work-group produces one TILE_DIM x TILE_DIM tile of the output. It loads the input tile
+//that maps onto it row by row, and writes the output tile row by row, so both global accesses
+//are coalesced. The permutation itself happens while reading the tile from local memory.
+__kernel __attribute__((reqd_work_group_size(TILE_DIM, TILE_ROWS, 1)))
+void MatrixRotOptimized(__global const ELEM_TYPE* M, __global ELEM_TYPE* MR, uint SizeX, uint SizeY)
 {
-	// TO DO: Add kernel code
+	// the padding column moves each row of the tile to a different bank,
+	// so reading a column of the tile is free of bank conflicts
+	__local ELEM_TYPE block[TILE_DIM][TILE_DIM + 1];
+
+	const int lx = get_local_id(0);
+	const int ly = get_local_id(1);
+
+	const size_t batchOffset = (size_t)get_group_id(2) * SizeX * SizeY;
+	M += batchOffset;
+	MR += batchOffset;
+
+	const int w = SizeX;
+	const int h = SizeY;
+
+	// origin of the output tile
+	const int ox0 = get_group_id(0) * TILE_DIM;
+	const int oy0 = get_group_id(1) * TILE_DIM;
+
+	// output dimensions and origin of the input tile (may lie partially outside the matrix)
+#if ROTATION_MODE == ROTATE_90
+	const int outW = h, outH = w;
+	const int ix0 = oy0, iy0 = h - ox0 - TILE_DIM;
+#elif ROTATION_MODE == ROTATE_180
+	const int outW = w, outH = h;
+	const int ix0 = w - ox0 - TILE_DIM, iy0 = h - oy0 - TILE_DIM;
+#elif ROTATION_MODE == ROTATE_270
+	const int outW = h, outH = w;
+	const int ix0 = w - oy0 - TILE_DIM, iy0 = ox0;
+#else
+	const int outW = h, outH = w;
+	const int ix0 = oy0, iy0 = ox0;
+#endif
+
+	// load the input tile
+	for (int r = ly; r < TILE_DIM; r += TILE_ROWS)
+	{
+		int ix = ix0 + lx;
+		int iy = iy0 + r;
+		if (ix >= 0 && ix < w && iy >= 0 && iy < h)
+			block[r][lx] = M[(size_t)iy * w + ix];
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// store the output tile
+	for (int r = ly; r < TILE_DIM; r += TILE_ROWS)
+	{
+		int ox = ox0 + lx;
+		int oy = oy0 + r;
+		if (ox < outW && oy < outH)
+		{
+#if ROTATION_MODE == ROTATE_90
+			MR[(size_t)oy * outW + ox] = block[TILE_DIM - 1 - lx][r];
+#elif ROTATION_MODE == ROTATE_180
+			MR[(size_t)oy * outW + ox] = block[TILE_DIM - 1 - r][TILE_DIM - 1 - lx];
+#elif ROTATION_MODE == ROTATE_270
+			MR[(size_t)oy * outW + ox] = block[lx][TILE_DIM - 1 - r];
+#else
+			MR[(size_t)oy * outW + ox] = block[lx][r];
+#endif
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+// In-place variants: the result overwrites the input buffer, so no second matrix has to be allocated.
+// 90 and 270 degree rotations are done as a transposition followed by MatrixFlipInPlace.
+
+//Transposes a square Size x Size matrix in place. Each work-group swaps a pair of tiles
+//mirrored across the diagonal (diagonal tiles are transposed on their own).
+//The grid covers all tile pairs, work-groups below the diagonal exit immediately.
+__kernel __attribute__((reqd_work_group_size(TILE_DIM, TILE_ROWS, 1)))
+void MatrixTransposeInPlace(__global ELEM_TYPE* M, uint Size)
+{
+	__local ELEM_TYPE blockA[TILE_DIM][TILE_DIM + 1];
+	__local ELEM_TYPE blockB[TILE_DIM][TILE_DIM + 1];
+
+	const int bx = get_group_id(0);
+	const int by = get_group_id(1);
+	if (bx < by)
+		return;
+
+	const int lx = get_local_id(0);
+	const int ly = get_local_id(1);
+	const int n = Size;
+
+	M += (size_t)get_group_id(2) * Size * Size;
+
+	// tile A is above the diagonal, tile B is its mirror image
+	const int ax0 = bx * TILE_DIM, ay0 = by * TILE_DIM;
+	const int bx0 = ay0, by0 = ax0;
+
+	for (int r = ly; r < TILE_DIM; r += TILE_ROWS)
+	{
+		if (ax0 + lx < n && ay0 + r < n)
+			blockA[r][lx] = M[(size_t)(ay0 + r) * n + ax0 + lx];
+		if (bx0 + lx < n && by0 + r < n)
+			blockB[r][lx] = M[(size_t)(by0 + r) * n + bx0 + lx];
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int r = ly; r < TILE_DIM; r += TILE_ROWS)
+	{
+		if (bx0 + lx < n && by0 + r < n)
+			M[(size_t)(by0 + r) * n + bx0 + lx] = blockA[lx][r];
+		if (bx != by && ax0 + lx < n && ay0 + r < n)
+			M[(size_t)(ay0 + r) * n + ax0 + lx] = blockB[lx][r];
+	}
+}
+
+//Transposes a non-square SizeX x SizeY matrix in place by following the cycles of the permutation.
+//The element at linear index i moves to (i * SizeY) mod (SizeX * SizeY - 1). The host finds the
+//smallest index of each cycle, and every work-item walks one cycle carrying the displaced element.
+//A cycle is not split between work-items, so only as many work-items as cycles are busy and the
+//longest cycle (up to the whole matrix) runs serially.
+__kernel void MatrixTransposeCycles(__global ELEM_TYPE* M, __global const uint* CycleLeaders, uint NumCycles,
+	uint SizeX, uint SizeY)
+{
+	uint c = get_global_id(0);
+	if (c >= NumCycles)
+		return;
+
+	const ulong last = (ulong)SizeX * SizeY - 1;
+	M += (size_t)get_global_id(1) * SizeX * SizeY;
+
+	const ulong start = CycleLeaders[c];
+	ulong i = start;
+	ELEM_TYPE value = M[i];
+	do
+	{
+		ulong next = (i * SizeY) % last;
+		ELEM_TYPE displaced = M[next];
+		M[next] = value;
+		value = displaced;
+		i = next;
+	} while (i != start);
+}
+
+//Mirrors a SizeX x SizeY matrix in place:
+//ROTATE_90: each row is reversed (applied to the transposed matrix)
+//ROTATE_270: the order of the rows is reversed (applied to the transposed matrix)
+//ROTATE_180: both, which is the same as reversing the whole matrix
+__kernel void MatrixFlipInPlace(__global ELEM_TYPE* M, uint SizeX, uint SizeY)
+{
+	uint x = get_global_id(0);
+	uint y = get_global_id(1);
+
+	M += (size_t)get_global_id(2) * SizeX * SizeY;
+
+#if ROTATION_MODE == ROTATE_90
+	if (x >= SizeX / 2 || y >= SizeY)
+		return;
+	uint fx = SizeX - x - 1;
+	uint fy = y;
+#else
+	if (x >= SizeX || y >= (SizeY + 1) / 2)
+		return;
+	uint fy = SizeY - y - 1;
+	#if ROTATION_MODE == ROTATE_180
+		uint fx = SizeX - x - 1;
+		// the middle row of an odd matrix is only reversed
+		if (y == fy && x >= fx)
+			return;
+	#else
+		uint fx = x;
+		if (y == fy)
+			return;
+	#endif
+#endif
+
+	size_t a = (size_t)y * SizeX + x;
+	size_t b = (size_t)fy * SizeX + fx;
+	ELEM_TYPE tmp = M[a];
+	M[a] = M[b];
+	M[b] = tmp;
 }
- 
\ No newline at end of file
@@ -11,3 +11,54 @@ __kernel void VecAdd(__global const int* a, __global const int* b, __global int*
 	}
 }
 
+/* This macro will be defined dynamically during building the program
+
+// number of consecutive elements handled per loop iteration of a work-item: 1, 2, 4 or 8
+#define ELEMS_PER_ITEM	4
+
+*/
+
+#if ELEMS_PER_ITEM == 8
+	#define VEC_T			int8
+	#define VLOAD(o, p)		vload8(o, p)
+	#define VSTORE(v, o, p)	vstore8(v, o, p)
+	#define REVERSE(v)		(v).s76543210
+#elif ELEMS_PER_ITEM == 4
+	#define VEC_T			int4
+	#define VLOAD(o, p)		vload4(o, p)
+	#define VSTORE(v, o, p)	vstore4(v, o, p)
+	#define REVERSE(v)		(v).s3210
+#elif ELEMS_PER_ITEM == 2
+	#define VEC_T			int2
+	#define VLOAD(o, p)		vload2(o, p)
+	#define VSTORE(v, o, p)	vstore2(v, o, p)
+	#define REVERSE(v)		(v).s10
+#else
+	#define VEC_T			int
+	#define VLOAD(o, p)		(p)[o]
+	#define VSTORE(v, o, p)	(p)[o] = (v)
+	#define REVERSE(v)		(v)
+#endif
+
+//Same result as VecAdd, but every work-item processes ELEMS_PER_ITEM consecutive elements
+//with a single vector load per array, and walks over the arrays in a grid-stride loop.
+//This way the grid can be sized to fill the device instead of having one work-item per element.
+__kernel void VecAddCoarsened(__global const int* a, __global const int* b, __global int* c, int numElements)
+{
+	const int numVectors = numElements / ELEMS_PER_ITEM;
+	const int stride = get_global_size(0);
+
+	for (int v = get_global_id(0); v < numVectors; v += stride)
+	{
+		// the elements of b used by this vector are consecutive as well, just in reverse order
+		VEC_T va = VLOAD(v, a);
+		VEC_T vb = VLOAD(0, b + numElements - (v + 1) * ELEMS_PER_ITEM);
+		VSTORE(va + REVERSE(vb), v, c);
+	}
+
+	// remaining elements if numElements is not a multiple of the vector width
+	for (int i = numVectors * ELEMS_PER_ITEM + get_global_id(0); i < numElements; i += stride)
+	{
+		c[i] = a[i] + b[numElements - i - 1];
+	}
+}
@@ -17,26 +17,44 @@ using namespace std;
 
 bool CAssignment2::DoCompute()
 {
+	// the defaults below can be overridden on the command line, e.g. --task scan --size 1M:64M --local 128,256
+
 	// Task 1: parallel reduction
-	cout<<"########################################"<<endl;
-	cout<<"Running parallel reduction task..."<<endl<<endl; 
+	if(m_Options.IsTaskSelected("reduction"))
 	{ 
-		size_t LocalWorkSize[3] = {256, 1, 1};
-		CReductionTask reduction(1024 * 1024 * 16);
-		RunComputeTask(reduction, LocalWorkSize);
+		AddBenchmarkSection("Running parallel reduction task...");
+		SBenchmarkConfig defaults = {{1024 * 1024 * 16, 1, 1}, {256, 1, 1}, 100, ""};
+		AddBenchmark("reduction", defaults, [](const SBenchmarkConfig& Config) {
+			// every reduction variant halves the array or reduces whole work-groups in each pass
+			size_t n = Config.Size[0], groupSize = Config.LocalWorkSize[0];
+			if(n < 2 || (n & (n - 1)) != 0 || groupSize < 2 || (groupSize & (groupSize - 1)) != 0)
+			{
+				cerr<<"The reduction needs powers of two as size and local size, "<<n<<" and "<<groupSize<<" are not supported."<<endl;
+				return unique_ptr<IComputeTask>();
+			}
+			return unique_ptr<IComputeTask>(new CReductionTask(n, Config.Iterations));
+		});
 	}
 
 	// Task 2: parallel prefix sum
-	cout<<"########################################"<<endl;
-	cout<<"Running parallel prefix sum task..."<<endl<<endl;
+	if(m_Options.IsTaskSelected("scan"))
 	{
-		size_t LocalWorkSize[3] = {256, 1, 1};
-		CScanTask scan(1024 * 1024 * 64, LocalWorkSize[0]);
-		RunComputeTask(scan, LocalWorkSize);
+		AddBenchmarkSection("Running parallel prefix sum task...");
+		SBenchmarkConfig defaults = {{1024 * 1024 * 64, 1, 1}, {256, 1, 1}, 100, ""};
+		AddBenchmark("scan", defaults, [](const SBenchmarkConfig& Config) {
+			// the naive scan launches one work-item per value in log2(size) passes, without bounds checks
+			size_t n = Config.Size[0], groupSize = Config.LocalWorkSize[0];
+			if(n < 2 || (n & (n - 1)) != 0 || groupSize < 1 || (groupSize & (groupSize - 1)) != 0 || groupSize > n)
+			{
+				cerr<<"The scan needs powers of two as size and local size (local size <= size), "<<n<<" and "<<groupSize<<" are not supported."<<endl;
+				return unique_ptr<IComputeTask>();
+			}
+			return unique_ptr<IComputeTask>(new CScanTask(n, groupSize, Config.Iterations));
+		});
 	}
 
-
-	return true;
+	// the programs of all queued tasks are built concurrently before the first run
+	return RunBenchmarks();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
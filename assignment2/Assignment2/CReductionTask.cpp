@@ -5,11 +5,17 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CReductionTask.h"
 
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
+
+#include <cmath>
 
 using namespace std;
 
+#define PROGRAM_FILE "Reduction.cl"
+
 ///////////////////////////////////////////////////////////////////////////////
 // CReductionTask
 
@@ -20,12 +26,9 @@ string g_kernelNames[4] = {
 	"kernelDecompositionUnroll"
 };
 
-CReductionTask::CReductionTask(size_t ArraySize)
-	: m_N(ArraySize), m_hInput(NULL), 
-	m_dPingArray(NULL),
-	m_dPongArray(NULL),
-	m_Program(NULL), 
-	m_InterleavedAddressingKernel(NULL), m_SequentialAddressingKernel(NULL), m_DecompKernel(NULL), m_DecompUnrollKernel(NULL)
+CReductionTask::CReductionTask(size_t ArraySize, unsigned int Iterations)
+	: m_N(ArraySize), m_Iterations(Iterations), m_hInput(NULL), 
+	m_MultiDeviceRun(false), m_resultMultiDevice(0)
 {
 }
 
@@ -45,31 +48,28 @@ bool CReductionTask::InitResources(cl_device_id Device, cl_context Context)
 		m_hInput[i] = rand() & 15;
 
 	//device resources
-	cl_int clError, clError2;
-	m_dPingArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError = clError2;
-	m_dPongArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError |= clError2;
-	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+	cl_int clError;
+	if(!m_dPingArray.Create(Context, CL_MEM_READ_WRITE, m_N) || !m_dPongArray.Create(Context, CL_MEM_READ_WRITE, m_N))
+		return false;
 
 	//load and compile kernels
 	string programCode;
 
-	CLUtil::LoadProgramSourceToMemory("../Assignment2/Reduction.cl", programCode);
-	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode);
+	m_Program.Reset(CLUtil::BuildCachedCLProgram(Device, Context, programCode));
 	if(m_Program == nullptr) return false;
 
 	//create kernels
-	m_InterleavedAddressingKernel = clCreateKernel(m_Program, "Reduction_InterleavedAddressing", &clError);
+	m_InterleavedAddressingKernel.Reset(clCreateKernel(m_Program, "Reduction_InterleavedAddressing", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_InterleavedAddressing.");
 
-	m_SequentialAddressingKernel = clCreateKernel(m_Program, "Reduction_SequentialAddressing", &clError);
+	m_SequentialAddressingKernel.Reset(clCreateKernel(m_Program, "Reduction_SequentialAddressing", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_SequentialAddressing.");
 	
-	m_DecompKernel = clCreateKernel(m_Program, "Reduction_Decomp", &clError);
+	m_DecompKernel.Reset(clCreateKernel(m_Program, "Reduction_Decomp", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_Decomp.");
 
-	m_DecompUnrollKernel = clCreateKernel(m_Program, "Reduction_DecompUnroll", &clError);
+	m_DecompUnrollKernel.Reset(clCreateKernel(m_Program, "Reduction_DecompUnroll", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_DecompUnroll.");
 
 	return true;
@@ -81,15 +81,55 @@ void CReductionTask::ReleaseResources()
 	SAFE_DELETE_ARRAY(m_hInput);
 
 	// device resources
-	SAFE_RELEASE_MEMOBJECT(m_dPingArray);
-	SAFE_RELEASE_MEMOBJECT(m_dPongArray);
+	m_dPingArray.Release();
+	m_dPongArray.Release();
+
+	m_InterleavedAddressingKernel.Reset();
+	m_SequentialAddressingKernel.Reset();
+	m_DecompKernel.Reset();
+	m_DecompUnrollKernel.Reset();
+
+	m_Program.Reset();
+
+	// multi-device resources
+	m_PartialKernels.clear();
+	m_dDeviceInputs.clear();
+	m_dDevicePartials.clear();
+	m_MultiDeviceProgram.Reset();
+}
+
+void CReductionTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	// InitResources() builds the same program and only waits for this build
+	string programCode;
+	if(CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode))
+		CLUtil::BuildCachedCLProgramAsync(Device, Context, programCode);
+}
+
+bool CReductionTask::InitMultiDeviceResources(cl_context Context, const std::vector<cl_device_id>& Devices)
+{
+	string programCode;
+	CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode);
+	m_MultiDeviceProgram.Reset(CLUtil::BuildCLProgramForDevices(Devices, Context, programCode));
+	if(m_MultiDeviceProgram == nullptr) return false;
+
+	// every device gets its own kernel object, so the arguments can be set independently
+	cl_int clError;
+	m_PartialKernels.resize(Devices.size());
+	m_dDeviceInputs.resize(Devices.size());
+	m_dDevicePartials.resize(Devices.size());
+	for(size_t i = 0; i < Devices.size(); i++)
+	{
+		m_PartialKernels[i].Reset(clCreateKernel(m_MultiDeviceProgram, "Reduction_Partial", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_Partial.");
 
-	SAFE_RELEASE_KERNEL(m_InterleavedAddressingKernel);
-	SAFE_RELEASE_KERNEL(m_SequentialAddressingKernel);
-	SAFE_RELEASE_KERNEL(m_DecompKernel);
-	SAFE_RELEASE_KERNEL(m_DecompUnrollKernel);
+		// the slice of a device can be anything up to the whole array
+		if(!m_dDeviceInputs[i].Create(Context, CL_MEM_READ_ONLY, m_N) ||
+			!m_dDevicePartials[i].Create(Context, CL_MEM_WRITE_ONLY, MULTI_DEVICE_GROUPS))
+			return false;
+	}
 
-	SAFE_RELEASE_PROGRAM(m_Program);
+	return true;
 }
 
 void CReductionTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
@@ -99,10 +139,11 @@ void CReductionTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueu
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 2);
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 3);
 
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 2);
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 3);
+	// the timings go to the benchmark report
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 2);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 3);
 
 }
 
@@ -123,10 +164,21 @@ void CReductionTask::ComputeCPU()
 
 	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
 	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	CBenchmarkReport::Record("cpu", ms, nIterations, m_N, "Gelem/s");
 }
 
 bool CReductionTask::ValidateResults()
 {
+	if(m_MultiDeviceRun)
+	{
+		if(m_resultMultiDevice != m_resultCPU)
+		{
+			cout<<"Validation of the multi-device reduction failed."<<endl;
+			return false;
+		}
+		return true;
+	}
+
 	bool success = true;
 
 	for(int i = 0; i < 4; i++)
@@ -155,13 +207,10 @@ void CReductionTask::Reduction_InterleavedAddressing(cl_context Context, cl_comm
 		
 	//cout << "Executing Interleaved Addressing with " << globalWorkSize << " threads in " << nGroups << " groups of size " << LocalWorkSize[0] << endl;
 
-	clErr = clSetKernelArg(m_InterleavedAddressingKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-
 	for (unsigned int j = 1; j <= nKernelCalls; j++)
 	{
-		clErr = clSetKernelArg(m_InterleavedAddressingKernel, 1, sizeof(cl_uint), (void*)&offset);
-		clErr = clSetKernelArg(m_InterleavedAddressingKernel, 2, sizeof(cl_uint), (void*)&stride);
-		clErr = clSetKernelArg(m_InterleavedAddressingKernel, 3, sizeof(cl_uint), (void*)&m_N);
+		//the buffer and the size are only passed to the driver in the first iteration
+		clErr = SetArgs(m_InterleavedAddressingKernel, m_dPingArray, offset, stride, m_N);
 		V_RETURN_CL(clErr, "Failed to set Kernel args: m_InterleavedAddressingKernel");
 
 		//clErr = clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(unsigned), m_hInput, 0, NULL, NULL);
@@ -219,9 +268,7 @@ void CReductionTask::Reduction_SequentialAddressing(cl_context Context, cl_comma
 
 	for (unsigned int j = 1; j <= nKernelCalls; j++)
 	{
-		clErr = clSetKernelArg(m_SequentialAddressingKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-		clErr = clSetKernelArg(m_SequentialAddressingKernel, 1, sizeof(cl_uint), (void*)&stride);
-		clErr = clSetKernelArg(m_SequentialAddressingKernel, 2, sizeof(cl_uint), (void*)&m_N);
+		clErr = SetArgs(m_SequentialAddressingKernel, m_dPingArray, stride, m_N);
 		V_RETURN_CL(clErr, "Failed to set Kernel args: m_SequentialAddressingKernel");
 		
 		clErr = clEnqueueNDRangeKernel(CommandQueue, m_SequentialAddressingKernel, 1, NULL, &globalWorkSize, &localWorkSize, 0, NULL, NULL);
@@ -251,167 +298,31 @@ void CReductionTask::Reduction_SequentialAddressing(cl_context Context, cl_comma
 
 }
 
-void CReductionTask::Reduction_Decomp(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+void CReductionTask::ReduceDecomposed(cl_command_queue CommandQueue, CLKernel& Kernel, size_t GroupSize)
 {
-	unsigned int *hOutput = new unsigned int[m_N];		// for finding calculation errors
-
-	//unsigned int *localArray = new unsigned int[512];
-
-	cl_int clErr;
+	// every pass reduces blocks of GroupSize elements to one value per work-group, until a single
+	// value is left (m_N and GroupSize are powers of two, so every pass divides the size exactly)
 	size_t gwSize = m_N;
-	size_t lwSize = 512;			//256
-	
-	//------------ first iteration to reduce 512 local elements;	here: 32768 local executions
-	//unsigned int nLocalExec = m_N / 512;
-
-	clErr = clSetKernelArg(m_DecompKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	//clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint), (void*)&nLocalExec);
-	clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint) * 512, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-
-	//------------ second iteration to reduce 512 local elements	here: 64 local executions
-	//nLocalExec = nLocalExec / 512;			
-	gwSize = gwSize / 512;				// = 32768
-
-	clErr = clSetKernelArg(m_DecompKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	//clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint), (void*)&nLocalExec);
-	clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint) * 512, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-	////now we should have 64 values left to be reduced
-	//clErr = clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(unsigned), hOutput, 0, NULL, NULL);
-	//V_RETURN_CL(clErr, "Error reading data from device (m_dPingArray) to host (hOutput)!");
-	//cout << endl << "First 100 elements with sequential addressing" << endl;
-	//for (int j = 0; j < 100; j++)
-	//{
-	//	cout << hOutput[j] << "|";
-	//}
-	//cout << endl;
-
-	//----------- last iteration to reduce final 64 elements
-	//nLocalExec = nLocalExec / 512;
-	gwSize = 64;
-	lwSize = 64;
-
-	clErr = clSetKernelArg(m_DecompKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	//clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint), (void*)&nLocalExec);
-	clErr = clSetKernelArg(m_DecompKernel, 2, sizeof(cl_uint) * 64, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-
-	////------ for finding calculation errors:
-	//clErr = clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(unsigned), hOutput, 0, NULL, NULL);
-	//V_RETURN_CL(clErr, "Error reading data from device (m_dPingArray) to host (hOutput)!");
-	//cout << endl << "First 100 elements with decomposition" << endl;
-	//for (int j = 0; j < 100; j++)
-	//{
-	//	cout << hOutput[j] << "|";
-	//}
-	//cout << endl;
-
-	SAFE_DELETE_ARRAY(hOutput);
+	while(gwSize > 1)
+	{
+		size_t lwSize = min(gwSize, GroupSize);
+		cl_int clErr = Launch(CommandQueue, Kernel, 1, &gwSize, &lwSize, m_dPingArray, m_dPongArray, CLLocalMemory(sizeof(cl_uint) * lwSize));
+		V_RETURN_CL(clErr, "Error executing a kernel decomposition pass!");
 
-	// TO DO: Implement reduction with kernel decomposition
+		// the result of the pass is the input of the next one, the final result ends up in m_dPingArray
+		swap(m_dPingArray, m_dPongArray);
+		gwSize /= lwSize;
+	}
+}
 
-	// NOTE: make sure that the final result is always in the variable m_dPingArray
-	// as this is read back for the correctness check
-	// (CReductionTask::ExecuteTask)
-	//
-	// hint: for example, you can use swap(m_dPingArray, m_dPongArray) at the end of your for loop...
+void CReductionTask::Reduction_Decomp(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	ReduceDecomposed(CommandQueue, m_DecompKernel, LocalWorkSize[0]);
 }
 
 void CReductionTask::Reduction_DecompUnroll(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
-
-	unsigned int warpSize = CL_DEVICE_WARP_SIZE_NV;
-	unsigned int *hOutput = new unsigned int[m_N];		// for finding calculation errors
-
-	cl_int clErr;
-	size_t gwSize = m_N;
-	size_t lwSize = 512;			//256
-
-	//------------ first iteration to reduce 512 local elements;	here: 32768 local executions
-	//unsigned int nLocalExec = m_N / 512;
-
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 2, sizeof(cl_uint) * 512, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompUnrollKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompUnrollKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompUnrollKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-
-	//------------ second iteration to reduce 512 local elements	here: 64 local executions
-	//nLocalExec = nLocalExec / 512;			
-	gwSize = gwSize / 512;				// = 32768
-
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 2, sizeof(cl_uint) * 512, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompUnrollKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompUnrollKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompUnrollKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-
-	//----------- last iteration to reduce final 64 elements
-	gwSize = 64;
-	lwSize = 64;
-
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	clErr = clSetKernelArg(m_DecompUnrollKernel, 2, sizeof(cl_uint) * 64, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_DecompUnrollKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompUnrollKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
-	V_RETURN_CL(clErr, "Error executing Kernel m_DecompUnrollKernel!");
-
-	swap(m_dPingArray, m_dPongArray);
-
-
-	////------ for finding calculation errors:
-	//clErr = clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(unsigned), hOutput, 0, NULL, NULL);
-	//V_RETURN_CL(clErr, "Error reading data from device (m_dPingArray) to host (hOutput)!");
-	//cout << endl << "First 100 elements with decomposition unrolled" << endl;
-	//for (int j = 0; j < 100; j++)
-	//{
-	//	cout << hOutput[j] << "|";
-	//}
-	//cout << endl;
-
-	SAFE_DELETE_ARRAY(hOutput);
-	// TO DO: Implement reduction with loop unrolling
-
-	// NOTE: make sure that the final result is always in the variable m_dPingArray
-	// as this is read back for the correctness check
-	// (CReductionTask::ExecuteTask)
-	//
-	// hint: for example, you can use swap(m_dPingArray, m_dPongArray) at the end of your for loop...
-
+	ReduceDecomposed(CommandQueue, m_DecompUnrollKernel, LocalWorkSize[0]);
 }
 
 void CReductionTask::ExecuteTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
@@ -442,6 +353,74 @@ void CReductionTask::ExecuteTask(cl_context Context, cl_command_queue CommandQue
 	
 }
 
+bool CReductionTask::EnqueueSlice(size_t Device, cl_command_queue CommandQueue, size_t Begin, size_t End, size_t LocalWorkSize,
+	cl_uint* hPartials, size_t& NumPartials)
+{
+	cl_uint numElements = cl_uint(End - Begin);
+	NumPartials = min(size_t(MULTI_DEVICE_GROUPS), max<size_t>(1, CLUtil::GetGlobalWorkSize(numElements, LocalWorkSize) / LocalWorkSize));
+	size_t globalWorkSize = NumPartials * LocalWorkSize;
+
+	CLKernel& kernel = m_PartialKernels[Device];
+	V_RETURN_FALSE_CL(SetArgs(kernel, m_dDeviceInputs[Device], m_dDevicePartials[Device], numElements, CLLocalMemory(sizeof(cl_uint) * LocalWorkSize)),
+		"Failed to set Kernel args: Reduction_Partial");
+
+	if(!m_dDeviceInputs[Device].Write(CommandQueue, m_hInput + Begin, numElements))
+		return false;
+	V_RETURN_FALSE_CL(clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, &globalWorkSize, &LocalWorkSize, 0, NULL, NULL),
+		"Error executing Kernel Reduction_Partial!");
+	if(!m_dDevicePartials[Device].Read(CommandQueue, hPartials, NumPartials, 0, CL_FALSE))
+		return false;
+
+	return true;
+}
+
+void CReductionTask::ComputeGPUMultiDevice(cl_context Context, const std::vector<cl_command_queue>& CommandQueues, size_t LocalWorkSize[3])
+{
+	size_t numDevices = CommandQueues.size();
+	size_t localWorkSize = LocalWorkSize[0];
+	vector<vector<cl_uint> > partials(numDevices, vector<cl_uint>(MULTI_DEVICE_GROUPS));
+	vector<size_t> numPartials(numDevices, 0);
+
+	auto enqueueSlice = [&](size_t Device, size_t Begin, size_t End) {
+		return EnqueueSlice(Device, CommandQueues[Device], Begin, End, localWorkSize, &partials[Device][0], numPartials[Device]);
+	};
+
+	//size the slices by the throughput of the devices (including the transfer of the input)
+	vector<double> throughput = CLUtil::MeasureDeviceThroughput(CommandQueues, m_N, localWorkSize, enqueueSlice);
+	if(throughput.empty())
+		return;
+	vector<size_t> offsets = CLUtil::PartitionWork(m_N, throughput, localWorkSize);
+
+	CTimer timer;
+	timer.Start();
+
+	//all devices work concurrently, each on its own queue
+	for(size_t i = 0; i < numDevices; i++)
+	{
+		numPartials[i] = 0;
+		if(offsets[i + 1] > offsets[i] && !enqueueSlice(i, offsets[i], offsets[i + 1]))
+			return;
+	}
+	for(size_t i = 0; i < numDevices; i++)
+		V_RETURN_CL(clFinish(CommandQueues[i]), "Error finishing the queue!");
+
+	//merge the partial sums
+	m_resultMultiDevice = 0;
+	for(size_t i = 0; i < numDevices; i++)
+		for(size_t j = 0; j < numPartials[i]; j++)
+			m_resultMultiDevice += partials[i][j];
+
+	timer.Stop();
+	m_MultiDeviceRun = true;
+
+	double ms = timer.GetElapsedMilliseconds();
+	CBenchmarkReport::Record("multiDevice", ms, 1, m_N, "Gelem/s");
+	cout << endl << "Multi-device reduction on " << numDevices << " devices: " << ms << " ms, throughput: "
+		<< 1.0e-6 * (double)m_N / ms << " Gelem/s" << endl;
+	for(size_t i = 0; i < numDevices; i++)
+		cout << "  device " << i << ": " << offsets[i + 1] - offsets[i] << " elements (measured " << throughput[i] * 1.0e-6 << " Gelem/s)" << endl;
+}
+
 void CReductionTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
 {
 	cout << "Testing performance of task " << g_kernelNames[Task] << endl;
@@ -451,12 +430,10 @@ void CReductionTask::TestPerformance(cl_context Context, cl_command_queue Comman
 	//finish all before we start meassuring the time
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	CTimer timer;
-	timer.Start();
-
-	//run the kernel N times
-	unsigned int nIterations = 100;
-	for(unsigned int i = 0; i < nIterations; i++) {
+	//run the kernel N times, every iteration is timed on its own and the first one is a warmup
+	CSamplingTimer timer(1);
+	for(unsigned int i = 0; i < m_Iterations + 1; i++) {
+		timer.Start();
 		//run selected task
 		switch (Task){
 			case 0:
@@ -472,15 +449,17 @@ void CReductionTask::TestPerformance(cl_context Context, cl_command_queue Comman
 				Reduction_DecompUnroll(Context, CommandQueue, LocalWorkSize);
 				break;
 		}
+		//wait until the command queue is empty again
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		timer.Stop();
 	}
 
-	//wait until the command queue is empty again
-	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
-
-	timer.Stop();
-
-	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	double ms = timer.GetMean();
 	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	cout << "  ";
+	timer.PrintStatistics(cout);
+	cout << endl;
+	CBenchmarkReport::Record(g_kernelNames[Task], timer.GetSamples(), m_N, "Gelem/s");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -20,13 +20,23 @@
 #ifndef _CREDUCTION_TASK_H
 #define _CREDUCTION_TASK_H
 
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/IMultiDeviceComputeTask.h"
+#include "../../Common/IAsyncBuildComputeTask.h"
+#include "../../Common/CLHandles.h"
+
+#include <vector>
 
 //! A2/T1: Parallel reduction
-class CReductionTask : public IComputeTask
+/*!
+	In the multi-device mode every device reduces a slice of the input to partial sums,
+	the slices are sized by the measured throughput of the devices.
+*/
+class CReductionTask : public IComputeTask, public IMultiDeviceComputeTask, public IAsyncBuildComputeTask
 {
 public:
-	CReductionTask(size_t ArraySize);
+	//! Iterations is the number of timed runs of each GPU variant
+	CReductionTask(size_t ArraySize, unsigned int Iterations = 100);
 
 	virtual ~CReductionTask();
 
@@ -42,10 +52,26 @@ public:
 
 	virtual bool ValidateResults();
 
+	// IMultiDeviceComputeTask
+
+	virtual bool InitMultiDeviceResources(cl_context Context, const std::vector<cl_device_id>& Devices);
+
+	virtual void ComputeGPUMultiDevice(cl_context Context, const std::vector<cl_command_queue>& CommandQueues, size_t LocalWorkSize[3]);
+
+	// IAsyncBuildComputeTask
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
 protected:
+	//! Enqueues the reduction of the elements [Begin, End) on device Device, the partial sums are read back to hPartials asynchronously
+	bool EnqueueSlice(size_t Device, cl_command_queue CommandQueue, size_t Begin, size_t End, size_t LocalWorkSize,
+		cl_uint* hPartials, size_t& NumPartials);
 
 	void Reduction_InterleavedAddressing(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 	void Reduction_SequentialAddressing(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	//! Runs Kernel (one of the decomposition kernels) in passes of GroupSize work-items until m_dPingArray[0] holds the sum
+	void ReduceDecomposed(cl_command_queue CommandQueue, CLKernel& Kernel, size_t GroupSize);
+
 	void Reduction_Decomp(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 	void Reduction_DecompUnroll(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 
@@ -56,6 +82,7 @@ protected:
 	//to avoid confusions: 'h' - host, 'd' - device
 
 	unsigned int		m_N;
+	unsigned int		m_Iterations;
 
 	// input data
 	unsigned int		*m_hInput;
@@ -63,16 +90,24 @@ protected:
 	unsigned int		m_resultCPU;
 	unsigned int		m_resultGPU[4];
 
-	cl_mem				m_dPingArray;
-	cl_mem				m_dPongArray;
+	DeviceBuffer<cl_uint>	m_dPingArray;
+	DeviceBuffer<cl_uint>	m_dPongArray;
 
 	//OpenCL program and kernels
-	cl_program			m_Program;
-	cl_kernel			m_InterleavedAddressingKernel;
-	cl_kernel			m_SequentialAddressingKernel;
-	cl_kernel			m_DecompKernel;
-	cl_kernel			m_DecompUnrollKernel;
-
+	CLProgram			m_Program;
+	CLKernel			m_InterleavedAddressingKernel;
+	CLKernel			m_SequentialAddressingKernel;
+	CLKernel			m_DecompKernel;
+	CLKernel			m_DecompUnrollKernel;
+
+	//multi-device mode: a kernel, an input slice and the partial sums for each device
+	static const size_t			MULTI_DEVICE_GROUPS = 256;
+	CLProgram								m_MultiDeviceProgram;
+	std::vector<CLKernel>					m_PartialKernels;
+	std::vector<DeviceBuffer<cl_uint> >		m_dDeviceInputs;
+	std::vector<DeviceBuffer<cl_uint> >		m_dDevicePartials;
+	bool						m_MultiDeviceRun;
+	unsigned int				m_resultMultiDevice;
 };
 
 #endif // _CREDUCTION_TASK_H
@@ -5,10 +5,13 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CScanTask.h"
 
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
 
 #include <string.h>
+#include <cmath>
 
 using namespace std;
 
@@ -16,21 +19,20 @@ using namespace std;
 // but we also need to allocate more local memory for that.
 #define NUM_BANKS	32
 
+#define PROGRAM_FILE "Scan.cl"
+
 ///////////////////////////////////////////////////////////////////////////////
 // CScanTask
 
-// only useful for debug info
+// names of the variants in the output and in the benchmark report
 const string g_kernelNames[2] = 
 {
 	"scanNaive",
 	"scanWorkEfficient"
 };
 
-CScanTask::CScanTask(size_t ArraySize, size_t MinLocalWorkSize)
-	: m_N(ArraySize), m_hArray(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL),
-	m_dPingArray(NULL), m_dPongArray(NULL),
-	m_Program(NULL), 
-	m_ScanNaiveKernel(NULL), m_ScanWorkEfficientKernel(NULL), m_ScanWorkEfficientAddKernel(NULL)
+CScanTask::CScanTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int Iterations)
+	: m_N(ArraySize), m_Iterations(Iterations), m_hArray(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL)
 {
 	// compute the number of levels that we need for the work-efficient algorithm
 
@@ -67,42 +69,47 @@ bool CScanTask::InitResources(cl_device_id Device, cl_context Context)
 
 	//device resources
 	// ping-pong buffers
-	cl_int clError, clError2;
-	m_dPingArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError = clError2;
-	m_dPongArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError |= clError2;
+	cl_int clError;
+	if(!m_dPingArray.Create(Context, CL_MEM_READ_WRITE, m_N) || !m_dPongArray.Create(Context, CL_MEM_READ_WRITE, m_N))
+		return false;
 
 	// level buffer
-	m_dLevelArrays = new cl_mem[m_nLevels];
+	m_dLevelArrays.resize(m_nLevels);
 	unsigned int N = m_N;
 	for (unsigned int i = 0; i < m_nLevels; i++) {
-		m_dLevelArrays[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * N, NULL, &clError2);
-		clError |= clError2;
+		if(!m_dLevelArrays[i].Create(Context, CL_MEM_READ_WRITE, N))
+			return false;
 		N = max(N / (2 * m_MinLocalWorkSize), m_MinLocalWorkSize);
 	}
-	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
 
 	//load and compile kernels
 	string programCode;
 
-	CLUtil::LoadProgramSourceToMemory("../Assignment2/Scan.cl", programCode);
-	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode);
+	m_Program.Reset(CLUtil::BuildCachedCLProgram(Device, Context, programCode));
 	if(m_Program == nullptr) return false;
 
 	//create kernels
-	m_ScanNaiveKernel = clCreateKernel(m_Program, "Scan_Naive", &clError);
+	m_ScanNaiveKernel.Reset(clCreateKernel(m_Program, "Scan_Naive", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
 
-	m_ScanWorkEfficientKernel = clCreateKernel(m_Program, "Scan_WorkEfficient", &clError);
+	m_ScanWorkEfficientKernel.Reset(clCreateKernel(m_Program, "Scan_WorkEfficient", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
 
-	m_ScanWorkEfficientAddKernel = clCreateKernel(m_Program, "Scan_WorkEfficientAdd", &clError);
+	m_ScanWorkEfficientAddKernel.Reset(clCreateKernel(m_Program, "Scan_WorkEfficientAdd", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
 
 	return true;
 }
 
+void CScanTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	// InitResources() builds the same program and only waits for this build
+	string programCode;
+	if(CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode))
+		CLUtil::BuildCachedCLProgramAsync(Device, Context, programCode);
+}
+
 void CScanTask::ReleaseResources()
 {
 	// host resources
@@ -112,20 +119,15 @@ void CScanTask::ReleaseResources()
 	SAFE_DELETE_ARRAY(m_hResultGPU);
 
 	// device resources
-	SAFE_RELEASE_MEMOBJECT(m_dPingArray);
-	SAFE_RELEASE_MEMOBJECT(m_dPongArray);
-
-	if(m_dLevelArrays)
-		for (unsigned int i = 0; i < m_nLevels; i++) {
-			SAFE_RELEASE_MEMOBJECT(m_dLevelArrays[i]);
-		}
-	SAFE_DELETE_ARRAY(m_dLevelArrays);
+	m_dPingArray.Release();
+	m_dPongArray.Release();
+	m_dLevelArrays.clear();
 
-	SAFE_RELEASE_KERNEL(m_ScanNaiveKernel);
-	SAFE_RELEASE_KERNEL(m_ScanWorkEfficientKernel);
-	SAFE_RELEASE_KERNEL(m_ScanWorkEfficientAddKernel);
+	m_ScanNaiveKernel.Reset();
+	m_ScanWorkEfficientKernel.Reset();
+	m_ScanWorkEfficientAddKernel.Reset();
 
-	SAFE_RELEASE_PROGRAM(m_Program);
+	m_Program.Reset();
 }
 
 void CScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
@@ -137,8 +139,9 @@ void CScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, si
 
 	cout << endl;
 
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
-	//TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
+	// the timings go to the benchmark report; the work-efficient scan stays out of it until
+	// Scan_WorkEfficient() is implemented (it only scans a single work-group so far)
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
 
 	cout << endl;
 }
@@ -160,6 +163,7 @@ void CScanTask::ComputeCPU()
 	timer.Stop();
 	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
 	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	CBenchmarkReport::Record("cpu", ms, nIterations, m_N, "Gelem/s");
 }
 
 bool CScanTask::ValidateResults()
@@ -178,8 +182,6 @@ bool CScanTask::ValidateResults()
 
 void CScanTask::Scan_Naive(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
-	unsigned int *hOutput = new unsigned int[1024 * 1024 * 64];
-
 	cl_int clErr;
 
 	size_t gwSize = m_N;
@@ -189,39 +191,13 @@ void CScanTask::Scan_Naive(cl_context Context, cl_command_queue CommandQueue, si
 
 	for (unsigned int i = 1; i <= nKernelCalls + 1; i++)
 	{
-		clErr = clSetKernelArg(m_ScanNaiveKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-		clErr = clSetKernelArg(m_ScanNaiveKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-		clErr = clSetKernelArg(m_ScanNaiveKernel, 2, sizeof(cl_uint), (void*)&m_N);
-		clErr = clSetKernelArg(m_ScanNaiveKernel, 3, sizeof(cl_uint), (void*)&offset);
-		V_RETURN_CL(clErr, "Failed to set Kernel args: m_ScanNaiveKernel");
-
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanNaiveKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
+		//only the swapped buffers and the offset change between the iterations, m_N is set once
+		clErr = Launch(CommandQueue, m_ScanNaiveKernel, 1, &gwSize, &lwSize, m_dPingArray, m_dPongArray, m_N, offset);
 		V_RETURN_CL(clErr, "Error executing Kernel m_ScanNaiveKernel!");
 				
 		offset = offset * 2;
 		swap(m_dPingArray, m_dPongArray);
-
-		//clErr = clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(unsigned), hOutput, 0, NULL, NULL);
-		//V_RETURN_CL(clErr, "Error reading data from device (m_dPingArray) to host (m_hOutput)!");
-		//cout << endl << "First 100 elements with naive scan" << endl;
-		//for (int j = 0; j < 100; j++)
-		//{
-		//	cout << hOutput[j] << "|";
-		//}
-		//cout << endl << "last element: " << hOutput[1024 * 1024 * 64 -1] << " iteration: " << i;
-
 	}
-
-	//clErr = clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(unsigned), hOutput, 0, NULL, NULL);
-	//V_RETURN_CL(clErr, "Error reading data from device (m_dPingArray) to host (m_hOutput)!");
-	//cout << endl << "First 100 elements with naive scan" << endl;
-	//for (int j = 0; j < 100; j++)
-	//{
-	//	cout << hOutput[j] << "|";
-	//}
-	//cout << endl << "last element: " << hOutput[1024 * 1024 * 64 -1] << " iteration: " << i;
-
-	SAFE_DELETE_ARRAY(hOutput);
 }
 
 void CScanTask::Scan_WorkEfficient(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
@@ -236,12 +212,7 @@ void CScanTask::Scan_WorkEfficient(cl_context Context, cl_command_queue CommandQ
 	size_t gwSize = 512;
 	size_t lwSize = 512;
 
-	clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
-	clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
-	clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 2, sizeof(cl_uint) * 512, (void*)NULL);
-	V_RETURN_CL(clErr, "Failed to set Kernel args: m_ScanWorkEfficientKernel");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanWorkEfficientKernel, 1, NULL, &gwSize, &lwSize, 0, NULL, NULL);
+	clErr = Launch(CommandQueue, m_ScanWorkEfficientKernel, 1, &gwSize, &lwSize, m_dPingArray, m_dPongArray, CLLocalMemory(sizeof(cl_uint) * 512));
 	V_RETURN_CL(clErr, "Error executing Kernel m_ScanWorkEfficientKernel!");
 
 	SAFE_DELETE_ARRAY(testOutput);
@@ -282,12 +253,10 @@ void CScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueu
 	//finish all before we start meassuring the time
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	CTimer timer;
-	timer.Start();
-
-	//run the kernel N times
-	unsigned int nIterations = 100;
-	for(unsigned int i = 0; i < nIterations; i++) {
+	//run the kernel N times, every iteration is timed on its own and the first one is a warmup
+	CSamplingTimer timer(1);
+	for(unsigned int i = 0; i < m_Iterations + 1; i++) {
+		timer.Start();
 		//run selected task
 		switch (Task){
 			case 0:
@@ -297,15 +266,17 @@ void CScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueu
 				Scan_WorkEfficient(Context, CommandQueue, LocalWorkSize);
 				break;
 		}
+		//wait until the command queue is empty again
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		timer.Stop();
 	}
 
-	//wait until the command queue is empty again
-	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
-
-	timer.Stop();
-
-	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	double ms = timer.GetMean();
 	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	cout << "  ";
+	timer.PrintStatistics(cout);
+	cout << endl;
+	CBenchmarkReport::Record(g_kernelNames[Task], timer.GetSamples(), m_N, "Gelem/s");
 }
 
 
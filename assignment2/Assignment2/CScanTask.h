@@ -20,14 +20,19 @@
 #ifndef _CSCAN_TASK_H
 #define _CSCAN_TASK_H
 
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/IAsyncBuildComputeTask.h"
+#include "../../Common/CLHandles.h"
+
+#include <vector>
 
 //! A2 / T2 Parallel prefix sum (scan)
-class CScanTask : public IComputeTask
+class CScanTask : public IComputeTask, public IAsyncBuildComputeTask
 {
 public:
 	//! The second parameter is necessary to pre-allocate the multi-level arrays
-	CScanTask(size_t ArraySize, size_t MinLocalWorkSize);
+	//! Iterations is the number of timed runs of each GPU variant
+	CScanTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int Iterations = 100);
 
 	virtual ~CScanTask();
 
@@ -42,6 +47,9 @@ public:
 
 	virtual bool ValidateResults();
 
+	// IAsyncBuildComputeTask
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
 protected:
 
 	void Scan_Naive(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
@@ -51,6 +59,7 @@ protected:
 	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
 
 	unsigned int		m_N;
+	unsigned int		m_Iterations;
 
 	//float data on the CPU
 	unsigned int		*m_hArray;
@@ -60,19 +69,19 @@ protected:
 	bool				m_bValidationResults[2];
 
 	// ping-pong arrays for the naive scan
-	cl_mem				m_dPingArray;
-	cl_mem				m_dPongArray;
+	DeviceBuffer<cl_uint>	m_dPingArray;
+	DeviceBuffer<cl_uint>	m_dPongArray;
 
 	// arrays for each level of the work-efficient scan
 	size_t				m_MinLocalWorkSize;
 	unsigned int		m_nLevels;
-	cl_mem				*m_dLevelArrays;
+	std::vector<DeviceBuffer<cl_uint> >	m_dLevelArrays;
 
 	//OpenCL program and kernels
-	cl_program			m_Program;
-	cl_kernel			m_ScanNaiveKernel;
-	cl_kernel			m_ScanWorkEfficientKernel;
-	cl_kernel			m_ScanWorkEfficientAddKernel;
+	CLProgram			m_Program;
+	CLKernel			m_ScanNaiveKernel;
+	CLKernel			m_ScanWorkEfficientKernel;
+	CLKernel			m_ScanWorkEfficientAddKernel;
 };
 
 #endif // _CSCAN_TASK_H
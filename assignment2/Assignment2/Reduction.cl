@@ -62,61 +62,65 @@ __kernel void Reduction_DecompUnroll(const __global uint* inArray, __global uint
 	int grp = get_group_id(0);
 	int lSize = get_local_size(0);
 
-	if (LID < get_local_size(0))
-	{
-		// writing 512 global values to local memory
-		localBlock[LID] = inArray[LID + grp * lSize];
-	}
+	// writing lSize global values to local memory
+	localBlock[LID] = inArray[LID + grp * lSize];
 	barrier(CLK_LOCAL_MEM_FENCE);
 
+	// the loop runs down to 64 values, the remaining steps are unrolled
 	unsigned int currentSize = lSize;
-	//unsigned int warpSize = WARP_SZ;
-	bool isReduced = false;
-	while (!isReduced)
+	while (currentSize > 64)
 	{
-		//iterations on local array
-		currentSize = currentSize / 2;			//scales down with iterations
+		currentSize = currentSize / 2;
 		if (LID < currentSize)
-		{
 			localBlock[LID] = localBlock[LID] + localBlock[LID + currentSize];
-		}
 		barrier(CLK_LOCAL_MEM_FENCE);
-		if (currentSize == 64) isReduced = true;
-	}
-	
-	if (currentSize == 64)
-	{
-		for (unsigned int i = 0; i < 32; i++)
-			localBlock[i] = localBlock[i] + localBlock[i + 32];
-		currentSize = 32;
-	}
-	if (currentSize == 32)
-	{
-		for (unsigned int i = 0; i < 16; i++)
-			localBlock[i] = localBlock[i] + localBlock[i + 16];
-		currentSize = 16;
-	}
-	if (currentSize == 16)
-	{
-		for (unsigned int i = 0; i < 8; i++)
-			localBlock[i] = localBlock[i] + localBlock[i + 8];
-		currentSize = 8;
 	}
-	if (currentSize == 8)
-	{
-		for (unsigned int i = 0; i < 4; i++)
-			localBlock[i] = localBlock[i] + localBlock[i + 4];
-		currentSize = 4;
+
+	// OpenCL does not guarantee lock-step execution of a warp, so every step still needs a barrier.
+	// lSize is the same for the whole work-group, so all work-items reach the same barriers.
+#define REDUCTION_UNROLLED_STEP(half) \
+	if (lSize > half) \
+	{ \
+		if (LID < half) \
+			localBlock[LID] = localBlock[LID] + localBlock[LID + half]; \
+		barrier(CLK_LOCAL_MEM_FENCE); \
 	}
-	if (currentSize == 4)
+	REDUCTION_UNROLLED_STEP(32)
+	REDUCTION_UNROLLED_STEP(16)
+	REDUCTION_UNROLLED_STEP(8)
+	REDUCTION_UNROLLED_STEP(4)
+	REDUCTION_UNROLLED_STEP(2)
+	REDUCTION_UNROLLED_STEP(1)
+#undef REDUCTION_UNROLLED_STEP
+
+	if (LID == 0)
+		outArray[grp] = localBlock[0];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduces an array of arbitrary length to one partial sum per work-group (used by the multi-device mode,
+// where every device gets a slice of the input). The work-items first accumulate privately in a
+// grid-stride loop, so the number of work-groups does not depend on the length of the slice.
+// The local size has to be a power of two.
+__kernel void Reduction_Partial(const __global uint* inArray, __global uint* outArray, uint numElements, __local uint* localBlock)
+{
+	int LID = get_local_id(0);
+	int lSize = get_local_size(0);
+
+	uint sum = 0;
+	for (uint i = get_global_id(0); i < numElements; i += get_global_size(0))
+		sum += inArray[i];
+	localBlock[LID] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int stride = lSize / 2; stride > 0; stride /= 2)
 	{
-		localBlock[0] = localBlock[0] + localBlock[2];
-		localBlock[1] = localBlock[1] + localBlock[3];
+		if (LID < stride)
+			localBlock[LID] += localBlock[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
 	}
-	if (currentSize == 2)
-		localBlock[0] = localBlock[0] + localBlock[1];
-
 
-	outArray[grp] = localBlock[0];
-	// TO DO: Kernel implementation
+	if (LID == 0)
+		outArray[get_group_id(0)] = localBlock[0];
 }
@@ -0,0 +1,108 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "C8BitImage.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4996) //fopen
+#endif
+
+using namespace std;
+
+#define BMP_HEADER_SIZE 54
+
+// BMP fields are little endian, independent of the host
+static void StoreLE(unsigned char* pDst, uint32_t Value, int Bytes)
+{
+	for(int i = 0; i < Bytes; i++)
+		pDst[i] = (unsigned char)(Value >> (8 * i));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// C8BitImage
+
+C8BitImage::C8BitImage(EFormat Format, unsigned int Width, unsigned int Height)
+	: m_Format(Format), m_Width(Width), m_Height(Height)
+{
+	m_RowStride = size_t(Width) * GetChannels();
+	if(m_Format == FORMAT_BMP)
+		m_RowStride = (m_RowStride + 3) & ~size_t(3);
+	size_t payloadSize = m_RowStride * Height;
+
+	if(m_Format == FORMAT_BMP)
+	{
+		m_HeaderSize = BMP_HEADER_SIZE;
+		m_Data.assign(m_HeaderSize + payloadSize, 0);
+		unsigned char* h = &m_Data[0];
+		h[0] = 'B';
+		h[1] = 'M';
+		StoreLE(h +  2, uint32_t(m_Data.size()), 4);	//file size
+		StoreLE(h + 10, BMP_HEADER_SIZE, 4);			//offset of the pixels
+		StoreLE(h + 14, 40, 4);							//size of the info header
+		StoreLE(h + 18, Width, 4);
+		StoreLE(h + 22, Height, 4);						//positive: bottom row first
+		StoreLE(h + 26, 1, 2);							//planes
+		StoreLE(h + 28, 24, 2);							//bits per pixel
+		StoreLE(h + 34, uint32_t(payloadSize), 4);
+		StoreLE(h + 38, 2835, 4);						//72 dpi
+		StoreLE(h + 42, 2835, 4);
+	}
+	else
+	{
+		char header[64];
+		int headerSize = snprintf(header, sizeof(header), "%s\n%u %u\n255\n", m_Format == FORMAT_PGM ? "P5" : "P6", Width, Height);
+		m_HeaderSize = size_t(headerSize);
+		m_Data.resize(m_HeaderSize + payloadSize);
+		copy(header, header + headerSize, m_Data.begin());
+	}
+}
+
+C8BitImage::EFormat C8BitImage::GetFormat(const string& FileName)
+{
+	size_t dot = FileName.rfind('.');
+	string extension = dot == string::npos ? string() : FileName.substr(dot + 1);
+	if(extension == "bmp" || extension == "BMP")
+		return FORMAT_BMP;
+	if(extension == "ppm" || extension == "PPM")
+		return FORMAT_PPM;
+	if(extension == "pgm" || extension == "PGM")
+		return FORMAT_PGM;
+	return FORMAT_UNKNOWN;
+}
+
+unsigned char* C8BitImage::GetRow(unsigned int Y)
+{
+	size_t row = m_Format == FORMAT_BMP ? m_Height - 1 - Y : Y;
+	return &m_Data[m_HeaderSize + row * m_RowStride];
+}
+
+bool C8BitImage::Save(const string& FileName) const
+{
+	if(m_Format == FORMAT_UNKNOWN)
+	{
+		cerr << "Unknown image format of " << FileName << "." << endl;
+		return false;
+	}
+
+	FILE* f = fopen(FileName.c_str(), "wb");
+	if(!f)
+	{
+		cerr << "Could not open \"" << FileName << "\"" << endl;
+		return false;
+	}
+
+	bool ok = fwrite(m_Data.data(), 1, m_Data.size(), f) == m_Data.size();
+	ok &= fclose(f) == 0;
+	if(!ok)
+		cerr << "Error writing " << FileName << "." << endl;
+	return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,69 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _C8BIT_IMAGE_H
+#define _C8BIT_IMAGE_H
+
+#include <string>
+#include <vector>
+
+//! An 8 bit image kept in the layout of its file, for previews of the float results
+/*!
+	The buffer holds the header followed by the rows exactly as they are stored (BMP: BGR,
+	bottom row first, rows padded to 4 bytes), so Save() writes the whole file with a
+	single call. Fill the rows through GetRow(), e.g. with CImageConversion::Quantize().
+*/
+class C8BitImage
+{
+public:
+	enum EFormat
+	{
+		FORMAT_UNKNOWN = 0,
+		FORMAT_BMP,			//!< 24 bit BGR
+		FORMAT_PPM,			//!< binary RGB (P6)
+		FORMAT_PGM			//!< binary grayscale (P5)
+	};
+
+	C8BitImage(EFormat Format, unsigned int Width, unsigned int Height);
+
+	//! The format belonging to the extension of FileName (".bmp", ".ppm" or ".pgm")
+	static EFormat GetFormat(const std::string& FileName);
+
+	//! 1 for PGM, 3 otherwise
+	unsigned int GetChannels() const { return m_Format == FORMAT_PGM ? 1 : 3; }
+
+	//! True if the channels of a pixel are stored as B, G, R
+	bool IsBGR() const { return m_Format == FORMAT_BMP; }
+
+	//! Row Y counted from the top, Width * GetChannels() bytes
+	unsigned char* GetRow(unsigned int Y);
+
+	bool Save(const std::string& FileName) const;
+
+protected:
+	EFormat						m_Format;
+	unsigned int				m_Width;
+	unsigned int				m_Height;
+	size_t						m_HeaderSize;
+	//bytes per row including the padding
+	size_t						m_RowStride;
+	std::vector<unsigned char>	m_Data;
+};
+
+#endif // _C8BIT_IMAGE_H
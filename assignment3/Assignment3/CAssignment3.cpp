@@ -22,42 +22,62 @@ bool CAssignment3::DoCompute()
 	cout<<"########################################"<<endl;
 	cout<<"GPU Computing assignment 3"<<endl<<endl;
 
-	cout<<"IMPORTANT: Make sure you always check the difference images."<<endl;
+	cout<<"IMPORTANT: Make sure you always check the difference images (--difference-images)."<<endl;
 	cout<<"The CPU 'gold' test is only suitable to catch trivial errors,"<<endl;
-	cout<<"A low MSE (mean squared error) might still happen with a few corrupted pixels."<<endl;
+	cout<<"A low MSE (mean squared error) might still happen with a few corrupted pixels,"<<endl;
+	cout<<"the number of mismatching values tells how many there are."<<endl;
 
-	cout<<"########################################"<<endl;
-	cout<<"Task 1: 3x3 convolution"<<endl<<endl;
+	// the defaults below can be overridden on the command line, e.g. --task separable --local 16x16,32x8 --input Images/other.pfm
+	// (--preview bmp additionally saves 8 bit versions of the result images)
+	// a directory as --input runs conv3x3, separable and histogram over all its images (IBatchComputeTask)
+
+	if(m_Options.IsTaskSelected("conv3x3"))
 	{
-		size_t TileSize[2] = {32, 16};
+		AddBenchmarkSection("Task 1: 3x3 convolution");
+
 		float ConvKernel[3][3] = {
 			{ -1.0f / 8.0f, -1.0f / 8.0f, -1.0f / 8.0f },
 			{ -1.0f / 8.0f,  1.0f,        -1.0f / 8.0f },
 			{ -1.0f / 8.0f, -1.0f / 8.0f, -1.0f / 8.0f },
 		};
-		CConvolution3x3Task convTask("Images/input.pfm", TileSize, ConvKernel, true, 0.0f);
-		RunComputeTask(convTask, TileSize);
+		SBenchmarkConfig defaults = {{0, 1, 1}, {32, 16, 1}, 1000, "Images/input.pfm"};
+		AddBenchmark("conv3x3", defaults, [&](const SBenchmarkConfig& Config) {
+			size_t TileSize[2] = {Config.LocalWorkSize[0], Config.LocalWorkSize[1]};
+			CConvolution3x3Task* task = new CConvolution3x3Task(Config.Input, TileSize, ConvKernel, true, 0.0f);
+			task->SetIterations(Config.Iterations);
+			task->SetPreviewFormat(m_Options.GetPreviewFormat());
+			task->SetSaveDifferenceImage(m_Options.IsDifferenceImageRequested());
+			return unique_ptr<IComputeTask>(task);
+		});
 	}
 
 
-	cout<<endl<<"########################################"<<endl;
-	cout<<"Task 2: Separable convolution"<<endl<<endl;
+	if(m_Options.IsTaskSelected("separable"))
 	{
-		size_t HGroupSize[2] = {32, 16};
-		size_t VGroupSize[2] = {32, 16};
+		AddBenchmarkSection("Task 2: Separable convolution");
+
+		// note: the local size of the run is used for the horizontal and the vertical pass,
+		// our framework passes it to RunComputeTask() as well
+		SBenchmarkConfig defaults = {{0, 1, 1}, {32, 16, 1}, 100, "Images/input.pfm"};
+		auto addSeparable = [&](const string& Name, int KernelRadius, float* pConvKernel) {
+			AddBenchmark("separable." + Name, defaults, [&](const SBenchmarkConfig& Config) {
+				size_t GroupSize[2] = {Config.LocalWorkSize[0], Config.LocalWorkSize[1]};
+				CConvolutionSeparableTask* task = new CConvolutionSeparableTask(Name, Config.Input, GroupSize, GroupSize,
+					4, 4, KernelRadius, pConvKernel, pConvKernel);
+				task->SetIterations(Config.Iterations);
+				task->SetPreviewFormat(m_Options.GetPreviewFormat());
+				task->SetSaveDifferenceImage(m_Options.IsDifferenceImageRequested());
+				return unique_ptr<IComputeTask>(task);
+			});
+		};
 
-	
 		{
 			//simple box filter
 			float ConvKernel[9];
 			for(int i = 0; i < 9; i++)
 				ConvKernel[i] = 1.0f / 9.0f;
 
-			CConvolutionSeparableTask convTask("box_4x4", "Images/input.pfm", HGroupSize, VGroupSize,
-				4, 4, 4, ConvKernel, ConvKernel);
-			// note: the last argument is ignored, but our framework requires it
-			// for the horizontal and vertical passes different local sizes might be used
-			RunComputeTask(convTask, HGroupSize);
+			addSeparable("box_4x4", 4, ConvKernel);
 		}
 
 		{
@@ -66,9 +86,7 @@ bool CAssignment3::DoCompute()
 			for(int i = 0; i < 17; i++)
 				ConvKernel[i] = 1.0f / 17.0f;
 
-			CConvolutionSeparableTask convTask("box_8x8", "Images/input.pfm", HGroupSize, VGroupSize,
-				4, 4, 8, ConvKernel, ConvKernel);
-			RunComputeTask(convTask, HGroupSize);
+			addSeparable("box_8x8", 8, ConvKernel);
 		}
 
 		{
@@ -76,42 +94,51 @@ bool CAssignment3::DoCompute()
 			float ConvKernel[7] = {
 				0.000817774f, 0.0286433f, 0.235018f, 0.471041f, 0.235018f, 0.0286433f, 0.000817774f
 			};
-			CConvolutionSeparableTask convTask("gauss_3x3", "Images/input.pfm", HGroupSize, VGroupSize,
-				4, 4, 3, ConvKernel, ConvKernel);
-			RunComputeTask(convTask, HGroupSize);
+			addSeparable("gauss_3x3", 3, ConvKernel);
 		}
 	}
 
 
-	cout<<endl<<"########################################"<<endl;
-	cout<<"Task 3: Separable bilateral convolution"<<endl<<endl;
+	if(m_Options.IsTaskSelected("bilateral"))
 	{
-		size_t HGroupSize[2] = {32, 4};
-		size_t VGroupSize[2] = {32, 4};
+		AddBenchmarkSection("Task 3: Separable bilateral convolution");
 
 		float ConvKernel[9] = {0.010284844f,	0.0417071f,	0.113371652f,	0.206576619f,	0.252313252f,	0.206576619f,	0.113371652f,	0.0417071f,	0.010284844f};
 
-		CConvolutionBilateralTask convTask("Images/color.pfm", "Images/normals.pfm", "Images/depth.pfm", HGroupSize, VGroupSize,
-			4, 4, 4, ConvKernel, ConvKernel);
-		RunComputeTask(convTask, HGroupSize);
+		// the input of a run are the color, normal and depth images
+		SBenchmarkConfig defaults = {{0, 1, 1}, {32, 4, 1}, 100, "Images/color.pfm+Images/normals.pfm+Images/depth.pfm"};
+		AddBenchmark("bilateral", defaults, [&](const SBenchmarkConfig& Config) {
+			vector<string> files = CBenchmarkOptions::SplitInputFiles(Config.Input);
+			if(files.size() != 3)
+			{
+				cerr<<"The input of the bilateral filter is <color>+<normals>+<depth>."<<endl;
+				return unique_ptr<IComputeTask>();
+			}
+			size_t GroupSize[2] = {Config.LocalWorkSize[0], Config.LocalWorkSize[1]};
+			CConvolutionBilateralTask* task = new CConvolutionBilateralTask(files[0], files[1], files[2], GroupSize, GroupSize,
+				4, 4, 4, ConvKernel, ConvKernel);
+			task->SetIterations(Config.Iterations);
+			task->SetPreviewFormat(m_Options.GetPreviewFormat());
+			task->SetSaveDifferenceImage(m_Options.IsDifferenceImageRequested());
+			return unique_ptr<IComputeTask>(task);
+		});
 	}
 
-	cout<<endl<<"########################################"<<endl;
-	cout<<"Task 4: Histogram"<<endl<<endl;
+	if(m_Options.IsTaskSelected("histogram"))
 	{
-		size_t group_size[2] = {16, 16};
-		{
-			CHistogramTask histogram(0.25f, 0.26f, false, "Images/input.pfm");
-			RunComputeTask(histogram, group_size);
-		}
+		AddBenchmarkSection("Task 4: Histogram");
 
+		SBenchmarkConfig defaults = {{0, 1, 1}, {16, 16, 1}, 100, "Images/input.pfm"};
+		for(int use_local_memory = 0; use_local_memory < 2; use_local_memory++)
 		{
-			CHistogramTask histogram(0.25f, 0.26f, true, "Images/input.pfm");
-			RunComputeTask(histogram, group_size);
+			AddBenchmark(use_local_memory ? "histogram.local" : "histogram.global", defaults, [&](const SBenchmarkConfig& Config) {
+				return unique_ptr<IComputeTask>(new CHistogramTask(0.25f, 0.26f, use_local_memory != 0, Config.Input, Config.Iterations));
+			});
 		}
 	}
 
-	return true;
+	// the programs of all queued tasks are built concurrently before the first run
+	return RunBenchmarks();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
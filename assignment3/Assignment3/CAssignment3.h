@@ -20,7 +20,7 @@
 #ifndef _CASSIGNMENT2_H
 #define _CASSIGNMENT2_H
 
-#include "../Common/CAssignmentBase.h"
+#include "../../Common/CAssignmentBase.h"
 
 //! Assignment3 solution
 class CAssignment3 : public CAssignmentBase
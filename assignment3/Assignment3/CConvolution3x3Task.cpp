@@ -5,11 +5,15 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CConvolution3x3Task.h"
 
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
 
 using namespace std;
 
+#define PROGRAM_FILE "Convolution3x3.cl"
+
 ///////////////////////////////////////////////////////////////////////////////
 // CConvolution3x3Task
 
@@ -43,6 +47,9 @@ CConvolution3x3Task(
 		m_KernelWeight = 1.0f;
 
 	m_FileNamePostfix = "3x3";
+	// This time we can take a bit less iterations than before, since the image processing itself
+	// is more time consuming than the previous tasks
+	m_Iterations = 1000;
 }
 
 CConvolution3x3Task::~CConvolution3x3Task()
@@ -66,46 +73,46 @@ bool CConvolution3x3Task::InitResources(cl_device_id Device, cl_context Context)
 	kernelConstants[9] = m_KernelWeight;
 	kernelConstants[10] = m_Offset;
 
-	m_dKernelConstants = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, 11 * sizeof(cl_float), 
-		kernelConstants, &clError);
-	V_RETURN_FALSE_CL(clError, "Error allocating device kernel constants.");
+	if(!m_dKernelConstants.Create(Context, CL_MEM_READ_ONLY, 11, kernelConstants))
+		return false;
 
 	string programCode;
 
-	CLUtil::LoadProgramSourceToMemory("../Assignment3/Convolution3x3.cl", programCode);
-	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode);
+	m_Program.Reset(CLUtil::BuildCachedCLProgram(Device, Context, programCode));
 	if(m_Program == nullptr) return false;
 
 	//create kernel(s)
-	m_ConvolutionKernel = clCreateKernel(m_Program, "Convolution", &clError);
+	m_ConvolutionKernel.Reset(clCreateKernel(m_Program, "Convolution", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
 	
 	//bind kernel attributes
-	clError = clSetKernelArg(m_ConvolutionKernel, 2, sizeof(cl_mem), (void*)&m_dKernelConstants);
-	clError |= clSetKernelArg(m_ConvolutionKernel, 3, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_ConvolutionKernel, 4, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_ConvolutionKernel, 5, sizeof(cl_uint), (void*)&m_Pitch);
+	clError = SetArgsFrom(m_ConvolutionKernel, 2, m_dKernelConstants, m_Width, m_Height, m_Pitch);
 	V_RETURN_FALSE_CL(clError, "Error setting kernel arguments");
 
 	return true;
 }
 
+void CConvolution3x3Task::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	// InitResources() builds the same program and only waits for this build
+	string programCode;
+	if(CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, programCode))
+		CLUtil::BuildCachedCLProgramAsync(Device, Context, programCode);
+}
+
 void CConvolution3x3Task::ReleaseResources()
 {
-	SAFE_RELEASE_MEMOBJECT(m_dKernelConstants);
+	m_dKernelConstants.Release();
 
-	SAFE_RELEASE_KERNEL(m_ConvolutionKernel);
-	SAFE_RELEASE_PROGRAM(m_Program);
+	m_ConvolutionKernel.Reset();
+	m_Program.Reset();
 
 	CConvolutionTaskBase::ReleaseResources();
 }
 
 void CConvolution3x3Task::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
-	// This time we can take a bit less iterations than before, since the image processing itself
-	// is more time consuming than the previous tasks
-	const int nIterations = 1000;
-
 	//do 1 or 3 convolution steps, based on the number of color channels to process
 	unsigned int numChannels = m_Monochrome ? 1 : 3;
 
@@ -113,11 +120,16 @@ void CConvolution3x3Task::ComputeGPU(cl_context Context, cl_command_queue Comman
 
 	//perform the convolution and measure the performance
 	double runTime = 0.0f;
+	CSamplingTimer samples;
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)	
-		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, nIterations);
+		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, m_Iterations, samples);
 
 
 	cout<<"  Average GPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	cout<<"  ";
+	samples.PrintStatistics(cout);
+	cout<<endl;
+	CBenchmarkReport::Record("gpu", samples.GetSamples(), double(m_Width) * m_Height, "Gpixels/s");
 
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
 	{
@@ -143,6 +155,7 @@ void CConvolution3x3Task::ComputeCPU()
 	}
 
 	cout<<"  CPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	CBenchmarkReport::Record("cpu", runTime, 1, double(m_Width) * m_Height, "Gpixels/s");
 
 	SaveImage("Images/CPUResult3x3.pfm", m_hCPUResultChannels);
 }
@@ -188,7 +201,7 @@ double CConvolution3x3Task::ConvolutionChannelCPU(unsigned int Channel)
 }
 
 double CConvolution3x3Task::ConvolutionChannelGPU(unsigned int Channel, cl_context Context, 
-												cl_command_queue CommandQueue, int NIterations)
+												cl_command_queue CommandQueue, int NIterations, CSamplingTimer& Samples)
 {
 	size_t globalWorkSize[2] = {CLUtil::GetGlobalWorkSize(m_Width, m_TileSize[0]), CLUtil::GetGlobalWorkSize(m_Height, m_TileSize[1])};
 
@@ -196,18 +209,38 @@ double CConvolution3x3Task::ConvolutionChannelGPU(unsigned int Channel, cl_conte
 	//cl_ulong localMemorySize;		//49152 Byte -> store 12288 floats -> 110 * 110 is maximum size of tiles for local memory
 	//clGetDeviceInfo(m_Device_ID, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMemorySize, &bufferSize);
 
-	unsigned int overWidth = m_Width % m_TileSize[0];
-	unsigned int overHeight = m_Height % m_TileSize[1];
-
 	cl_int clErr;
-	clErr  = clSetKernelArg(m_ConvolutionKernel, 0, sizeof(cl_mem), (void*)&m_dResultChannels[Channel]);
-	clErr |= clSetKernelArg(m_ConvolutionKernel, 1, sizeof(cl_mem), (void*)&m_dSourceChannels[Channel]);
-	V_RETURN_0_CL(clErr, "Error setting kernel arguments!");
-
-	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ConvolutionKernel, 2, NULL, globalWorkSize, m_TileSize, 0, NULL, NULL);
+	clErr = Launch(CommandQueue, m_ConvolutionKernel, 2, globalWorkSize, m_TileSize, m_dResultChannels[Channel], m_dSourceChannels[Channel]);
 	V_RETURN_0_CL(clErr, "Error executing kernel m_ComvolutionKernel!");
 
-	return CLUtil::ProfileKernel(CommandQueue, m_ConvolutionKernel, 2, globalWorkSize, m_TileSize, NIterations);
+	CSamplingTimer kernelSamples;
+	double runTime = CLUtil::ProfileKernel(CommandQueue, m_ConvolutionKernel, 2, globalWorkSize, m_TileSize, NIterations, &kernelSamples);
+	Samples.Accumulate(kernelSamples);
+	return runTime;
+}
+
+bool CConvolution3x3Task::ResizeImageResources(cl_context Context)
+{
+	if(!CConvolutionTaskBase::ResizeImageResources(Context))
+		return false;
+
+	//the constants stay, only the size arguments change
+	cl_int clError = SetArgsFrom(m_ConvolutionKernel, 2, m_dKernelConstants, m_Width, m_Height, m_Pitch);
+	V_RETURN_FALSE_CL(clError, "Error setting kernel arguments");
+	return true;
+}
+
+bool CConvolution3x3Task::ConvolveImageGPU(cl_command_queue CommandQueue)
+{
+	size_t globalWorkSize[2] = {CLUtil::GetGlobalWorkSize(m_Width, m_TileSize[0]), CLUtil::GetGlobalWorkSize(m_Height, m_TileSize[1])};
+
+	unsigned int numChannels = m_Monochrome ? 1 : 3;
+	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
+	{
+		cl_int clErr = Launch(CommandQueue, m_ConvolutionKernel, 2, globalWorkSize, m_TileSize, m_dResultChannels[iChannel], m_dSourceChannels[iChannel]);
+		V_RETURN_FALSE_CL(clErr, "Error executing kernel m_ComvolutionKernel!");
+	}
+	return true;
 }
 
 
@@ -21,11 +21,12 @@
 #define _CCONVOLUTION_3X3_TASK_H
 
 #include "CConvolutionTaskBase.h"
+#include "../../Common/IAsyncBuildComputeTask.h"
 
 #include <string>
 
 //! A3 / T1 3x3 convolution
-class CConvolution3x3Task : public CConvolutionTaskBase
+class CConvolution3x3Task : public CConvolutionTaskBase, public IAsyncBuildComputeTask
 {
 public:
 	CConvolution3x3Task(
@@ -47,12 +48,21 @@ public:
 
 	virtual void ComputeCPU();
 
+	// IAsyncBuildComputeTask
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
 protected:
+
+	virtual bool ConvolveImageGPU(cl_command_queue CommandQueue);
+	virtual bool ResizeImageResources(cl_context Context);
 	
 	// the return value is the run time in milliseconds
 	double ConvolutionChannelCPU(unsigned int Channel);
-	//the last parameter is for timing, and the returned value is the average run time in milliseconds
-	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations);
+	//NIterations is for timing, the returned value is the average run time in milliseconds
+	//and the time of every iteration is added to Samples
+	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations,
+		CSamplingTimer& Samples);
 
 	size_t			m_TileSize[2];
 
@@ -62,10 +72,10 @@ protected:
 	float			m_Offset;
 
 	//kernel constants
-	cl_mem			m_dKernelConstants = nullptr;
+	DeviceBuffer<cl_float>	m_dKernelConstants;
 
-	cl_program		m_Program = nullptr;
-	cl_kernel		m_ConvolutionKernel = nullptr;
+	CLProgram		m_Program;
+	CLKernel		m_ConvolutionKernel;
 
 	cl_device_id	m_Device_ID;
 
@@ -5,8 +5,10 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CConvolutionBilateralTask.h"
 
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
 #include "Pfm.h"
 
 #include <sstream>
@@ -35,7 +37,7 @@ CConvolutionBilateralTask::CConvolutionBilateralTask(
 	, m_DepthFileName(DepthFileName)
 {
 	m_FileNamePostfix = "Bilateral";
-	m_ProgramName = "../Assignment3/ConvolutionBilateral.cl";
+	m_ProgramName = "ConvolutionBilateral.cl";
 }
 
 CConvolutionBilateralTask::~CConvolutionBilateralTask()
@@ -59,6 +61,7 @@ bool CConvolutionBilateralTask::InitResources(cl_device_id Device, cl_context Co
 		normalsPFM.width != depthsPFM.width)
 	{
 		cerr<<"Bilateral filtering data mismatch: the feature images must have the same dimensions as the color data"<<endl;
+		return false;
 	}
 
 	m_Height = normalsPFM.height;
@@ -72,28 +75,23 @@ bool CConvolutionBilateralTask::InitResources(cl_device_id Device, cl_context Co
 	m_hGPUDiscBuffer = new cl_int[m_Height * m_Pitch];
 
 	unsigned int pixelOffset = 0;
-	unsigned int trippleOffset = 0;
 	for(unsigned int y = 0; y < m_Height; y++) {
+		const float* normals = normalsPFM.GetRow(y);
+		const float* depths = depthsPFM.GetRow(y);
 		for(unsigned int x = 0; x < m_Width; x++) {
-			m_hNormDepthBuffer[pixelOffset].s[0] = normalsPFM.pImg[trippleOffset    ];
-			m_hNormDepthBuffer[pixelOffset].s[1] = normalsPFM.pImg[trippleOffset + 1];
-			m_hNormDepthBuffer[pixelOffset].s[2] = normalsPFM.pImg[trippleOffset + 2];
-			m_hNormDepthBuffer[pixelOffset].s[3] = depthsPFM.pImg[trippleOffset];
+			m_hNormDepthBuffer[pixelOffset].s[0] = normals[3 * x    ];
+			m_hNormDepthBuffer[pixelOffset].s[1] = normals[3 * x + 1];
+			m_hNormDepthBuffer[pixelOffset].s[2] = normals[3 * x + 2];
+			m_hNormDepthBuffer[pixelOffset].s[3] = depths[3 * x];
 
 			pixelOffset++;
-			trippleOffset += 3;
 		}
 		pixelOffset += m_Pitch - m_Width;
 	}
 
-	cl_int clError = 0;
-	cl_int clErr;
-
-	m_dDiscBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE, m_Pitch * m_Height * sizeof(cl_int),  NULL, &clErr);
-	clError = clErr;
-	m_dNormDepthBuffer = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, m_Pitch * m_Height * sizeof(cl_float4),  m_hNormDepthBuffer, &clErr);
-	clError |= clErr;
-	V_RETURN_FALSE_CL(clError, "Error allocating device memory.");
+	if(!m_dDiscBuffer.Create(Context, CL_MEM_READ_WRITE, m_Pitch * m_Height) ||
+		!m_dNormDepthBuffer.Create(Context, CL_MEM_READ_ONLY, m_Pitch * m_Height, m_hNormDepthBuffer))
+		return false;
 
 	return CConvolutionSeparableTask::InitResources(Device, Context);
 }
@@ -103,46 +101,29 @@ bool CConvolutionBilateralTask::InitKernels()
 	cl_int clError;
 
 	//create kernel(s)
-	m_HorizontalKernel = clCreateKernel(m_Program, "ConvHorizontal", &clError);
+	m_HorizontalKernel.Reset(clCreateKernel(m_Program, "ConvHorizontal", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create horizontal kernel.");
 	
-	m_VerticalKernel = clCreateKernel(m_Program, "ConvVertical", &clError);
+	m_VerticalKernel.Reset(clCreateKernel(m_Program, "ConvVertical", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create vertical kernel.");
 
-	m_HorizontalDiscKernel = clCreateKernel(m_Program, "DiscontinuityHorizontal", &clError);
+	m_HorizontalDiscKernel.Reset(clCreateKernel(m_Program, "DiscontinuityHorizontal", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create horizontal discontinuity detection kernel.");
 
-	m_VerticalDiscKernel = clCreateKernel(m_Program, "DiscontinuityVertical", &clError);
+	m_VerticalDiscKernel.Reset(clCreateKernel(m_Program, "DiscontinuityVertical", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create vertical discontinuity detection kernel.");
 
 	//bind kernel attributes
-	clError  = clSetKernelArg(m_HorizontalDiscKernel, 0, sizeof(cl_mem), (void*)&m_dDiscBuffer);
-	clError |= clSetKernelArg(m_HorizontalDiscKernel, 1, sizeof(cl_mem), (void*)&m_dNormDepthBuffer);
-	clError |= clSetKernelArg(m_HorizontalDiscKernel, 2, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_HorizontalDiscKernel, 3, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_HorizontalDiscKernel, 4, sizeof(cl_uint), (void*)&m_Pitch);
-	V_RETURN_FALSE_CL(clError, "Error setting horizontal discontinuity kernel arguments");
-
-	clError  = clSetKernelArg(m_VerticalDiscKernel, 0, sizeof(cl_mem), (void*)&m_dDiscBuffer);
-	clError |= clSetKernelArg(m_VerticalDiscKernel, 1, sizeof(cl_mem), (void*)&m_dNormDepthBuffer);
-	clError |= clSetKernelArg(m_VerticalDiscKernel, 2, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_VerticalDiscKernel, 3, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_VerticalDiscKernel, 4, sizeof(cl_uint), (void*)&m_Pitch);
-	V_RETURN_FALSE_CL(clError, "Error setting vertical discontinuity kernel arguments");
-
-	clError  = clSetKernelArg(m_HorizontalKernel, 2, sizeof(cl_mem), (void*)&m_dDiscBuffer);
-	clError |= clSetKernelArg(m_HorizontalKernel, 3, sizeof(cl_mem), (void*)&m_dKernelHorizontal);
-	clError |= clSetKernelArg(m_HorizontalKernel, 4, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_HorizontalKernel, 5, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_HorizontalKernel, 6, sizeof(cl_uint), (void*)&m_Pitch);
-	V_RETURN_FALSE_CL(clError, "Error setting horizontal kernel arguments");
-		
-	clError  = clSetKernelArg(m_VerticalKernel, 2, sizeof(cl_mem), (void*)&m_dDiscBuffer);
-	clError |= clSetKernelArg(m_VerticalKernel, 3, sizeof(cl_mem), (void*)&m_dKernelVertical);
-	clError |= clSetKernelArg(m_VerticalKernel, 4, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_VerticalKernel, 5, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_VerticalKernel, 6, sizeof(cl_uint), (void*)&m_Pitch);
-	V_RETURN_FALSE_CL(clError, "Error setting vertical kernel arguments");
+	V_RETURN_FALSE_CL(SetArgs(m_HorizontalDiscKernel, m_dDiscBuffer, m_dNormDepthBuffer, m_Width, m_Height, m_Pitch),
+		"Error setting horizontal discontinuity kernel arguments");
+	V_RETURN_FALSE_CL(SetArgs(m_VerticalDiscKernel, m_dDiscBuffer, m_dNormDepthBuffer, m_Width, m_Height, m_Pitch),
+		"Error setting vertical discontinuity kernel arguments");
+
+	//arguments 0 and 1 are the source and destination of a channel, see ConvolutionChannelGPU()
+	V_RETURN_FALSE_CL(SetArgsFrom(m_HorizontalKernel, 2, m_dDiscBuffer, m_dKernelHorizontal, m_Width, m_Height, m_Pitch),
+		"Error setting horizontal kernel arguments");
+	V_RETURN_FALSE_CL(SetArgsFrom(m_VerticalKernel, 2, m_dDiscBuffer, m_dKernelVertical, m_Width, m_Height, m_Pitch),
+		"Error setting vertical kernel arguments");
 
 	return true;
 }
@@ -153,11 +134,11 @@ void CConvolutionBilateralTask::ReleaseResources()
 	SAFE_DELETE_ARRAY( m_hGPUDiscBuffer );
 	SAFE_DELETE_ARRAY( m_hNormDepthBuffer );
 
-	SAFE_RELEASE_MEMOBJECT( m_dDiscBuffer );
-	SAFE_RELEASE_MEMOBJECT( m_dNormDepthBuffer );
+	m_dDiscBuffer.Release();
+	m_dNormDepthBuffer.Release();
 
-	SAFE_RELEASE_KERNEL( m_HorizontalDiscKernel );
-	SAFE_RELEASE_KERNEL( m_VerticalDiscKernel );
+	m_HorizontalDiscKernel.Reset();
+	m_VerticalDiscKernel.Reset();
 	
 	CConvolutionSeparableTask::ReleaseResources();
 }
@@ -165,26 +146,32 @@ void CConvolutionBilateralTask::ReleaseResources()
 void CConvolutionBilateralTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
 	size_t dataSize = m_Pitch * m_Height * sizeof(cl_float);
-	int nIterations = 100;
 
 	unsigned int numChannels = 3;
 
 	double runTime = 0.0f;
+	CSamplingTimer samples, kernelSamples;
 
 	// detect discontinuities
 	size_t globalWorkSizeH[2] = {CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]), CLUtil::GetGlobalWorkSize(m_Height, m_LocalSizeHorizontal[1])};	
-	runTime += CLUtil::ProfileKernel(CommandQueue, m_HorizontalDiscKernel, 2, globalWorkSizeH, LocalWorkSize, nIterations);
+	runTime += CLUtil::ProfileKernel(CommandQueue, m_HorizontalDiscKernel, 2, globalWorkSizeH, LocalWorkSize, m_Iterations, &kernelSamples);
+	samples.Accumulate(kernelSamples);
 
 	size_t globalWorkSizeV[2] = {CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]), CLUtil::GetGlobalWorkSize(m_Height / m_StepsVertical, m_LocalSizeVertical[1])};
-	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalDiscKernel, 2, globalWorkSizeV, LocalWorkSize, nIterations);
+	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalDiscKernel, 2, globalWorkSizeV, LocalWorkSize, m_Iterations, &kernelSamples);
+	samples.Accumulate(kernelSamples);
 
 
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
 	{
-		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, nIterations);
+		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, m_Iterations, samples);
 	}
 
 	cout<<"  Average GPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	cout<<"  ";
+	samples.PrintStatistics(cout);
+	cout<<endl;
+	CBenchmarkReport::Record("gpu", samples.GetSamples(), double(m_Width) * m_Height, "Gpixels/s");
 
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
 	{
@@ -201,6 +188,14 @@ void CConvolutionBilateralTask::ComputeGPU(cl_context Context, cl_command_queue
 	SaveIntImage("Images/GPUDiscontinuities.pfm", m_hGPUDiscBuffer);
 }
 
+bool CConvolutionBilateralTask::ComputeBatch(cl_device_id , cl_context , cl_command_queue ,
+	const std::string& Directory, size_t [3], bool& Valid)
+{
+	Valid = false;
+	cerr<<"Error: the bilateral filter needs the normals and depths of each image, it cannot run over "<<Directory<<"."<<endl;
+	return false;
+}
+
 void CConvolutionBilateralTask::ComputeCPU()
 {
 	double runTime = 0.0;
@@ -259,6 +254,7 @@ void CConvolutionBilateralTask::ComputeCPU()
 		runTime += ConvolutionChannelCPU(iChannel);
 
 	cout<<"  CPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	CBenchmarkReport::Record("cpu", runTime, 1, double(m_Width) * m_Height, "Gpixels/s");
 
 	// Store CPU results
 	SaveImage("Images/CPUResultBilateral.pfm", m_hCPUResultChannels);
@@ -379,25 +375,27 @@ double CConvolutionBilateralTask::ConvolutionChannelCPU(unsigned int Channel)
 	return timer.GetElapsedMilliseconds();
 }
 
-double CConvolutionBilateralTask::ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations)
+double CConvolutionBilateralTask::ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations,
+	CSamplingTimer& Samples)
 {
 	cl_int clErr;
 
 	double runTime = 0;
+	CSamplingTimer kernelSamples;
 
-	clErr  = clSetKernelArg(m_HorizontalKernel, 1, sizeof(cl_mem), (void*)&m_dSourceChannels[Channel]);
-	clErr |= clSetKernelArg(m_HorizontalKernel, 0, sizeof(cl_mem), (void*)&m_dGPUWorkingBuffer);
+	clErr = SetArgs(m_HorizontalKernel, m_dGPUWorkingBuffer, m_dSourceChannels[Channel]);
 	V_RETURN_0_CL(clErr, "Error setting horizontal kernel arguments");
 
 	size_t globalWorkSizeH[2] = {CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]), CLUtil::GetGlobalWorkSize(m_Height, m_LocalSizeHorizontal[1])};	
-	runTime += CLUtil::ProfileKernel(CommandQueue, m_HorizontalKernel, 2, globalWorkSizeH, m_LocalSizeHorizontal, NIterations);
+	runTime += CLUtil::ProfileKernel(CommandQueue, m_HorizontalKernel, 2, globalWorkSizeH, m_LocalSizeHorizontal, NIterations, &kernelSamples);
+	Samples.Accumulate(kernelSamples);
 
-	clErr  = clSetKernelArg(m_VerticalKernel, 1, sizeof(cl_mem), (void*)&m_dGPUWorkingBuffer);
-	clErr |= clSetKernelArg(m_VerticalKernel, 0, sizeof(cl_mem), (void*)&m_dResultChannels[Channel]);
+	clErr = SetArgs(m_VerticalKernel, m_dResultChannels[Channel], m_dGPUWorkingBuffer);
 	V_RETURN_0_CL(clErr, "Error setting vertical kernel arguments");
 
 	size_t globalWorkSizeV[2] = {CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]), CLUtil::GetGlobalWorkSize(m_Height / m_StepsVertical, m_LocalSizeVertical[1])};
-	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalKernel, 2, globalWorkSizeV, m_LocalSizeVertical, NIterations);
+	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalKernel, 2, globalWorkSizeV, m_LocalSizeVertical, NIterations, &kernelSamples);
+	Samples.Accumulate(kernelSamples);
 
 	return runTime;
 }
@@ -55,12 +55,19 @@ public:
 
 	virtual void ComputeCPU();
 
+	// IBatchComputeTask
+
+	//the normals and depths belong to one image, so the bilateral filter has no batch mode
+	virtual bool ComputeBatch(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue,
+		const std::string& Directory, size_t LocalWorkSize[3], bool& Valid);
+
 protected:
 
 	// the return value is the run time in milliseconds
 	double ConvolutionChannelCPU(unsigned int Channel);
-	// the return value is the run time in milliseconds
-	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations);
+	// the return value is the average run time in milliseconds, the time of every iteration is added to Samples
+	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations,
+		CSamplingTimer& Samples);
 
 	// These helper methods are used to build the discontinuity buffer
 	inline bool IsNormalDiscontinuity(const cl_float4 &n1, const cl_float4 &n2) {
@@ -82,12 +89,12 @@ protected:
 	cl_int*			m_hGPUDiscBuffer;
 
 	// device data
-	cl_mem			m_dDiscBuffer;
-	cl_mem			m_dNormDepthBuffer;
+	DeviceBuffer<cl_int>	m_dDiscBuffer;
+	DeviceBuffer<cl_float4>	m_dNormDepthBuffer;
 
 	// kernels for discontinuity detection
-	cl_kernel		m_HorizontalDiscKernel;
-	cl_kernel		m_VerticalDiscKernel;
+	CLKernel		m_HorizontalDiscKernel;
+	CLKernel		m_VerticalDiscKernel;
 
 };
 
@@ -5,11 +5,14 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CConvolutionSeparableTask.h"
 
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CLKernelArgs.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
 
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 using namespace std;
 
@@ -44,11 +47,10 @@ CConvolutionSeparableTask::CConvolutionSeparableTask(
 	memcpy(m_hKernelHorizontal, pKernelHorizontal, kernelSize * sizeof(float));
 	memcpy(m_hKernelVertical, pKernelVertical, kernelSize * sizeof(float));
 
-	m_dGPUWorkingBuffer = nullptr;
 	m_hCPUWorkingBuffer = nullptr;
 
 	m_FileNamePostfix = "Separable_" + OutFileName;
-	m_ProgramName = "../Assignment3/ConvolutionSeparable.cl";
+	m_ProgramName = "ConvolutionSeparable.cl";
 }
 
 CConvolutionSeparableTask::~CConvolutionSeparableTask()
@@ -69,18 +71,12 @@ bool CConvolutionSeparableTask::InitResources(cl_device_id Device, cl_context Co
 	//we can init the kernel buffer during creation as its contents will not change
 	const unsigned int kernelSize = 2 * m_KernelRadius + 1;
 
-	cl_int clError = 0;
-	cl_int clErr;
-	m_dKernelHorizontal = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, kernelSize * sizeof(cl_float), 
-		m_hKernelHorizontal, &clErr);
-	clError |= clErr;
-	m_dKernelVertical = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, kernelSize * sizeof(cl_float), 
-		m_hKernelVertical, &clErr);
-	clError |= clErr;
-	V_RETURN_FALSE_CL(clError, "Error allocating device kernel constants.");
+	if(!m_dKernelHorizontal.Create(Context, CL_MEM_READ_ONLY, kernelSize, m_hKernelHorizontal) ||
+		!m_dKernelVertical.Create(Context, CL_MEM_READ_ONLY, kernelSize, m_hKernelVertical))
+		return false;
 
-	m_dGPUWorkingBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE, m_Pitch * m_Height * sizeof(cl_float), NULL, &clError);
-	V_RETURN_FALSE_CL(clError, "Error allocating device working array");
+	if(!m_dGPUWorkingBuffer.Create(Context, CL_MEM_READ_WRITE, m_Pitch * m_Height))
+		return false;
 
 	m_hCPUWorkingBuffer = new float[m_Height * m_Pitch];
 
@@ -88,6 +84,23 @@ bool CConvolutionSeparableTask::InitResources(cl_device_id Device, cl_context Co
 
 	CLUtil::LoadProgramSourceToMemory(m_ProgramName, programCode);
 
+	m_Program.Reset(CLUtil::BuildCachedCLProgram(Device, Context, programCode, GetCompileOptions()));
+	if(m_Program == nullptr) return false;
+
+
+	return InitKernels();
+}
+
+void CConvolutionSeparableTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	// InitResources() builds the same program and only waits for this build
+	string programCode;
+	if(CLUtil::LoadProgramSourceToMemory(m_ProgramName, programCode))
+		CLUtil::BuildCachedCLProgramAsync(Device, Context, programCode, GetCompileOptions());
+}
+
+string CConvolutionSeparableTask::GetCompileOptions() const
+{
 	//This time we define several kernel-specific constants that we did not know during
 	//implementing the kernel, but we need to include during compile time.
 	stringstream compileOptions;
@@ -97,12 +110,47 @@ bool CConvolutionSeparableTask::InitResources(cl_device_id Device, cl_context Co
 	<<" -D H_RESULT_STEPS="<<m_StepsHorizontal
 	<<" -D V_GROUPSIZE_X="<<m_LocalSizeVertical[0]<<" -D V_GROUPSIZE_Y="<<m_LocalSizeVertical[1]
 	<<" -D V_RESULT_STEPS="<<m_StepsVertical;
+	return compileOptions.str();
+}
 
-	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode, compileOptions.str());
-	if(m_Program == nullptr) return false;
+bool CConvolutionSeparableTask::InitMultiDeviceResources(cl_context Context, const std::vector<cl_device_id>& Devices)
+{
+	string programCode;
+	CLUtil::LoadProgramSourceToMemory(m_ProgramName, programCode);
+	m_MultiDeviceProgram.Reset(CLUtil::BuildCLProgramForDevices(Devices, Context, programCode, GetCompileOptions()));
+	if(m_MultiDeviceProgram == nullptr) return false;
 
+	size_t numElements = m_Pitch * m_Height;
+	size_t numDevices = Devices.size();
+	m_DeviceHorizontalKernels.resize(numDevices);
+	m_DeviceVerticalKernels.resize(numDevices);
+	m_dDeviceSource.resize(numDevices);
+	m_dDeviceWorking.resize(numDevices);
+	m_dDeviceResult.resize(numDevices);
 
-	return InitKernels();
+	cl_int clError;
+	for(size_t i = 0; i < numDevices; i++)
+	{
+		if(!m_dDeviceSource[i].Create(Context, CL_MEM_READ_ONLY, numElements) ||
+			!m_dDeviceWorking[i].Create(Context, CL_MEM_READ_WRITE, numElements) ||
+			!m_dDeviceResult[i].Create(Context, CL_MEM_WRITE_ONLY, numElements))
+			return false;
+
+		m_DeviceHorizontalKernels[i].Reset(clCreateKernel(m_MultiDeviceProgram, "ConvHorizontal", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create horizontal kernel.");
+		m_DeviceVerticalKernels[i].Reset(clCreateKernel(m_MultiDeviceProgram, "ConvVertical", &clError));
+		V_RETURN_FALSE_CL(clError, "Failed to create vertical kernel.");
+
+		//the band height (vertical kernel argument 3) is set for every band
+		clError = SetArgs(m_DeviceHorizontalKernels[i], m_dDeviceWorking[i], m_dDeviceSource[i], m_dKernelHorizontal, m_Width, m_Pitch);
+		V_RETURN_FALSE_CL(clError, "Error setting horizontal kernel arguments");
+
+		clError  = SetArgs(m_DeviceVerticalKernels[i], m_dDeviceResult[i], m_dDeviceWorking[i], m_dKernelVertical);
+		clError |= SetArgsFrom(m_DeviceVerticalKernels[i], 4, m_Pitch);
+		V_RETURN_FALSE_CL(clError, "Error setting vertical kernel arguments");
+	}
+
+	return true;
 }
 
 bool CConvolutionSeparableTask::InitKernels()
@@ -110,68 +158,247 @@ bool CConvolutionSeparableTask::InitKernels()
 	cl_int clError;
 	
 	//create kernel(s)
-	m_HorizontalKernel = clCreateKernel(m_Program, "ConvHorizontal", &clError);
+	m_HorizontalKernel.Reset(clCreateKernel(m_Program, "ConvHorizontal", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create horizontal kernel.");
 	
-	m_VerticalKernel = clCreateKernel(m_Program, "ConvVertical", &clError);
+	m_VerticalKernel.Reset(clCreateKernel(m_Program, "ConvVertical", &clError));
 	V_RETURN_FALSE_CL(clError, "Failed to create vertical kernel.");
 
+	return SetSizeArgs();
+}
+
+bool CConvolutionSeparableTask::SetSizeArgs()
+{
+	cl_int clError;
+
 	//bind kernel attributes
 	//the resulting image will be in buffer 1
-	clError = clSetKernelArg(m_HorizontalKernel, 2, sizeof(cl_mem), (void*)&m_dKernelHorizontal);
-	clError |= clSetKernelArg(m_HorizontalKernel, 3, sizeof(cl_uint), (void*)&m_Width);
-	clError |= clSetKernelArg(m_HorizontalKernel, 4, sizeof(cl_uint), (void*)&m_Pitch);
+	clError = SetArgsFrom(m_HorizontalKernel, 2, m_dKernelHorizontal, m_Width, m_Pitch);
 	V_RETURN_FALSE_CL(clError, "Error setting horizontal kernel arguments");
 		
 	//the resulting image will be in buffer 0
-	clError = clSetKernelArg(m_VerticalKernel, 2, sizeof(cl_mem), (void*)&m_dKernelVertical);
-	clError |= clSetKernelArg(m_VerticalKernel, 3, sizeof(cl_uint), (void*)&m_Height);
-	clError |= clSetKernelArg(m_VerticalKernel, 4, sizeof(cl_uint), (void*)&m_Pitch);
+	clError = SetArgsFrom(m_VerticalKernel, 2, m_dKernelVertical, m_Height, m_Pitch);
 	V_RETURN_FALSE_CL(clError, "Error setting vertical kernel arguments");
 
 	return true;
 }
 
+bool CConvolutionSeparableTask::ResizeImageResources(cl_context Context)
+{
+	if(!CConvolutionTaskBase::ResizeImageResources(Context))
+		return false;
+
+	//the program, the kernels and the coefficients stay, the working buffers follow the image
+	if(!m_dGPUWorkingBuffer.Create(Context, CL_MEM_READ_WRITE, m_Pitch * m_Height))
+		return false;
+	SAFE_DELETE_ARRAY( m_hCPUWorkingBuffer );
+	m_hCPUWorkingBuffer = new float[m_Height * m_Pitch];
+
+	return SetSizeArgs();
+}
+
 void CConvolutionSeparableTask::ReleaseResources()
 {
 	SAFE_DELETE_ARRAY( m_hCPUWorkingBuffer );
 
-	SAFE_RELEASE_MEMOBJECT(m_dGPUWorkingBuffer);
-	SAFE_RELEASE_MEMOBJECT(m_dKernelHorizontal);
-	SAFE_RELEASE_MEMOBJECT(m_dKernelVertical);
+	m_dGPUWorkingBuffer.Release();
+	m_dKernelHorizontal.Release();
+	m_dKernelVertical.Release();
 
-	SAFE_RELEASE_KERNEL(m_HorizontalKernel);
-	SAFE_RELEASE_KERNEL(m_VerticalKernel);
-	SAFE_RELEASE_PROGRAM(m_Program);
+	m_HorizontalKernel.Reset();
+	m_VerticalKernel.Reset();
+	m_Program.Reset();
+
+	m_DeviceHorizontalKernels.clear();
+	m_DeviceVerticalKernels.clear();
+	m_dDeviceSource.clear();
+	m_dDeviceWorking.clear();
+	m_dDeviceResult.clear();
+	m_MultiDeviceProgram.Reset();
 }
 
 void CConvolutionSeparableTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
 	size_t dataSize = m_Pitch * m_Height * sizeof(cl_float);
-	int nIterations = 100;
 
 	unsigned int numChannels = 3;
 
 	double runTime = 0.0f;
+	CSamplingTimer samples;
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
 	{
-		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, nIterations);
+		runTime += ConvolutionChannelGPU(iChannel, Context, CommandQueue, m_Iterations, samples);
 	}
 
 	cout<<"  Average GPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	cout<<"  ";
+	samples.PrintStatistics(cout);
+	cout<<endl;
+	CBenchmarkReport::Record("gpu", samples.GetSamples(), double(m_Width) * m_Height, "Gpixels/s");
 
 	for(unsigned int iChannel = 0; iChannel < numChannels; iChannel++)
 	{
 		//copy the results back to the CPU
 		//(this time the data is in the same buffer as the input was, because of the 2 convolution passes)
-		V_RETURN_CL( clEnqueueReadBuffer(CommandQueue, m_dResultChannels[iChannel], CL_TRUE, 0, dataSize,
+		//the reads are queued back to back and only waited for once
+		V_RETURN_CL( clEnqueueReadBuffer(CommandQueue, m_dResultChannels[iChannel], CL_FALSE, 0, dataSize,
 									m_hGPUResultChannels[iChannel], 0, NULL, NULL), "Error reading back results from the device!" );
 
 	}
+	V_RETURN_CL( clFinish(CommandQueue), "Error reading back results from the device!" );
 	
 	SaveImage("Images/GPUResultSeparable_" + m_OutFileName + ".pfm", m_hGPUResultChannels);
 }
 
+bool CConvolutionSeparableTask::EnqueueBand(size_t Device, cl_command_queue CommandQueue, unsigned int Channel, size_t RowBegin, size_t RowEnd)
+{
+	//the band includes the halo rows needed by the vertical pass, clamped to the image
+	size_t bandBegin = RowBegin > (size_t)m_KernelRadius ? RowBegin - m_KernelRadius : 0;
+	size_t bandEnd = min<size_t>(m_Height, RowEnd + m_KernelRadius);
+	cl_uint bandHeight = cl_uint(bandEnd - bandBegin);
+
+	V_RETURN_FALSE_CL(SetArgsFrom(m_DeviceVerticalKernels[Device], 3, bandHeight), "Error setting vertical kernel arguments");
+
+	if(!m_dDeviceSource[Device].Write(CommandQueue, m_hSourceChannels[Channel] + bandBegin * m_Pitch, bandHeight * m_Pitch))
+		return false;
+
+	size_t globalWorkSizeH[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]),
+		CLUtil::GetGlobalWorkSize(bandHeight, m_LocalSizeHorizontal[1])
+	};
+	V_RETURN_FALSE_CL(clEnqueueNDRangeKernel(CommandQueue, m_DeviceHorizontalKernels[Device], 2, NULL, globalWorkSizeH, m_LocalSizeHorizontal, 0, NULL, NULL),
+		"Error executing the horizontal kernel!");
+
+	size_t globalWorkSizeV[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]),
+		CLUtil::GetGlobalWorkSize((bandHeight + m_StepsVertical - 1) / m_StepsVertical, m_LocalSizeVertical[1])
+	};
+	V_RETURN_FALSE_CL(clEnqueueNDRangeKernel(CommandQueue, m_DeviceVerticalKernels[Device], 2, NULL, globalWorkSizeV, m_LocalSizeVertical, 0, NULL, NULL),
+		"Error executing the vertical kernel!");
+
+	//only the rows owned by this device are read back, the halo rows belong to the neighbours
+	if(!m_dDeviceResult[Device].Read(CommandQueue, m_hGPUResultChannels[Channel] + RowBegin * m_Pitch, (RowEnd - RowBegin) * m_Pitch,
+		(RowBegin - bandBegin) * m_Pitch, CL_FALSE))
+		return false;
+
+	return true;
+}
+
+void CConvolutionSeparableTask::ComputeGPUMultiDevice(cl_context Context, const std::vector<cl_command_queue>& CommandQueues, size_t LocalWorkSize[3])
+{
+	size_t numDevices = CommandQueues.size();
+
+	//bands are multiples of the rows a vertical work-group produces
+	size_t granularity = m_LocalSizeVertical[1] * m_StepsVertical;
+	vector<double> throughput = CLUtil::MeasureDeviceThroughput(CommandQueues, m_Height, granularity,
+		[&](size_t Device, size_t Begin, size_t End) { return EnqueueBand(Device, CommandQueues[Device], 0, Begin, End); });
+	if(throughput.empty())
+		return;
+	vector<size_t> rows = CLUtil::PartitionWork(m_Height, throughput, granularity);
+
+	CTimer timer;
+	timer.Start();
+	for(unsigned int iChannel = 0; iChannel < 3; iChannel++)
+	{
+		for(size_t i = 0; i < numDevices; i++)
+		{
+			if(rows[i + 1] > rows[i] && !EnqueueBand(i, CommandQueues[i], iChannel, rows[i], rows[i + 1]))
+				return;
+		}
+	}
+	for(size_t i = 0; i < numDevices; i++)
+		V_RETURN_CL(clFinish(CommandQueues[i]), "Error finishing the queue!");
+	timer.Stop();
+
+	double runTime = timer.GetElapsedMilliseconds();
+	cout<<"  GPU time on "<<numDevices<<" devices (including transfers): "<<runTime<<" ms, throughput: "
+		<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	CBenchmarkReport::Record("multiDevice", runTime, 1, double(m_Width) * m_Height, "Gpixels/s");
+	for(size_t i = 0; i < numDevices; i++)
+		cout<<"    device "<<i<<": rows "<<rows[i]<<" - "<<rows[i + 1]<<endl;
+
+	SaveImage("Images/GPUResultSeparable_" + m_OutFileName + ".pfm", m_hGPUResultChannels);
+}
+
+void CConvolutionSeparableTask::ComputeGPUOverlapped(cl_context Context, cl_command_queue ComputeQueue, cl_command_queue TransferQueue,
+	size_t LocalWorkSize[3])
+{
+	//the kernel times alone, as in ComputeGPU()
+	double runTime = 0.0;
+	CSamplingTimer samples;
+	for(unsigned int iChannel = 0; iChannel < 3; iChannel++)
+		runTime += ConvolutionChannelGPU(iChannel, Context, ComputeQueue, m_Iterations, samples);
+	cout<<"  Average GPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	cout<<"  ";
+	samples.PrintStatistics(cout);
+	cout<<endl;
+	CBenchmarkReport::Record("gpu", samples.GetSamples(), double(m_Width) * m_Height, "Gpixels/s");
+
+	//including the transfers, once serialized on a single queue and once overlapped
+	double serialTime = ConvolutionPipelineGPU(ComputeQueue, ComputeQueue);
+	double overlappedTime = ConvolutionPipelineGPU(ComputeQueue, TransferQueue);
+	cout<<"  GPU time including transfers: "<<serialTime<<" ms serialized, "<<overlappedTime<<" ms overlapped"<<endl;
+	CBenchmarkReport::Record("pipelineSerialized", serialTime, 1, double(m_Width) * m_Height, "Gpixels/s");
+	CBenchmarkReport::Record("pipelineOverlapped", overlappedTime, 1, double(m_Width) * m_Height, "Gpixels/s");
+
+	SaveImage("Images/GPUResultSeparable_" + m_OutFileName + ".pfm", m_hGPUResultChannels);
+}
+
+double CConvolutionSeparableTask::ConvolutionPipelineGPU(cl_command_queue ComputeQueue, cl_command_queue TransferQueue)
+{
+	size_t dataSize = m_Pitch * m_Height * sizeof(cl_float);
+	size_t globalWorkSizeH[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]),
+		CLUtil::GetGlobalWorkSize(m_Height, m_LocalSizeHorizontal[1])
+	};
+	size_t globalWorkSizeV[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]),
+		CLUtil::GetGlobalWorkSize(m_Height / m_StepsVertical, m_LocalSizeVertical[1])
+	};
+
+	CLEvent uploaded[3];
+	CLEvent convolved[3];
+	cl_int clErr = CL_SUCCESS;
+
+	clFinish(ComputeQueue);
+	clFinish(TransferQueue);
+	CTimer timer;
+	timer.Start();
+
+	//all uploads go first, so the transfer queue never waits for a kernel before an upload
+	for(unsigned int iChannel = 0; iChannel < 3; iChannel++)
+		clErr |= clEnqueueWriteBuffer(TransferQueue, m_dSourceChannels[iChannel], CL_FALSE, 0, dataSize,
+			m_hSourceChannels[iChannel], 0, NULL, uploaded[iChannel].Receive());
+	clFlush(TransferQueue);
+
+	for(unsigned int iChannel = 0; iChannel < 3 && clErr == CL_SUCCESS; iChannel++)
+	{
+		//the arguments are captured at enqueue time, so they can be changed for the next channel right away
+		//(the working buffer is shared, which is safe because the compute queue is in order)
+		clErr |= SetArgs(m_HorizontalKernel, m_dGPUWorkingBuffer, m_dSourceChannels[iChannel]);
+		clErr |= SetArgs(m_VerticalKernel, m_dResultChannels[iChannel], m_dGPUWorkingBuffer);
+
+		clErr |= clEnqueueNDRangeKernel(ComputeQueue, m_HorizontalKernel, 2, NULL, globalWorkSizeH, m_LocalSizeHorizontal,
+			1, uploaded[iChannel].GetAddressOf(), NULL);
+		clErr |= clEnqueueNDRangeKernel(ComputeQueue, m_VerticalKernel, 2, NULL, globalWorkSizeV, m_LocalSizeVertical,
+			0, NULL, convolved[iChannel].Receive());
+		clFlush(ComputeQueue);
+
+		//the readback of this channel runs during the kernels of the next one
+		clErr |= clEnqueueReadBuffer(TransferQueue, m_dResultChannels[iChannel], CL_FALSE, 0, dataSize,
+			m_hGPUResultChannels[iChannel], 1, convolved[iChannel].GetAddressOf(), NULL);
+		clFlush(TransferQueue);
+	}
+
+	clErr |= clFinish(ComputeQueue);
+	clErr |= clFinish(TransferQueue);
+	timer.Stop();
+
+	V_RETURN_0_CL(clErr, "Error executing the convolution pipeline!");
+
+	return timer.GetElapsedMilliseconds();
+}
+
 void CConvolutionSeparableTask::ComputeCPU()
 {
 	double runTime = 0.0;
@@ -181,6 +408,7 @@ void CConvolutionSeparableTask::ComputeCPU()
 	}
 
 	cout<<"  CPU time: "<<runTime<<" ms, throughput: "<< 1.0e-6 * m_Width * m_Height / runTime << " Gpixels/s" <<endl;
+	CBenchmarkReport::Record("cpu", runTime, 1, double(m_Width) * m_Height, "Gpixels/s");
 
 	SaveImage("Images/CPUResultSeparable_" + m_OutFileName + ".pfm", m_hCPUResultChannels);
 }
@@ -225,34 +453,58 @@ double CConvolutionSeparableTask::ConvolutionChannelCPU(unsigned int Channel)
 	return timer.GetElapsedMilliseconds();
 }
 
-double CConvolutionSeparableTask::ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations)
+double CConvolutionSeparableTask::ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations,
+	CSamplingTimer& Samples)
 {
 	cl_int clErr;
 
-	clErr  = clSetKernelArg(m_HorizontalKernel, 0, sizeof(cl_mem), (void*)&m_dGPUWorkingBuffer);
-	clErr |= clSetKernelArg(m_HorizontalKernel, 1, sizeof(cl_mem), (void*)&m_dSourceChannels[Channel]);
+	clErr = SetArgs(m_HorizontalKernel, m_dGPUWorkingBuffer, m_dSourceChannels[Channel]);
 	V_RETURN_0_CL(clErr, "Error setting horizontal kernel arguments");
 
-	clErr  = clSetKernelArg(m_VerticalKernel, 0, sizeof(cl_mem), (void*)&m_dResultChannels[Channel]);
-	clErr |= clSetKernelArg(m_VerticalKernel, 1, sizeof(cl_mem), (void*)&m_dGPUWorkingBuffer);
+	clErr = SetArgs(m_VerticalKernel, m_dResultChannels[Channel], m_dGPUWorkingBuffer);
 	V_RETURN_0_CL(clErr, "Error setting vertical kernel arguments");
 
 
 	double runTime;	
+	CSamplingTimer kernelSamples;
 	
 	size_t globalWorkSizeH[2] = {
 		CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]),
 		CLUtil::GetGlobalWorkSize(m_Height, m_LocalSizeHorizontal[1])
 	};	
-	runTime = CLUtil::ProfileKernel(CommandQueue, m_HorizontalKernel, 2, globalWorkSizeH, m_LocalSizeHorizontal, NIterations);
+	runTime = CLUtil::ProfileKernel(CommandQueue, m_HorizontalKernel, 2, globalWorkSizeH, m_LocalSizeHorizontal, NIterations, &kernelSamples);
+	Samples.Accumulate(kernelSamples);
 
 	size_t globalWorkSizeV[2] = {
 		CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]),
 		CLUtil::GetGlobalWorkSize(m_Height / m_StepsVertical, m_LocalSizeVertical[1])
 	};
-	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalKernel, 2, globalWorkSizeV, m_LocalSizeVertical, NIterations);
+	runTime += CLUtil::ProfileKernel(CommandQueue, m_VerticalKernel, 2, globalWorkSizeV, m_LocalSizeVertical, NIterations, &kernelSamples);
+	Samples.Accumulate(kernelSamples);
 	
 	return runTime;
 }
 
+bool CConvolutionSeparableTask::ConvolveImageGPU(cl_command_queue CommandQueue)
+{
+	size_t globalWorkSizeH[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width / m_StepsHorizontal, m_LocalSizeHorizontal[0]),
+		CLUtil::GetGlobalWorkSize(m_Height, m_LocalSizeHorizontal[1])
+	};
+	size_t globalWorkSizeV[2] = {
+		CLUtil::GetGlobalWorkSize(m_Width, m_LocalSizeVertical[0]),
+		CLUtil::GetGlobalWorkSize(m_Height / m_StepsVertical, m_LocalSizeVertical[1])
+	};
+
+	//the arguments are captured at enqueue time, the in-order queue serializes the use of the working buffer
+	cl_int clErr = CL_SUCCESS;
+	for(unsigned int iChannel = 0; iChannel < 3 && clErr == CL_SUCCESS; iChannel++)
+	{
+		clErr |= Launch(CommandQueue, m_HorizontalKernel, 2, globalWorkSizeH, m_LocalSizeHorizontal, m_dGPUWorkingBuffer, m_dSourceChannels[iChannel]);
+		clErr |= Launch(CommandQueue, m_VerticalKernel, 2, globalWorkSizeV, m_LocalSizeVertical, m_dResultChannels[iChannel], m_dGPUWorkingBuffer);
+	}
+	V_RETURN_FALSE_CL(clErr, "Error executing the separable convolution!");
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
@@ -21,11 +21,23 @@
 #define _CCONVOLUTION_SEPARABLE_TASK_H
 
 #include "CConvolutionTaskBase.h"
+#include "../../Common/IMultiDeviceComputeTask.h"
+#include "../../Common/IOverlappedComputeTask.h"
+#include "../../Common/IAsyncBuildComputeTask.h"
 
 #include <string>
+#include <vector>
 
 //! A3 / T2 separable convolution
-class CConvolutionSeparableTask : public CConvolutionTaskBase
+/*!
+	In the multi-device mode the image is split into bands of rows. Each band is extended by
+	KernelRadius rows on both sides (the halo), so the vertical pass of a device only needs its own band.
+
+	On a single device the three channels are pipelined: while the kernels of one channel run,
+	the next channel is uploaded and the previous one is read back on the transfer queue.
+*/
+class CConvolutionSeparableTask : public CConvolutionTaskBase, public IMultiDeviceComputeTask, public IOverlappedComputeTask,
+	public IAsyncBuildComputeTask
 {
 public:
 	CConvolutionSeparableTask(
@@ -52,11 +64,42 @@ public:
 
 	virtual void ComputeCPU();
 
+	// IMultiDeviceComputeTask
+
+	virtual bool InitMultiDeviceResources(cl_context Context, const std::vector<cl_device_id>& Devices);
+
+	virtual void ComputeGPUMultiDevice(cl_context Context, const std::vector<cl_command_queue>& CommandQueues, size_t LocalWorkSize[3]);
+
+	// IOverlappedComputeTask
+
+	virtual void ComputeGPUOverlapped(cl_context Context, cl_command_queue ComputeQueue, cl_command_queue TransferQueue,
+		size_t LocalWorkSize[3]);
+
+	// IAsyncBuildComputeTask
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
 protected:
+	virtual bool ConvolveImageGPU(cl_command_queue CommandQueue);
+	virtual bool ResizeImageResources(cl_context Context);
+
+	//binds the size dependent arguments of the two passes
+	bool SetSizeArgs();
+
+	// uploads, convolves and reads back all channels, the return value is the run time in milliseconds
+	// (if both queues are the same, every step waits for the previous one)
+	double ConvolutionPipelineGPU(cl_command_queue ComputeQueue, cl_command_queue TransferQueue);
+
+	std::string GetCompileOptions() const;
+
+	//enqueues upload, both passes and readback of the rows [RowBegin, RowEnd) of a channel on one device
+	bool EnqueueBand(size_t Device, cl_command_queue CommandQueue, unsigned int Channel, size_t RowBegin, size_t RowEnd);
+
 	// the return value is the run time in milliseconds
 	double ConvolutionChannelCPU(unsigned int Channel);
-	// the return value is the run time in milliseconds
-	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations);
+	// the return value is the average run time in milliseconds, the time of every iteration is added to Samples
+	double ConvolutionChannelGPU(unsigned int Channel, cl_context Context, cl_command_queue CommandQueue, int NIterations,
+		CSamplingTimer& Samples);
 
 	std::string m_OutFileName;
 
@@ -73,19 +116,27 @@ protected:
 	int				m_KernelRadius = 0;
 
 	// device data
-	cl_mem			m_dGPUWorkingBuffer;
+	DeviceBuffer<cl_float>	m_dGPUWorkingBuffer;
 	float*			m_hCPUWorkingBuffer;
 
 	//kernel coefficients
-	cl_mem			m_dKernelHorizontal = nullptr;
-	cl_mem			m_dKernelVertical = nullptr;
+	DeviceBuffer<cl_float>	m_dKernelHorizontal;
+	DeviceBuffer<cl_float>	m_dKernelVertical;
 
-	cl_program		m_Program = nullptr;
+	CLProgram		m_Program;
 	std::string		m_ProgramName;
 	//horizontal convolution pass
-	cl_kernel		m_HorizontalKernel = nullptr;
+	CLKernel		m_HorizontalKernel;
 	//vertical convolution pass
-	cl_kernel		m_VerticalKernel = nullptr;
+	CLKernel		m_VerticalKernel;
+
+	//multi-device mode: kernels and band buffers (sized for the whole image) of each device
+	CLProgram								m_MultiDeviceProgram;
+	std::vector<CLKernel>					m_DeviceHorizontalKernels;
+	std::vector<CLKernel>					m_DeviceVerticalKernels;
+	std::vector<DeviceBuffer<cl_float> >	m_dDeviceSource;
+	std::vector<DeviceBuffer<cl_float> >	m_dDeviceWorking;
+	std::vector<DeviceBuffer<cl_float> >	m_dDeviceResult;
 };
 
 #endif // _CCONVOLUTION_SEPARABLE_TASK_H
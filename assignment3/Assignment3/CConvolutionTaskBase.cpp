@@ -5,28 +5,46 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CConvolutionTaskBase.h"
 
-#include "../Common/CLUtil.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CFileUtil.h"
+#include "../../Common/CBenchmarkReport.h"
+#include "../../Common/CTimer.h"
 
 #include "Pfm.h"
+#include "CImageConversion.h"
+#include "C8BitImage.h"
+#include "CImagePipeline.h"
+#include "CImageComparison.h"
 
 #include <sstream>
 #include <string.h>
 #include <stdio.h>
-#include <assert.h>
-#include <cstdint>
 #include <vector>
-
-
-#include <direct.h>
+#include <algorithm>
+#include <memory>
 
 using namespace std;
 
+// a GPU value matches if it is within this many units in the last place of the CPU value,
+// or closer than the absolute tolerance (values near zero have tiny ULPs);
+// a result is valid if every value matches and the MSE stays below the limit
+#define VALIDATION_MAX_ULP			64
+#define VALIDATION_ABS_TOLERANCE	1e-4f
+#define VALIDATION_MAX_MSE			1e-10
+
 ///////////////////////////////////////////////////////////////////////////////
 // CConvolutionTaskBase
 
 CConvolutionTaskBase::CConvolutionTaskBase(const std::string& FileName, bool Monochrome)
 	: m_FileName(FileName), m_Monochrome(Monochrome)
 {
+	//ReleaseResources() may run before the first InitResources()
+	for(int i = 0; i < 3; i++)
+	{
+		m_hSourceChannels[i] = nullptr;
+		m_hCPUResultChannels[i] = nullptr;
+		m_hGPUResultChannels[i] = nullptr;
+	}
 }
 
 CConvolutionTaskBase::~CConvolutionTaskBase()
@@ -36,75 +54,100 @@ CConvolutionTaskBase::~CConvolutionTaskBase()
 
 bool CConvolutionTaskBase::InitResources(cl_device_id , cl_context Context)
 {
-	char cCurrentPath[FILENAME_MAX];
-	_getcwd(cCurrentPath, sizeof(cCurrentPath));
-
+	//in the batch mode the pipeline has loaded the image already
 	PFM inputPfm;
-	if (!inputPfm.LoadRGB(m_FileName.c_str())) {
-		cerr<<"Error loading file: " << m_FileName.c_str() << "." << endl;
-		return false;
+	const PFM* pInput = m_pInputImage;
+	if(pInput == nullptr)
+	{
+		if (!inputPfm.LoadRGB(m_FileName.c_str())) {
+			cerr<<"Error loading file: " << m_FileName.c_str() << "." << endl;
+			return false;
+		}
+		pInput = &inputPfm;
 	}
 
 	//internally, we convert the bitmap to floats, and execute the same convolution
 	//operation on its three channels separately
-	m_Height = inputPfm.height;
-	m_Width = inputPfm.width;
-	m_Pitch = m_Width;
-	if(m_Width % 32 != 0)
-		m_Pitch = m_Width + 32 - (m_Width % 32); //This will make sure that the data accesses are ALWAYS coalesced
-
-	cout<<"Size of image: "<<m_Width<<" x "<<m_Height<<endl;
+	SetSourceImage(*pInput);
 
-	//allocate data for the float channels
-	for(int i = 0; i < 3; i++)
+	//a batch has images of different sizes, its results keep the size of the configuration
+	if(m_pInputImage == nullptr)
 	{
-		m_hSourceChannels[i] = new float[m_Height * m_Pitch];
-		m_hCPUResultChannels[i] = new float[m_Height * m_Pitch];
-		m_hGPUResultChannels[i] = new float[m_Height * m_Pitch];
+		cout<<"Size of image: "<<m_Width<<" x "<<m_Height<<endl;
+		CBenchmarkReport::SetRunSize(m_Width, m_Height, 1);
 	}
 
-	//extract R, G, B channels
-	unsigned int pixelOffset = 0;
-	unsigned int trippleOffset = 0;
-	for(unsigned int y = 0; y < m_Height; y++)
+	return CreateImageBuffers(Context);
+}
+
+void CConvolutionTaskBase::SetSourceImage(const PFM& Image)
+{
+	unsigned int width = Image.width;
+	unsigned int height = Image.height;
+	if(m_hSourceChannels[0] == nullptr || width != m_Width || height != m_Height)
 	{
-		for(unsigned int x = 0; x < m_Width; x++)
+		m_Height = height;
+		m_Width = width;
+		m_Pitch = m_Width;
+		if(m_Width % 32 != 0)
+			m_Pitch = m_Width + 32 - (m_Width % 32); //This will make sure that the data accesses are ALWAYS coalesced
+
+		//allocate data for the float channels
+		for(int i = 0; i < 3; i++)
 		{
-			m_hSourceChannels[0][pixelOffset] = inputPfm.pImg[trippleOffset    ];
-			m_hSourceChannels[1][pixelOffset] = inputPfm.pImg[trippleOffset + 1];
-			m_hSourceChannels[2][pixelOffset] = inputPfm.pImg[trippleOffset + 2];
-
-			//monochrome: the data is converted to grayscale
-			if(m_Monochrome)
-				RGBToGrayScale(	m_hSourceChannels[0][pixelOffset],
-								m_hSourceChannels[1][pixelOffset],
-								m_hSourceChannels[2][pixelOffset]);
-
-			pixelOffset++;
-			trippleOffset += 3;
+			SAFE_DELETE_ARRAY( m_hSourceChannels[i] );
+			SAFE_DELETE_ARRAY( m_hCPUResultChannels[i] );
+			SAFE_DELETE_ARRAY( m_hGPUResultChannels[i] );
+			m_hSourceChannels[i] = new float[m_Height * m_Pitch];
+			m_hCPUResultChannels[i] = new float[m_Height * m_Pitch];
+			m_hGPUResultChannels[i] = new float[m_Height * m_Pitch];
 		}
-		//pad the image with zeros
-		for(unsigned int i = 0; i < m_Pitch - m_Width; i++)
+
+		//monochrome: only the first channel is used, the others stay zero
+		if(m_Monochrome)
 		{
-			m_hSourceChannels[0][pixelOffset + i] = 0.0f;
-			m_hSourceChannels[1][pixelOffset + i] = 0.0f;
-			m_hSourceChannels[2][pixelOffset + i] = 0.0f;
+			memset(m_hSourceChannels[1], 0, m_Height * m_Pitch * sizeof(float));
+			memset(m_hSourceChannels[2], 0, m_Height * m_Pitch * sizeof(float));
 		}
-		pixelOffset += m_Pitch - m_Width;
 	}
 
-	unsigned int dataSize = m_Pitch * m_Height * sizeof(cl_float);
-	
-	cl_int clError;
+	//extract R, G, B channels (straight from the mapped file, see PFM) and pad the rows with zeros
+	vector<const float*> rows(m_Height);
+	for(unsigned int y = 0; y < m_Height; y++)
+		rows[y] = Image.GetRow(y);
+
+	if(m_Monochrome)
+		CImageConversion::DeinterleaveGrayscale(rows.data(), m_Width, m_Height, m_Pitch, m_hSourceChannels[0]);
+	else
+		CImageConversion::Deinterleave(rows.data(), m_Width, m_Height, m_Pitch, m_hSourceChannels);
+}
+
+bool CConvolutionTaskBase::CreateImageBuffers(cl_context Context)
+{
 	for(int i = 0; i < 3; i++)
 	{
-		m_dSourceChannels[i] = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, dataSize, m_hSourceChannels[i], &clError);
-		V_RETURN_FALSE_CL(clError, "Error allocating device input array");
-
-		m_dResultChannels[i] = clCreateBuffer(Context, CL_MEM_WRITE_ONLY, dataSize, NULL, &clError);
-		V_RETURN_FALSE_CL(clError, "Error allocating device output array");
+		if(!m_dSourceChannels[i].Create(Context, CL_MEM_READ_ONLY, m_Pitch * m_Height, m_hSourceChannels[i]))
+			return false;
+		if(!m_dResultChannels[i].Create(Context, CL_MEM_WRITE_ONLY, m_Pitch * m_Height))
+			return false;
 	}
+	return true;
+}
 
+bool CConvolutionTaskBase::ResizeImageResources(cl_context Context)
+{
+	return CreateImageBuffers(Context);
+}
+
+bool CConvolutionTaskBase::UploadSourceImage(cl_command_queue CommandQueue)
+{
+	//the unused channels of a monochrome image are zero on the device already
+	unsigned int numChannels = m_Monochrome ? 1 : 3;
+	for(unsigned int i = 0; i < numChannels; i++)
+	{
+		if(!m_dSourceChannels[i].Write(CommandQueue, m_hSourceChannels[i], m_Pitch * m_Height))
+			return false;
+	}
 	return true;
 }
 
@@ -116,8 +159,8 @@ void CConvolutionTaskBase::ReleaseResources()
 		SAFE_DELETE_ARRAY( m_hCPUResultChannels[i] );
 		SAFE_DELETE_ARRAY( m_hGPUResultChannels[i] );
 
-		SAFE_RELEASE_MEMOBJECT( m_dSourceChannels[i] );
-		SAFE_RELEASE_MEMOBJECT( m_dResultChannels[i] );
+		m_dSourceChannels[i].Release();
+		m_dResultChannels[i].Release();
 	}
 }
 
@@ -126,148 +169,184 @@ bool CConvolutionTaskBase::ValidateResults()
 	//number of channels to compute
 	unsigned int numChannels = m_Monochrome ? 1 : 3;
 
-	//calculate the average squared difference
-	float avgError = 0;
-	float maxError = 0;
-	float numValues = float(numChannels * m_Width * (m_Height - 1));
-	float scaling = 1.0f / numValues;
+	//the squared errors only go to memory if the difference image is saved
+	vector<float> difference;
+	float* differenceChannels[3] = { nullptr, nullptr, nullptr };
+	if(m_SaveDifferenceImage)
+	{
+		difference.assign(size_t(numChannels) * m_Pitch * m_Height, 0.0f);
+		for(unsigned int i = 0; i < 3; i++)
+			differenceChannels[i] = &difference[size_t(i % numChannels) * m_Pitch * m_Height];
+	}
 
-	for(unsigned int y = 0; y < m_Height; y++)
-		for(unsigned int x = 0; x < m_Width; x++)
-			for(unsigned int i = 0; i < numChannels; i++)
-			{
-				float L2Error = m_hCPUResultChannels[i][y * m_Pitch + x] - m_hGPUResultChannels[i][y * m_Pitch + x];
-				L2Error = L2Error * L2Error;
-
-				// Ignore the last line for the difference computations because we seem to have issues with NANs and other incorrect values in the last line with
-				// the current driver version (versions 344.75, 344.11 and 335.23) in the separable kernel exercise.
-				// This should be removed ASAP if the driver works again. You will also have to change the numValues initialization above.
-				if (y < m_Height - 1)
-				{
-					maxError = max(maxError, L2Error);
-					avgError += L2Error * scaling;
-				}
-
-				//to see the difference...
-				m_hCPUResultChannels[i][y * m_Pitch + x] = L2Error;
-			}
-	cout<<"Mean sq. error (MSE): "<<avgError<<endl;
-	cout<<"Maximum sq. error: "<<maxError<<endl;
+	CTimer timer;
+	timer.Start();
+	SImageDifference diff = CImageComparison::Compare(m_hCPUResultChannels, m_hGPUResultChannels, numChannels,
+		m_Width, m_Height, m_Pitch, VALIDATION_MAX_ULP, VALIDATION_ABS_TOLERANCE, m_SaveDifferenceImage ? differenceChannels : nullptr);
+	timer.Stop();
+
+	cout<<"Mean sq. error (MSE): "<<diff.MSE<<", PSNR: "<<diff.PSNR<<" dB"<<endl;
+	cout<<"Maximum abs. error: "<<diff.MaxAbsError<<", maximum ULP difference: "<<diff.MaxULP<<endl;
+	cout<<"Mismatches: "<<diff.Mismatches<<" of "<<diff.NumValues<<" values (validated in "<<timer.GetElapsedMilliseconds()<<" ms)"<<endl;
 
 	//save difference image
-	std::stringstream strm;
-	strm<<"Images/DifferenceImage"<<m_FileNamePostfix<<".pfm";
-	SaveImage(strm.str().c_str(), m_hCPUResultChannels);
+	if(m_SaveDifferenceImage)
+	{
+		std::stringstream strm;
+		strm<<"Images/DifferenceImage"<<m_FileNamePostfix<<".pfm";
+		SaveImage(strm.str().c_str(), differenceChannels);
+	}
 
-	return (avgError < 1e-10f && maxError < 1e-8);
+	return (diff.Mismatches == 0 && diff.MSE < VALIDATION_MAX_MSE);
 }
 
-#ifdef HAVE_BIG_ENDIAN
-# define SWAP_32(D) \
-#	((D << 24) | ((D << 8) & 0x00FF0000)  \
-#	 | ((D >> 8) & 0x0000FF00) | (D >> 24))
-# define SWAP_16(D) ((D >> 8) | (D << 8))
-#else
-# define SWAP_32(D) (D)
-# define SWAP_16(D) (D)
-#endif
-
-void
-save_image_bmp(const char *path, unsigned char *data, int width, int height)
+bool CConvolutionTaskBase::ComputeBatch(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue,
+	const std::string& Directory, size_t [3], bool& Valid)
 {
-	FILE *f;
+	Valid = false;
+	vector<string> files;
+	string outputDirectory;
+	if(!CImagePipeline::PrepareBatch(Directory, files, outputDirectory))
+		return false;
 
-	if(!(f = fopen(path, "wb"))) {
-		cerr << "Could not open \"" << path << "\"" << endl;
-		return;
-	}
-	int numPixels = width * height;
-
-	unsigned char header[] = {
-		0x42, 0x4D, 0, 0, 0, 0, 0, 0,
-		0, 0, 0x36, 0, 0, 0, 0x28, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		1, 0, 0x18, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0
-	};
-
-	int32_t width_end  = SWAP_32(width);
-	int32_t height_end = SWAP_32(height);
-	int32_t num_pix = numPixels * 3;
-	int32_t wtf = 54 + numPixels * 3 + (height) * ((width & 3));
-
-	memcpy(header + 18, &width_end,  sizeof(width_end));
-	memcpy(header + 22, &height_end, sizeof(height_end));
-	memcpy(header + 34, &num_pix,    sizeof(num_pix));
-	memcpy(header +  2, &wtf,        sizeof(wtf));
-
-	size_t w;
-	w = fwrite(header, 54, 1, f);
-	assert(w == 1);
-	for(int y = height - 1; y >= 0; y--) {
-		for(int x = 0; x < width; x++) {
-			unsigned char* imgPos = data + 3 * (x + y * width);
-			for(int i = 2; i >= 0; i--) { // reverse for BGR
-				unsigned char c = *(imgPos + i);
-				w = fwrite(&c, 1, 1, f);
-				assert(w == 1);
-			}
+	unsigned int numChannels = m_Monochrome ? 1 : 3;
+	double numPixels = 0.0;
+	bool initialized = false;
+
+	CImagePipeline pipeline;
+	bool success = pipeline.Run(files, [&](CImagePipeline::SItem& Item) -> bool {
+		const PFM& image = *Item.Image;
+		if(!initialized)
+		{
+			//the first image creates everything, the program, kernels and buffers stay for the whole batch
+			m_pInputImage = &image;
+			initialized = InitResources(Device, Context);
+			m_pInputImage = nullptr;
+			if(!initialized)
+				return false;
 		}
-		char temp = 0;
-		for(int i = 0; i < (width) % 4; i++) {
-			w = fwrite(&temp, 1, 1, f); // padding
-			assert(w == 1);
+		else if(unsigned(image.width) != m_Width || unsigned(image.height) != m_Height)
+		{
+			//another size: only the image buffers are reallocated (with the new pixels)
+			SetSourceImage(image);
+			if(!ResizeImageResources(Context))
+				return false;
+		}
+		else
+		{
+			//the same size: only the pixels are uploaded
+			SetSourceImage(image);
+			if(!UploadSourceImage(CommandQueue))
+				return false;
 		}
+
+		if(!ConvolveImageGPU(CommandQueue))
+			return false;
+
+		//the results are read straight into the memory the writer thread saves
+		size_t planeSize = size_t(m_Pitch) * m_Height;
+		shared_ptr<vector<float> > result = make_shared<vector<float> >(numChannels * planeSize);
+		for(unsigned int i = 0; i < numChannels; i++)
+		{
+			if(!m_dResultChannels[i].Read(CommandQueue, &(*result)[i * planeSize], planeSize, 0, CL_FALSE))
+				return false;
+		}
+		//this also waits for the upload, the next image overwrites the source planes
+		V_RETURN_FALSE_CL(clFinish(CommandQueue), "Error reading back results from the device!");
+		numPixels += double(m_Width) * m_Height;
+
+		//e.g. <Directory>/results/frame01_3x3.pfm
+		string fileName = CFileUtil::JoinPath(outputDirectory, CFileUtil::GetStem(Item.InputFile) + "_" + m_FileNamePostfix + ".pfm");
+		bool monochrome = m_Monochrome;
+		unsigned int width = m_Width, height = m_Height, pitch = m_Pitch;
+		string previewFormat = m_PreviewFormat;
+		Item.Writes.push_back([=]() {
+			const float* first = &(*result)[0];
+			const float* channels[3] = { first, first + (monochrome ? 0 : planeSize), first + (monochrome ? 0 : 2 * planeSize) };
+			return WriteImage(fileName, channels, monochrome, width, height, pitch, previewFormat);
+		});
+		return true;
+	}, [&](CImagePipeline::SItem& ) -> bool {
+		//the source planes still hold the image and m_dResultChannels its result
+		ComputeCPU();
+		size_t planeSize = size_t(m_Pitch) * m_Height;
+		for(unsigned int i = 0; i < numChannels; i++)
+		{
+			if(!m_dResultChannels[i].Read(CommandQueue, m_hGPUResultChannels[i], planeSize))
+				return false;
+		}
+		return ValidateResults();
+	});
+	ReleaseResources();
+	Valid = pipeline.IsValid();
+
+	if(pipeline.GetNumProcessed() > 0)
+	{
+		double imageTime = pipeline.GetWallMilliseconds() / pipeline.GetNumProcessed();
+		cout<<"  Average time per image: "<<imageTime<<" ms, throughput: "<<1.0e-6 * numPixels / pipeline.GetWallMilliseconds()<<" Gpixels/s"<<endl;
+		CBenchmarkReport::Record("batch", imageTime, unsigned(pipeline.GetNumProcessed()), numPixels / pipeline.GetNumProcessed(), "Gpixels/s");
 	}
-	fclose(f);
+	return success;
+}
+
+bool CConvolutionTaskBase::ConvolveImageGPU(cl_command_queue )
+{
+	cerr<<"Error: this task has no batch mode."<<endl;
+	return false;
 }
 
 void CConvolutionTaskBase::SaveImage(const std::string& FileName, float* Channels[3])
+{
+	WriteImage(FileName, Channels, m_Monochrome, m_Width, m_Height, m_Pitch, m_PreviewFormat);
+}
+
+bool CConvolutionTaskBase::WriteImage(const std::string& FileName, const float* const Channels[3], bool Monochrome,
+	unsigned int Width, unsigned int Height, unsigned int Pitch, const std::string& PreviewFormat)
 {
 	// Save the result back to the disk
 	PFM resPfm;
-	resPfm.pImg = new float[m_Width * m_Height * 3];
-	unsigned int pfmOffset = 0;
-	unsigned int pixOffset = 0;
-	for(unsigned int y = 0; y < m_Height; y++)
-	{
-		for(unsigned int x = 0; x < m_Width; x++)
-		{
-			if(m_Monochrome)
-			{
-				resPfm.pImg[pfmOffset] = Channels[0][pixOffset];
-				resPfm.pImg[pfmOffset + 1] = Channels[0][pixOffset];
-				resPfm.pImg[pfmOffset + 2] = Channels[0][pixOffset];
-			}
-			else
-			{
-				resPfm.pImg[pfmOffset] = Channels[0][pixOffset];
-				resPfm.pImg[pfmOffset + 1] = Channels[1][pixOffset];
-				resPfm.pImg[pfmOffset + 2] = Channels[2][pixOffset];
-			}
-			pfmOffset += 3;
-			pixOffset++;
-		}
-		pixOffset += m_Pitch - m_Width;
-	}
-	resPfm.width = m_Width;
-	resPfm.height = m_Height;
-	if(!resPfm.SaveRGB(FileName.c_str()))
+	resPfm.pImg = new float[Width * Height * 3];
+	resPfm.width = Width;
+	resPfm.height = Height;
+	resPfm.channels = 3;
+	vector<float*> rows(Height);
+	for(unsigned int y = 0; y < Height; y++)
+		rows[y] = resPfm.GetRow(y);
+
+	//monochrome: the single channel is written as gray RGB
+	const float* channels[3] = { Channels[0], Channels[Monochrome ? 0 : 1], Channels[Monochrome ? 0 : 2] };
+	CImageConversion::Interleave(channels, Width, Height, Pitch, rows.data());
+	bool success = resPfm.SaveRGB(FileName.c_str());
+	if(!success)
 	{
 		cerr<<"Error saving "<<FileName<<"."<<endl;
 	}
 
-	// stupid to do it here...
-	//
-	
-	vector<uint8_t> img(m_Width * m_Height * 3);
-	for(size_t i = 0; i < img.size(); i++) {
-		img[i] = std::min<int>(0xff, std::max<int>(0, int(resPfm.pImg[i] * 0xff)));
+	// 8 bit preview next to the PFM, e.g. Images/GPUResult3x3.bmp
+	if(!PreviewFormat.empty())
+	{
+		string previewPath = FileName.substr(0, FileName.rfind('.')) + "." + PreviewFormat;
+		C8BitImage preview(C8BitImage::GetFormat(previewPath), Width, Height);
+		vector<unsigned char*> previewRows(Height);
+		for(unsigned int y = 0; y < Height; y++)
+			previewRows[y] = preview.GetRow(y);
+
+		const float* previewChannels[3] = { channels[0], channels[1], channels[2] };
+		if(preview.IsBGR())
+			swap(previewChannels[0], previewChannels[2]);
+
+		//a grayscale preview of a color result shows its luminance, not only the red channel
+		vector<float> gray;
+		if(preview.GetChannels() == 1 && !Monochrome)
+		{
+			gray.resize(size_t(Pitch) * Height);
+			CImageConversion::PlanesToGrayscale(channels, Width, Height, Pitch, gray.data());
+			previewChannels[0] = gray.data();
+		}
+		CImageConversion::Quantize(previewChannels, preview.GetChannels(), Width, Height, Pitch, previewRows.data());
+		success &= preview.Save(previewPath);
 	}
-	string bmp_path = FileName;
-	bmp_path.replace(bmp_path.rfind(".pfm"), 4, ".bmp");
-	//save_image_bmp(bmp_path.c_str(), img.data(), m_Width, m_Height);
+	return success;
 }
 
 void CConvolutionTaskBase::SaveIntImage(const std::string& FileName, int* Channel)
@@ -275,20 +354,20 @@ void CConvolutionTaskBase::SaveIntImage(const std::string& FileName, int* Channe
 	// Write data to the disc
 	PFM resPfm;
 	resPfm.pImg = new float[m_Width * m_Height];
-	unsigned int pfmOffset = 0;
+	resPfm.width = m_Width;
+	resPfm.height = m_Height;
+	resPfm.channels = 1;
 	unsigned int pixOffset = 0;
 	for(unsigned int y = 0; y < m_Height; y++)
 	{
+		float* row = resPfm.GetRow(y);
 		for(unsigned int x = 0; x < m_Width; x++)
 		{
-			resPfm.pImg[pfmOffset]		= (float)Channel[pixOffset];
-			pfmOffset++;
+			row[x]		= (float)Channel[pixOffset];
 			pixOffset++;
 		}
 		pixOffset += m_Pitch - m_Width;
 	}
-	resPfm.width = m_Width;
-	resPfm.height = m_Height;
 	if(!resPfm.SaveGrayscale(FileName.c_str()))
 	{
 		cout<<"Error saving "<<FileName<<"."<<endl;
@@ -296,11 +375,6 @@ void CConvolutionTaskBase::SaveIntImage(const std::string& FileName, int* Channe
 	}
 }
 
-float CConvolutionTaskBase::RGBToGrayScale(float R, float G, float B)
-{
-	return 0.3f * R + 0.59f * G + 0.11f * B;
-}
-
 unsigned int CConvolutionTaskBase::To8BitChannel(float Value)
 {
 	Value = Value * 255.0f;
@@ -20,22 +20,43 @@
 #ifndef _CCONVOLUTION_TASK_BASE_H
 #define _CCONVOLUTION_TASK_BASE_H
 
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/IBatchComputeTask.h"
+#include "../../Common/CLHandles.h"
 
 #include <string>
 
 //! Abstract base class for all convolution tasks
 /*!
 	This class does not handle any actual computation, but implements methods used by all
-	tasks such as loading and saving images and comparing GPU-CPU results.
+	tasks such as loading and saving images and comparing GPU-CPU results (see CImageComparison).
+
+	Given a directory of PFM images as input, ComputeBatch() convolves all of them on the
+	device (see CImagePipeline) and saves the results to the subdirectory "results". The
+	first image and every image after a change of the size are validated.
 */
-class CConvolutionTaskBase : public IComputeTask
+class PFM;
+class CSamplingTimer;
+
+class CConvolutionTaskBase : public IComputeTask, public IBatchComputeTask
 {
 public:
 	CConvolutionTaskBase(const std::string& FileName, bool Monochrome = false);
 
 	virtual ~CConvolutionTaskBase();
 
+	//! Number of timed runs of the GPU kernels
+	void SetIterations(unsigned int Iterations) { m_Iterations = Iterations; }
+
+	//! Saves an 8 bit preview ("bmp", "ppm" or "pgm") with every result image, empty for none
+	/*!
+		PGM previews of color results contain the luminance, those of monochrome tasks their single channel.
+	*/
+	void SetPreviewFormat(const std::string& Format) { m_PreviewFormat = Format; }
+
+	//! Saves the squared errors of the validation to Images/DifferenceImage<postfix>.pfm
+	void SetSaveDifferenceImage(bool Save) { m_SaveDifferenceImage = Save; }
+
 	// IComputeTask
 
 	virtual bool InitResources(cl_device_id Device, cl_context Context);
@@ -44,19 +65,54 @@ public:
 
 	virtual bool ValidateResults();
 
+	// IBatchComputeTask
+
+	virtual bool ComputeBatch(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue,
+		const std::string& Directory, size_t LocalWorkSize[3], bool& Valid);
+
 protected:
 
+	//! Enqueues one convolution of the used channels from m_dSourceChannels to m_dResultChannels
+	/*!
+		This is all the batch mode needs from a task, tasks without a batch mode keep the
+		default, which fails.
+	*/
+	virtual bool ConvolveImageGPU(cl_command_queue CommandQueue);
+
+	//! Converts Image into m_hSourceChannels, the host planes are only reallocated if the size changed
+	void SetSourceImage(const PFM& Image);
+
+	//! Creates m_dSourceChannels (with the source planes) and m_dResultChannels for the current size
+	bool CreateImageBuffers(cl_context Context);
+
+	//! The batch mode calls this instead of InitResources() if the size of the image changed
+	/*!
+		Tasks with further size dependent resources (buffers, kernel arguments) extend it,
+		everything else is kept.
+	*/
+	virtual bool ResizeImageResources(cl_context Context);
+
+	//! Copies the source planes into the existing device buffers (non-blocking)
+	bool UploadSourceImage(cl_command_queue CommandQueue);
+
 	void SaveImage(const std::string& FileName, float* Channels[3]);
 	void SaveIntImage(const std::string& FileName, int* Channel);
 
+	//! Saves planes of Height rows of Pitch floats as an RGB PFM (a monochrome plane as gray RGB)
+	/*!
+		With a PreviewFormat an 8 bit copy is saved next to it, e.g. Images/GPUResult3x3.bmp.
+	*/
+	static bool WriteImage(const std::string& FileName, const float* const Channels[3], bool Monochrome,
+		unsigned int Width, unsigned int Height, unsigned int Pitch, const std::string& PreviewFormat);
+
 	// helper functions:
 	
-	// one grayscale floating point value out of RGB
-	float RGBToGrayScale(float R, float G, float B);
 	// quantize a floating point to a, 8 bit fixed point
 	unsigned int To8BitChannel(float Value);
 
 	std::string		m_FileName;
+	//the current image of the batch mode, InitResources() loads m_FileName if this is nullptr
+	const PFM*		m_pInputImage = nullptr;
 	//if true, only one channel is used
 	bool			m_Monochrome;
 
@@ -64,6 +120,12 @@ protected:
 	// uniquely
 	std::string		m_FileNamePostfix;
 
+	unsigned int	m_Iterations = 100;
+
+	std::string		m_PreviewFormat;
+
+	bool			m_SaveDifferenceImage = false;
+
 	unsigned int	m_Height = 0;
 	unsigned int	m_Width  = 0;
 	unsigned int	m_Pitch  = 0;
@@ -73,8 +135,8 @@ protected:
 	float*			m_hGPUResultChannels[3] /*= { nullptr, nullptr, nullptr }*/; //the convolved image
 
 	//we process exactly one channel on the GPU in the same time
-	cl_mem			m_dSourceChannels[3] /*= { nullptr, nullptr, nullptr}*/;
-	cl_mem			m_dResultChannels[3] /*= { nullptr, nullptr, nullptr}*/;
+	DeviceBuffer<cl_float>	m_dSourceChannels[3];
+	DeviceBuffer<cl_float>	m_dResultChannels[3];
 
 };
 
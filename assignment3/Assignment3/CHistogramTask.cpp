@@ -1,16 +1,38 @@
 #include "CHistogramTask.h"
-#include "../Common/CLUtil.h"
-#include "../Common/CTimer.h"
+#include "../../Common/CLUtil.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CBenchmarkReport.h"
+#include "../../Common/CFileUtil.h"
 #include "Pfm.h"
+#include "CImageConversion.h"
+#include "CImagePipeline.h"
 #include <string.h>
 #include <cassert>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HISTOGRAM_USE_SSE2
+#endif
+
+#define PROGRAM_FILE "histogram.cl"
+
+// Each CPU thread spreads its counts over several interleaved sub-histograms.
+// Neighbouring pixels tend to hit the same bin, and incrementing one counter
+// back to back stalls on store-to-load forwarding.
+enum { NUM_SUB_HISTS = 4 };
 
 CHistogramTask::
-CHistogramTask(float min_val, float max_val, bool use_local_memory, const std::string &img_path)
+CHistogramTask(float min_val, float max_val, bool use_local_memory, const std::string &img_path,
+		unsigned int num_iterations)
 	: m_min_val(min_val)
 	, m_max_val(max_val)
 	, m_img_path(img_path)
 	, m_use_local_memory(use_local_memory)
+	, m_num_iterations(num_iterations)
 {
 }
 
@@ -24,65 +46,50 @@ bool CHistogramTask::
 InitResources(cl_device_id dev, cl_context ctx)
 {
 	cl_int err;
+	// in the batch mode the pipeline has loaded the image already
 	PFM img;
-	if(!img.LoadRGB(m_img_path.c_str())) {
-		std::cerr << "Error loading image: \"" << m_img_path << "\"!" << std::endl;
-		return false;
-	}
-
-	m_img_width  = img.width;
-	m_img_height = img.height;
-	m_img_stride = img.width % 32 ? (img.width + 32 - img.width % 32) : img.width;
-	m_pixels.resize(m_img_stride * m_img_height, 0.0f);
-	for(int y = 0; y < m_img_height; y++) {
-		for(int x = 0; x < m_img_width; x++) {
-			auto &s = m_pixels[y * m_img_stride + x];
-			s = 0.0f;
-		   	s += img.pImg[(y * img.width + x) * 3 + 0] * 0.3f;
-		   	s += img.pImg[(y * img.width + x) * 3 + 1] * 0.59f;
-		   	s += img.pImg[(y * img.width + x) * 3 + 2] * 0.11f;
+	const PFM *input = m_input_image;
+	if(!input) {
+		if(!img.LoadRGB(m_img_path.c_str())) {
+			std::cerr << "Error loading image: \"" << m_img_path << "\"!" << std::endl;
+			return false;
 		}
+		input = &img;
 	}
-	m_d_pixels = clCreateBuffer(ctx,
-			CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-			sizeof(float) * m_pixels.size(),
-			m_pixels.data(),
-			&err);
-	V_RETURN_FALSE_CL(err, "Failed to allocate device memory");
+
+	set_image(*input);
+	// a batch has images of different sizes, its results keep the size of the configuration
+	if(!m_input_image)
+		CBenchmarkReport::SetRunSize(m_img_width, m_img_height, 1);
+	if(!m_d_pixels.Create(ctx, CL_MEM_READ_ONLY, m_pixels.size(), m_pixels.data()))
+		return false;
 
 	std::vector<int> zeroes(NUM_HIST_BINS, 0);
-	m_d_hist = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, NUM_HIST_BINS * sizeof(int),
-			zeroes.data(), &err);
-	V_RETURN_FALSE_CL(err, "Failed to allocate device memory");
+	if(!m_d_hist.Create(ctx, CL_MEM_READ_WRITE, NUM_HIST_BINS, zeroes.data()))
+		return false;
 
 
 	std::string src;
-	if(!CLUtil::LoadProgramSourceToMemory("../Assignment3/histogram.cl", src))
+	if(!CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, src))
 		return false;
 
-	m_program = CLUtil::BuildCLProgramFromMemory(dev, ctx, src);
+	m_program.Reset(CLUtil::BuildCachedCLProgram(dev, ctx, src));
 	if(!m_program)
 		return false;
 
 
 	int num_hist_bins = NUM_HIST_BINS;
 
-	m_kernel_histogram = clCreateKernel(
+	m_kernel_histogram.Reset(clCreateKernel(
 			m_program,
 			m_use_local_memory ? "compute_histogram_local_memory" : "compute_histogram",
-			&err);
+			&err));
 	V_RETURN_FALSE_CL(err, "Failed to create kernel: histogram");
 
-	err = clSetKernelArg(m_kernel_histogram, 0, sizeof(cl_mem), &m_d_hist);
+	err = clSetKernelArg(m_kernel_histogram, 0, sizeof(cl_mem), m_d_hist.GetAddressOf());
 	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 0");
-	err = clSetKernelArg(m_kernel_histogram, 1, sizeof(cl_mem), &m_d_pixels);
-	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 1");
-	err = clSetKernelArg(m_kernel_histogram, 2, sizeof(int), &m_img_width);
-	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 2");
-	err = clSetKernelArg(m_kernel_histogram, 3, sizeof(int), &m_img_height);
-	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 3");
-	err = clSetKernelArg(m_kernel_histogram, 4, sizeof(int), &m_img_stride);
-	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 4");
+	if(!set_image_args())
+		return false;
 	err = clSetKernelArg(m_kernel_histogram, 5, sizeof(int), &num_hist_bins);
 	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 5");
 	if(m_use_local_memory) {
@@ -90,9 +97,9 @@ InitResources(cl_device_id dev, cl_context ctx)
 		V_RETURN_FALSE_CL(err, "Error setting kernel Arg 6");
 	}
 
-	m_kernel_set_to_val = clCreateKernel(m_program, "set_array_to_constant", &err);
+	m_kernel_set_to_val.Reset(clCreateKernel(m_program, "set_array_to_constant", &err));
 	V_RETURN_FALSE_CL(err, "Failed to create kernel: set_array_to_constant");
-	err = clSetKernelArg(m_kernel_set_to_val, 0, sizeof(cl_mem), &m_d_hist);
+	err = clSetKernelArg(m_kernel_set_to_val, 0, sizeof(cl_mem), m_d_hist.GetAddressOf());
 	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 0");
 	err = clSetKernelArg(m_kernel_set_to_val, 1, sizeof(int), &num_hist_bins);
 	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 1");
@@ -103,13 +110,107 @@ InitResources(cl_device_id dev, cl_context ctx)
 	return true;
 }
 
+void CHistogramTask::
+set_image(const PFM &img)
+{
+	m_img_width  = img.width;
+	m_img_height = img.height;
+	m_img_stride = img.width % 32 ? (img.width + 32 - img.width % 32) : img.width;
+	m_pixels.resize(m_img_stride * m_img_height);
+	std::vector<const float *> rows(m_img_height);
+	for(int y = 0; y < m_img_height; y++)
+		rows[y] = img.GetRow(y);
+	CImageConversion::DeinterleaveGrayscale(rows.data(), m_img_width, m_img_height, m_img_stride, m_pixels.data());
+}
+
+bool CHistogramTask::
+set_image_args()
+{
+	cl_int err;
+	err = clSetKernelArg(m_kernel_histogram, 1, sizeof(cl_mem), m_d_pixels.GetAddressOf());
+	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 1");
+	err = clSetKernelArg(m_kernel_histogram, 2, sizeof(int), &m_img_width);
+	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 2");
+	err = clSetKernelArg(m_kernel_histogram, 3, sizeof(int), &m_img_height);
+	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 3");
+	err = clSetKernelArg(m_kernel_histogram, 4, sizeof(int), &m_img_stride);
+	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 4");
+	return true;
+}
+
 void CHistogramTask::
 ReleaseResources()
 {
-	 SAFE_RELEASE_MEMOBJECT(m_d_pixels);
-	 SAFE_RELEASE_MEMOBJECT(m_d_hist);
-	 SAFE_RELEASE_KERNEL(m_kernel_histogram);
-	 SAFE_RELEASE_KERNEL(m_kernel_set_to_val);
+	 m_d_pixels.Release();
+	 m_d_hist.Release();
+	 m_kernel_histogram.Reset();
+	 m_kernel_set_to_val.Reset();
+	 m_program.Reset();
+
+	 m_md_kernels_histogram.clear();
+	 m_md_kernels_set_to_val.clear();
+	 m_md_d_pixels.clear();
+	 m_md_d_hist.clear();
+	 m_md_program.Reset();
+}
+
+void CHistogramTask::
+StartProgramBuilds(cl_device_id dev, cl_context ctx)
+{
+	std::string src;
+	if(CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, src))
+		CLUtil::BuildCachedCLProgramAsync(dev, ctx, src);
+}
+
+bool CHistogramTask::
+InitMultiDeviceResources(cl_context ctx, const std::vector<cl_device_id> &devices)
+{
+	std::string src;
+	if(!CLUtil::LoadProgramSourceToMemory(PROGRAM_FILE, src))
+		return false;
+	m_md_program.Reset(CLUtil::BuildCLProgramForDevices(devices, ctx, src));
+	if(!m_md_program)
+		return false;
+
+	cl_int err;
+	size_t n = devices.size();
+	m_md_kernels_histogram.resize(n);
+	m_md_kernels_set_to_val.resize(n);
+	m_md_d_pixels.resize(n);
+	m_md_d_hist.resize(n);
+	m_md_histograms.assign(n, std::vector<int>(NUM_HIST_BINS, 0));
+
+	int num_hist_bins = NUM_HIST_BINS;
+	int zero = 0;
+	for(size_t i = 0; i < n; i++) {
+		// a band can grow up to the whole image, depending on the measured throughput
+		if(!m_md_d_pixels[i].Create(ctx, CL_MEM_READ_ONLY, m_pixels.size()) ||
+				!m_md_d_hist[i].Create(ctx, CL_MEM_READ_WRITE, NUM_HIST_BINS))
+			return false;
+
+		cl_kernel k = clCreateKernel(m_md_program,
+				m_use_local_memory ? "compute_histogram_local_memory" : "compute_histogram", &err);
+		V_RETURN_FALSE_CL(err, "Failed to create kernel: histogram");
+		m_md_kernels_histogram[i].Reset(k);
+		err  = clSetKernelArg(k, 0, sizeof(cl_mem), m_md_d_hist[i].GetAddressOf());
+		err |= clSetKernelArg(k, 1, sizeof(cl_mem), m_md_d_pixels[i].GetAddressOf());
+		err |= clSetKernelArg(k, 2, sizeof(int), &m_img_width);
+		err |= clSetKernelArg(k, 4, sizeof(int), &m_img_stride);
+		err |= clSetKernelArg(k, 5, sizeof(int), &num_hist_bins);
+		if(m_use_local_memory)
+			err |= clSetKernelArg(k, 6, sizeof(int) * NUM_HIST_BINS, nullptr);
+		V_RETURN_FALSE_CL(err, "Error setting kernel args: histogram");
+
+		k = clCreateKernel(m_md_program, "set_array_to_constant", &err);
+		V_RETURN_FALSE_CL(err, "Failed to create kernel: set_array_to_constant");
+		m_md_kernels_set_to_val[i].Reset(k);
+		err  = clSetKernelArg(k, 0, sizeof(cl_mem), m_md_d_hist[i].GetAddressOf());
+		err |= clSetKernelArg(k, 1, sizeof(int), &num_hist_bins);
+		err |= clSetKernelArg(k, 2, sizeof(int), &zero);
+		V_RETURN_FALSE_CL(err, "Error setting kernel args: set_array_to_constant");
+	}
+
+	return true;
 }
 
 static void
@@ -137,8 +238,8 @@ print_histogram(const std::vector<int> &h)
 	std::cout << "+\n";
 }
 
-void CHistogramTask::
-ComputeGPU(cl_context ctx, cl_command_queue cmdq, size_t lws[3])
+bool CHistogramTask::
+enqueue_histogram(cl_command_queue cmdq, size_t lws[3])
 {
 	size_t local_size_clear = 256;
 	size_t global_size_clear = ((NUM_HIST_BINS + local_size_clear - 1) / local_size_clear) * local_size_clear;
@@ -147,23 +248,34 @@ ComputeGPU(cl_context ctx, cl_command_queue cmdq, size_t lws[3])
 		((m_img_height + lws[1] - 1) / lws[1]) * lws[1]
 	};
 
-	CTimer timer;
-	clFinish(cmdq);
-	timer.Start();
+	cl_int err = clEnqueueNDRangeKernel(cmdq, m_kernel_set_to_val, 1, NULL, &global_size_clear, &local_size_clear, 0, NULL, NULL);
+	V_RETURN_FALSE_CL(err, "Error executing kernel set_array_to_constant");
+	err = clEnqueueNDRangeKernel(cmdq, m_kernel_histogram, 2, NULL, global_size, lws, 0, NULL, NULL);
+	V_RETURN_FALSE_CL(err, "Error executing kernel histogram");
+	return true;
+}
 
-	const int num_iterations = 100;
-	for(int i = 0; i < num_iterations; i++) {
-		clEnqueueNDRangeKernel(cmdq, m_kernel_set_to_val, 1, NULL, &global_size_clear, &local_size_clear, 0, NULL, NULL);
+void CHistogramTask::
+ComputeGPU(cl_context ctx, cl_command_queue cmdq, size_t lws[3])
+{
+	// every iteration is timed on its own, the first one is a warmup
+	CSamplingTimer timer(1);
+	clFinish(cmdq);
 
-		clEnqueueNDRangeKernel(cmdq, m_kernel_histogram, 2, NULL, global_size, lws, 0, NULL, NULL);
+	for(unsigned int i = 0; i < m_num_iterations + 1; i++) {
+		timer.Start();
+		enqueue_histogram(cmdq, lws);
+		clFinish(cmdq);
+		timer.Stop();
 	}
-	clFinish(cmdq);
-	timer.Stop();
 
 	const char *prefix = m_use_local_memory
 		? "  Histogram GPU time (using local memory): "
 		: "  Histogram GPU time (no local memory): ";
-	std::cout << prefix << timer.GetElapsedMilliseconds() / float(num_iterations) << " ms\n";
+	std::cout << prefix;
+	timer.PrintStatistics(std::cout);
+	std::cout << "\n";
+	CBenchmarkReport::Record("gpu", timer.GetSamples(), double(m_img_width) * m_img_height, "Gpixels/s");
 
 	m_histogram_gpu.resize(NUM_HIST_BINS);
 
@@ -172,22 +284,229 @@ ComputeGPU(cl_context ctx, cl_command_queue cmdq, size_t lws[3])
 
 }
 
+bool CHistogramTask::
+enqueue_band(size_t dev, cl_command_queue cmdq, int row_begin, int row_end, size_t lws[3])
+{
+	// the band is uploaded to the start of the device buffer, the kernel sees it as a smaller image
+	int band_height = row_end - row_begin;
+	size_t local_size_clear = 256;
+	size_t global_size_clear = ((NUM_HIST_BINS + local_size_clear - 1) / local_size_clear) * local_size_clear;
+	size_t global_size[2] = {
+		((m_img_width  + lws[0] - 1) / lws[0]) * lws[0],
+		((band_height  + lws[1] - 1) / lws[1]) * lws[1]
+	};
+
+	cl_int err = clSetKernelArg(m_md_kernels_histogram[dev], 3, sizeof(int), &band_height);
+	V_RETURN_FALSE_CL(err, "Error setting kernel Arg 3");
+	err = clEnqueueWriteBuffer(cmdq, m_md_d_pixels[dev], CL_FALSE, 0, sizeof(float) * band_height * m_img_stride,
+			m_pixels.data() + size_t(row_begin) * m_img_stride, 0, nullptr, nullptr);
+	V_RETURN_FALSE_CL(err, "Error copying data from host to device!");
+	err = clEnqueueNDRangeKernel(cmdq, m_md_kernels_set_to_val[dev], 1, NULL, &global_size_clear, &local_size_clear, 0, NULL, NULL);
+	V_RETURN_FALSE_CL(err, "Error executing kernel set_array_to_constant");
+	err = clEnqueueNDRangeKernel(cmdq, m_md_kernels_histogram[dev], 2, NULL, global_size, lws, 0, NULL, NULL);
+	V_RETURN_FALSE_CL(err, "Error executing kernel histogram");
+	err = clEnqueueReadBuffer(cmdq, m_md_d_hist[dev], CL_FALSE, 0, sizeof(int) * NUM_HIST_BINS,
+			m_md_histograms[dev].data(), 0, nullptr, nullptr);
+	V_RETURN_FALSE_CL(err, "Error reading data from device!");
+	return true;
+}
+
+void CHistogramTask::
+ComputeGPUMultiDevice(cl_context ctx, const std::vector<cl_command_queue> &cmdqs, size_t lws[3])
+{
+	size_t n = cmdqs.size();
+	// an empty histogram never matches the CPU result, so a run which stops early fails the validation
+	m_histogram_gpu.assign(NUM_HIST_BINS, 0);
+	auto run_band = [&](size_t dev, size_t row_begin, size_t row_end) {
+		return enqueue_band(dev, cmdqs[dev], int(row_begin), int(row_end), lws);
+	};
+
+	// bands are sized by the throughput of the devices, in multiples of the work-group height
+	std::vector<double> throughput = CLUtil::MeasureDeviceThroughput(cmdqs, m_img_height, lws[1], run_band);
+	if(throughput.empty())
+		return;
+	std::vector<size_t> rows = CLUtil::PartitionWork(m_img_height, throughput, lws[1]);
+
+	CTimer timer;
+	timer.Start();
+	for(size_t i = 0; i < n; i++) {
+		m_md_histograms[i].assign(NUM_HIST_BINS, 0);
+		if(rows[i + 1] > rows[i] && !run_band(i, rows[i], rows[i + 1]))
+			return;
+	}
+	// the partial histograms of all devices are needed, a single failed band fails the run
+	for(size_t i = 0; i < n; i++)
+		V_RETURN_CL(clFinish(cmdqs[i]), "Error finishing the queue of a device!");
+
+	for(size_t i = 0; i < n; i++) {
+		for(int j = 0; j < NUM_HIST_BINS; j++)
+			m_histogram_gpu[j] += m_md_histograms[i][j];
+	}
+	timer.Stop();
+
+	std::cout << "  Histogram time on " << n << " devices (including transfers): " << timer.GetElapsedMilliseconds() << " ms\n";
+	CBenchmarkReport::Record("multiDevice", timer.GetElapsedMilliseconds(), 1, double(m_img_width) * m_img_height, "Gpixels/s");
+	for(size_t i = 0; i < n; i++)
+		std::cout << "    device " << i << ": rows " << rows[i] << " - " << rows[i + 1] << "\n";
+}
+
+static bool
+save_histogram(const std::string &file, const std::vector<int> &h)
+{
+	std::ofstream out(file.c_str());
+	out << "bin,count\n";
+	for(size_t i = 0; i < h.size(); i++)
+		out << i << "," << h[i] << "\n";
+	out.close();
+	if(!out) {
+		std::cerr << "Error saving " << file << "." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool CHistogramTask::
+ComputeBatch(cl_device_id dev, cl_context ctx, cl_command_queue cmdq, const std::string &dir, size_t lws[3], bool &valid)
+{
+	valid = false;
+	std::vector<std::string> files;
+	std::string out_dir;
+	if(!CImagePipeline::PrepareBatch(dir, files, out_dir))
+		return false;
+
+	bool initialized = false;
+	double num_pixels = 0.0;
+	CImagePipeline pipeline;
+	bool success = pipeline.Run(files, [&](CImagePipeline::SItem &item) -> bool {
+		const PFM &img = *item.Image;
+		if(!initialized) {
+			// the first image creates the program, the kernels and the buffers, they stay for the whole batch
+			m_input_image = &img;
+			initialized = InitResources(dev, ctx);
+			m_input_image = nullptr;
+			if(!initialized)
+				return false;
+		}
+		else if(img.width != m_img_width || img.height != m_img_height) {
+			// another size: only the pixel buffer is reallocated (with the new pixels)
+			set_image(img);
+			if(!m_d_pixels.Create(ctx, CL_MEM_READ_ONLY, m_pixels.size(), m_pixels.data()) || !set_image_args())
+				return false;
+		}
+		else {
+			// the same size: only the pixels are uploaded
+			set_image(img);
+			if(!m_d_pixels.Write(cmdq, m_pixels.data(), m_pixels.size()))
+				return false;
+		}
+
+		// the blocking read waits for the upload as well, the next image overwrites m_pixels
+		std::shared_ptr<std::vector<int>> hist = std::make_shared<std::vector<int>>(NUM_HIST_BINS);
+		if(!enqueue_histogram(cmdq, lws) || !m_d_hist.Read(cmdq, hist->data(), NUM_HIST_BINS))
+			return false;
+		num_pixels += double(m_img_width) * m_img_height;
+
+		std::string file = CFileUtil::JoinPath(out_dir, CFileUtil::GetStem(item.InputFile) +
+				(m_use_local_memory ? "_histogram_local.csv" : "_histogram_global.csv"));
+		item.Writes.push_back([=]() { return save_histogram(file, *hist); });
+		return true;
+	}, [&](CImagePipeline::SItem &) -> bool {
+		// m_pixels still holds the image and m_d_hist its histogram
+		ComputeCPU();
+		m_histogram_gpu.resize(NUM_HIST_BINS);
+		if(!m_d_hist.Read(cmdq, m_histogram_gpu.data(), NUM_HIST_BINS))
+			return false;
+		return ValidateResults();
+	});
+	ReleaseResources();
+	valid = pipeline.IsValid();
+
+	if(pipeline.GetNumProcessed() > 0) {
+		double ms = pipeline.GetWallMilliseconds() / pipeline.GetNumProcessed();
+		std::cout << "  Average time per image: " << ms << " ms\n";
+		CBenchmarkReport::Record("batch", ms, unsigned(pipeline.GetNumProcessed()), num_pixels / pipeline.GetNumProcessed(), "Gpixels/s");
+	}
+	return success;
+}
+
+static void
+compute_histogram_rows(const float *pixels, int width, int stride, int row_begin, int row_end, int *hist)
+{
+	const int num_bins = CHistogramTask::NUM_HIST_BINS;
+	int sub_hist[NUM_SUB_HISTS][CHistogramTask::NUM_HIST_BINS];
+	memset(sub_hist, 0, sizeof(sub_hist));
+
+#ifdef HISTOGRAM_USE_SSE2
+	const __m128 v_scale = _mm_set1_ps(float(num_bins));
+	const __m128 v_min = _mm_setzero_ps();
+	const __m128 v_max = _mm_set1_ps(float(num_bins - 1));
+#endif
+
+	for(int y = row_begin; y < row_end; y++) {
+		const float *row = pixels + size_t(y) * stride;
+		int x = 0;
+#ifdef HISTOGRAM_USE_SSE2
+		// clamping in float before the truncating conversion gives the same bins
+		// as the scalar path below (and maps NaN to bin 0)
+		for(; x + 4 <= width; x += 4) {
+			__m128 p = _mm_mul_ps(_mm_loadu_ps(row + x), v_scale);
+			p = _mm_min_ps(_mm_max_ps(p, v_min), v_max);
+			__m128i idx = _mm_cvttps_epi32(p);
+			sub_hist[0][_mm_cvtsi128_si32(idx)]++;
+			sub_hist[1][_mm_cvtsi128_si32(_mm_shuffle_epi32(idx, 1))]++;
+			sub_hist[2][_mm_cvtsi128_si32(_mm_shuffle_epi32(idx, 2))]++;
+			sub_hist[3][_mm_cvtsi128_si32(_mm_shuffle_epi32(idx, 3))]++;
+		}
+#endif
+		for(; x < width; x++) {
+			float p = row[x] * float(num_bins);
+			int h_idx = std::min<int>(num_bins - 1, std::max<int>(0, int(p)));
+			sub_hist[x % NUM_SUB_HISTS][h_idx]++;
+		}
+	}
+
+	for(int i = 0; i < num_bins; i++) {
+		int sum = 0;
+		for(int j = 0; j < NUM_SUB_HISTS; j++)
+			sum += sub_hist[j][i];
+		hist[i] = sum;
+	}
+}
+
 void CHistogramTask::
 ComputeCPU()
 {
 	m_histogram.assign(NUM_HIST_BINS, 0);
+
+	// every thread accumulates a private histogram over a band of rows,
+	// the partial results are merged once all threads are done
+	int num_threads = std::max<int>(1, std::thread::hardware_concurrency());
+	num_threads = std::max<int>(1, std::min<int>(num_threads, m_img_height));
+	std::vector<int> partial(num_threads * NUM_HIST_BINS, 0);
+	std::vector<std::thread> workers;
+
 	CTimer timer;
 	timer.Start();
-	for(int y = 0; y < m_img_height; y++) {
-		for(int x = 0; x < m_img_width; x++) {
-			float p = m_pixels[y * m_img_stride + x] * float(NUM_HIST_BINS);
-			int h_idx = std::min<int>(NUM_HIST_BINS - 1, std::max<int>(0, int(p)));
-			m_histogram[h_idx]++;
-		}
+	int rows_per_thread = (m_img_height + num_threads - 1) / num_threads;
+	for(int t = 0; t < num_threads; t++) {
+		int row_begin = std::min<int>(m_img_height, t * rows_per_thread);
+		int row_end   = std::min<int>(m_img_height, row_begin + rows_per_thread);
+		int *hist = &partial[t * NUM_HIST_BINS];
+		if(t == num_threads - 1)
+			compute_histogram_rows(m_pixels.data(), m_img_width, m_img_stride, row_begin, row_end, hist);
+		else
+			workers.emplace_back(compute_histogram_rows, m_pixels.data(), m_img_width, m_img_stride, row_begin, row_end, hist);
+	}
+	for(auto &w: workers)
+		w.join();
+	for(int t = 0; t < num_threads; t++) {
+		for(int i = 0; i < NUM_HIST_BINS; i++)
+			m_histogram[i] += partial[t * NUM_HIST_BINS + i];
 	}
 	timer.Stop();
 
-	std::cout << "  Histogram CPU time: " << timer.GetElapsedMilliseconds() << " ms\n";
+	std::cout << "  Histogram CPU time (" << num_threads << " threads): " << timer.GetElapsedMilliseconds() << " ms\n";
+	CBenchmarkReport::Record("cpu", timer.GetElapsedMilliseconds(), 1, double(m_img_width) * m_img_height, "Gpixels/s");
 }
 
 bool CHistogramTask::
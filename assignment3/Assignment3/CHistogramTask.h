@@ -3,13 +3,21 @@
 
 #include <string>
 #include <vector>
-#include "../Common/IComputeTask.h"
+#include "../../Common/IComputeTask.h"
+#include "../../Common/IMultiDeviceComputeTask.h"
+#include "../../Common/IAsyncBuildComputeTask.h"
+#include "../../Common/IBatchComputeTask.h"
+#include "../../Common/CLHandles.h"
 
-class CHistogramTask : public IComputeTask
+class PFM;
+
+class CHistogramTask : public IComputeTask, public IMultiDeviceComputeTask, public IAsyncBuildComputeTask,
+	public IBatchComputeTask
 {
 public:
 	enum { NUM_HIST_BINS = 64 };
-	CHistogramTask(float min_val, float max_val, bool use_local_memory, const std::string &img_path);
+	CHistogramTask(float min_val, float max_val, bool use_local_memory, const std::string &img_path,
+			unsigned int num_iterations = 100);
 	virtual ~CHistogramTask();
 
 	virtual bool InitResources(cl_device_id Device, cl_context Context) override;
@@ -18,16 +26,46 @@ public:
 	virtual void ComputeCPU() override;
 	virtual bool ValidateResults() override;
 
+	// multi-device mode: every device counts a band of rows, the histograms are summed up
+	virtual bool InitMultiDeviceResources(cl_context ctx, const std::vector<cl_device_id> &devices) override;
+	virtual void ComputeGPUMultiDevice(cl_context ctx, const std::vector<cl_command_queue> &cmdqs, size_t lws[3]) override;
+
+	// the program is built while the other tasks are queued
+	virtual void StartProgramBuilds(cl_device_id dev, cl_context ctx) override;
+
+	// batch mode: the histograms of all images of a directory, saved as <dir>/results/<image>_histogram_*.csv,
+	// the program, the kernels and the buffers are created once; the first image and every image after a
+	// change of the size are validated
+	virtual bool ComputeBatch(cl_device_id dev, cl_context ctx, cl_command_queue cmdq, const std::string &dir,
+			size_t lws[3], bool &valid) override;
+
 protected:
+	// converts the image to the grayscale pixels, which are only reallocated if the size changed
+	void set_image(const PFM &img);
+	// binds the pixel buffer and the image size to the histogram kernel
+	bool set_image_args();
+	// clears the histogram and counts the pixels of the whole image
+	bool enqueue_histogram(cl_command_queue cmdq, size_t lws[3]);
+	bool enqueue_band(size_t dev, cl_command_queue cmdq, int row_begin, int row_end, size_t lws[3]);
+
 	float m_min_val = 0.0f, m_max_val = 1.0f;
 	const std::string m_img_path;
+	// the current image of the batch mode, InitResources() loads m_img_path if this is nullptr
+	const PFM *m_input_image = nullptr;
 	const bool m_use_local_memory;
+	const unsigned int m_num_iterations;
 	int m_img_width = 0, m_img_height = 0, m_img_stride = 0;
 
-	cl_program m_program = nullptr;
-	cl_kernel m_kernel_histogram = nullptr, m_kernel_set_to_val = nullptr;
-	cl_mem m_d_pixels = nullptr;
-	cl_mem m_d_hist = nullptr;
+	CLProgram m_program;
+	CLKernel m_kernel_histogram, m_kernel_set_to_val;
+	DeviceBuffer<float> m_d_pixels;
+	DeviceBuffer<int> m_d_hist;
+
+	CLProgram m_md_program;
+	std::vector<CLKernel> m_md_kernels_histogram, m_md_kernels_set_to_val;
+	std::vector<DeviceBuffer<float>> m_md_d_pixels;
+	std::vector<DeviceBuffer<int>> m_md_d_hist;
+	std::vector<std::vector<int>> m_md_histograms;
 
 	std::vector<int> m_histogram, m_histogram_gpu;
 	std::vector<float> m_pixels;
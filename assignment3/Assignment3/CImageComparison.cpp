@@ -0,0 +1,232 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CImageComparison.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_COMPARISON_USE_SSE2
+#endif
+
+using namespace std;
+
+// below this many pixels per thread, starting the threads costs more than the comparison
+#define MIN_PIXELS_PER_THREAD (256 * 1024)
+
+namespace
+{
+	//! Partial result of a band of rows
+	struct SPartialDifference
+	{
+		uint32_t	MaxULP;
+		float		MaxAbsError;
+		double		SumSquaredError;
+		size_t		Mismatches;
+	};
+
+	//! Maps the bits of a float to an integer which grows monotonically with the value (-0 and +0 are both 0)
+	inline int32_t OrderedBits(float Value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &Value, sizeof(bits));
+		return int32_t(bits & 0x80000000u ? 0x80000000u - bits : bits);
+	}
+
+	//! Compares a single value, returns its squared error
+	inline float CompareValue(float Reference, float Result, uint32_t MaxULP, float AbsTolerance, SPartialDifference& Partial)
+	{
+		bool refNaN = Reference != Reference;
+		bool resNaN = Result != Result;
+		if(Reference == Result || (refNaN && resNaN))
+			return 0.0f;
+
+		uint32_t ulp;
+		float absError;
+		if(refNaN || resNaN)
+		{
+			ulp = numeric_limits<uint32_t>::max();
+			absError = numeric_limits<float>::infinity();
+		}
+		else
+		{
+			int32_t a = OrderedBits(Reference);
+			int32_t b = OrderedBits(Result);
+			ulp = a > b ? uint32_t(a) - uint32_t(b) : uint32_t(b) - uint32_t(a);
+			absError = fabs(Reference - Result);
+		}
+
+		Partial.MaxULP = max(Partial.MaxULP, ulp);
+		Partial.MaxAbsError = max(Partial.MaxAbsError, absError);
+		if(ulp > MaxULP && absError > AbsTolerance)
+			Partial.Mismatches++;
+		return absError * absError;
+	}
+
+	void CompareRows(const float* const Reference[3], const float* const Result[3], unsigned int NumChannels,
+		unsigned int Width, unsigned int Pitch, unsigned int RowBegin, unsigned int RowEnd, uint32_t MaxULP,
+		float AbsTolerance, float* const Difference[3], SPartialDifference& Partial)
+	{
+		Partial.MaxULP = 0;
+		Partial.MaxAbsError = 0.0f;
+		Partial.SumSquaredError = 0.0;
+		Partial.Mismatches = 0;
+
+#ifdef IMAGE_COMPARISON_USE_SSE2
+		// unsigned compares are signed compares of the values with the sign bit flipped
+		const __m128i signBit = _mm_set1_epi32(int(0x80000000u));
+		const __m128i maxULP = _mm_xor_si128(_mm_set1_epi32(int(MaxULP)), signBit);
+		const __m128 absTolerance = _mm_set1_ps(AbsTolerance);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128i vMaxULP = signBit;
+		__m128 vMaxAbsError = _mm_setzero_ps();
+#endif
+
+		for(unsigned int c = 0; c < NumChannels; c++)
+		{
+			for(unsigned int y = RowBegin; y < RowEnd; y++)
+			{
+				const float* ref = Reference[c] + size_t(y) * Pitch;
+				const float* res = Result[c] + size_t(y) * Pitch;
+				float* diff = Difference ? Difference[c] + size_t(y) * Pitch : nullptr;
+
+				// the squared errors of a row are summed in float, the rows in double
+				float rowSum = 0.0f;
+				unsigned int x = 0;
+#ifdef IMAGE_COMPARISON_USE_SSE2
+				__m128 vRowSum = _mm_setzero_ps();
+				for(; x + 4 <= Width; x += 4)
+				{
+					__m128 a = _mm_loadu_ps(ref + x);
+					__m128 b = _mm_loadu_ps(res + x);
+					__m128 d = _mm_sub_ps(a, b);
+
+					// NaN inputs and equal infinities need the scalar rules
+					if(_mm_movemask_ps(_mm_cmpunord_ps(d, d)))
+					{
+						for(unsigned int i = 0; i < 4; i++)
+						{
+							float e = CompareValue(ref[x + i], res[x + i], MaxULP, AbsTolerance, Partial);
+							rowSum += e;
+							if(diff)
+								diff[x + i] = e;
+						}
+						continue;
+					}
+
+					__m128 sq = _mm_mul_ps(d, d);
+					vRowSum = _mm_add_ps(vRowSum, sq);
+					if(diff)
+						_mm_storeu_ps(diff + x, sq);
+
+					__m128 absError = _mm_and_ps(d, absMask);
+					vMaxAbsError = _mm_max_ps(vMaxAbsError, absError);
+
+					// ordered bits: negative values become INT_MIN - bits
+					__m128i ia = _mm_castps_si128(a);
+					__m128i ib = _mm_castps_si128(b);
+					__m128i sa = _mm_srai_epi32(ia, 31);
+					__m128i sb = _mm_srai_epi32(ib, 31);
+					__m128i oa = _mm_or_si128(_mm_and_si128(sa, _mm_sub_epi32(signBit, ia)), _mm_andnot_si128(sa, ia));
+					__m128i ob = _mm_or_si128(_mm_and_si128(sb, _mm_sub_epi32(signBit, ib)), _mm_andnot_si128(sb, ib));
+
+					// |oa - ob| fits into 32 bits unsigned even if the signed difference overflows
+					__m128i greater = _mm_cmpgt_epi32(oa, ob);
+					__m128i ulp = _mm_or_si128(_mm_and_si128(greater, _mm_sub_epi32(oa, ob)),
+						_mm_andnot_si128(greater, _mm_sub_epi32(ob, oa)));
+
+					__m128i biasedULP = _mm_xor_si128(ulp, signBit);
+					__m128i ulpGreater = _mm_cmpgt_epi32(biasedULP, vMaxULP);
+					vMaxULP = _mm_or_si128(_mm_and_si128(ulpGreater, biasedULP), _mm_andnot_si128(ulpGreater, vMaxULP));
+
+					__m128 mismatch = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(biasedULP, maxULP)),
+						_mm_cmpgt_ps(absError, absTolerance));
+					int mask = _mm_movemask_ps(mismatch);
+					Partial.Mismatches += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+				}
+				float lanes[4];
+				_mm_storeu_ps(lanes, vRowSum);
+				rowSum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+				for(; x < Width; x++)
+				{
+					float e = CompareValue(ref[x], res[x], MaxULP, AbsTolerance, Partial);
+					rowSum += e;
+					if(diff)
+						diff[x] = e;
+				}
+				Partial.SumSquaredError += rowSum;
+			}
+		}
+
+#ifdef IMAGE_COMPARISON_USE_SSE2
+		uint32_t ulps[4];
+		float absErrors[4];
+		_mm_storeu_si128((__m128i*)ulps, _mm_xor_si128(vMaxULP, signBit));
+		_mm_storeu_ps(absErrors, vMaxAbsError);
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			Partial.MaxULP = max(Partial.MaxULP, ulps[i]);
+			Partial.MaxAbsError = max(Partial.MaxAbsError, absErrors[i]);
+		}
+#endif
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CImageComparison
+
+SImageDifference CImageComparison::Compare(const float* const Reference[3], const float* const Result[3], unsigned int NumChannels,
+	unsigned int Width, unsigned int Height, unsigned int Pitch, uint32_t MaxULP, float AbsTolerance,
+	float* const Difference[3])
+{
+	size_t pixels = size_t(Width) * Height;
+	unsigned int numThreads = max(1u, thread::hardware_concurrency());
+	numThreads = (unsigned int)min<size_t>(numThreads, max<size_t>(1, pixels / MIN_PIXELS_PER_THREAD));
+	numThreads = min(numThreads, max(1u, Height));
+
+	// every thread compares a band of rows into its own partial result,
+	// the last band runs on the calling thread
+	vector<SPartialDifference> partial(numThreads);
+	vector<thread> workers;
+	unsigned int rowsPerThread = (Height + numThreads - 1) / numThreads;
+	for(unsigned int t = 0; t < numThreads; t++)
+	{
+		unsigned int rowBegin = min(Height, t * rowsPerThread);
+		unsigned int rowEnd = min(Height, rowBegin + rowsPerThread);
+		if(t == numThreads - 1)
+			CompareRows(Reference, Result, NumChannels, Width, Pitch, rowBegin, rowEnd, MaxULP, AbsTolerance, Difference, partial[t]);
+		else
+			workers.emplace_back(CompareRows, Reference, Result, NumChannels, Width, Pitch, rowBegin, rowEnd, MaxULP,
+				AbsTolerance, Difference, ref(partial[t]));
+	}
+	for(size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	SImageDifference result;
+	result.MaxULP = 0;
+	result.MaxAbsError = 0.0f;
+	result.Mismatches = 0;
+	result.NumValues = pixels * NumChannels;
+	double sumSquaredError = 0.0;
+	for(unsigned int t = 0; t < numThreads; t++)
+	{
+		result.MaxULP = max(result.MaxULP, partial[t].MaxULP);
+		result.MaxAbsError = max(result.MaxAbsError, partial[t].MaxAbsError);
+		result.Mismatches += partial[t].Mismatches;
+		sumSquaredError += partial[t].SumSquaredError;
+	}
+	result.MSE = result.NumValues > 0 ? sumSquaredError / double(result.NumValues) : 0.0;
+	result.PSNR = result.MSE > 0.0 ? -10.0 * log10(result.MSE) : numeric_limits<double>::infinity();
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
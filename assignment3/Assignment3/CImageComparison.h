@@ -0,0 +1,67 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+
+#ifndef _CIMAGE_COMPARISON_H
+#define _CIMAGE_COMPARISON_H
+
+#include <cstddef>
+#include <cstdint>
+
+//! Result of CImageComparison::Compare()
+struct SImageDifference
+{
+	//! Largest distance in units in the last place, UINT32_MAX if only one of two values is NaN
+	uint32_t	MaxULP;
+	//! Largest absolute difference
+	float		MaxAbsError;
+	//! Mean squared error
+	double		MSE;
+	//! Peak signal-to-noise ratio in dB for a peak value of 1, infinite for identical images
+	double		PSNR;
+	//! Number of values outside of both tolerances
+	size_t		Mismatches;
+	//! Number of compared values
+	size_t		NumValues;
+};
+
+//! Compares the padded planar channels of a reference and a result image
+/*!
+	The planes have Height rows of Pitch floats of which the first Width are compared
+	(see CImageConversion). A value is a mismatch if it differs from the reference by
+	more than MaxULP units in the last place and by more than AbsTolerance, so values
+	close to zero are not held to their tiny ULP. Two NaNs are equal.
+
+	The comparison uses SSE2 where available and splits large images into bands of
+	rows, one per hardware thread.
+*/
+class CImageComparison
+{
+public:
+	//! Compares NumChannels (1 or 3) planes
+	/*!
+		If Difference is not nullptr, the squared error of every value is written to these
+		planes, the padding of the rows is not touched.
+	*/
+	static SImageDifference Compare(const float* const Reference[3], const float* const Result[3], unsigned int NumChannels,
+		unsigned int Width, unsigned int Height, unsigned int Pitch, uint32_t MaxULP, float AbsTolerance,
+		float* const Difference[3] = nullptr);
+};
+
+#endif // _CIMAGE_COMPARISON_H
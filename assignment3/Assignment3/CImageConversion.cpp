@@ -0,0 +1,277 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CImageConversion.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_CONVERSION_USE_SSE2
+#endif
+
+using namespace std;
+
+// below this many pixels per thread, starting the threads costs more than the conversion
+#define MIN_PIXELS_PER_THREAD (256 * 1024)
+
+#define GRAY_R 0.3f
+#define GRAY_G 0.59f
+#define GRAY_B 0.11f
+
+// same clamping as _mm_max_ps / _mm_min_ps in Quantize16SSE(), which map NaN to 0
+static inline unsigned char QuantizeValue(float Value)
+{
+	Value *= 255.0f;
+	return (unsigned char)(Value > 0.0f ? (Value < 255.0f ? Value : 255.0f) : 0.0f);
+}
+
+#ifdef IMAGE_CONVERSION_USE_SSE2
+// 4 interleaved pixels r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3 to the planes r0..r3, g0..g3, b0..b3
+static inline void DeinterleaveSSE(const float* pIn, __m128& R, __m128& G, __m128& B)
+{
+	__m128 a = _mm_loadu_ps(pIn);
+	__m128 b = _mm_loadu_ps(pIn + 4);
+	__m128 c = _mm_loadu_ps(pIn + 8);
+
+	R = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	G = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	B = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// 16 floats to 16 bytes, the clamped values fit the saturating packs
+static inline void Quantize16SSE(const float* pIn, unsigned char* pOut)
+{
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128i v[4];
+	for(int i = 0; i < 4; i++)
+		v[i] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(pIn + 4 * i), scale), zero), scale));
+	__m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+	_mm_storeu_si128((__m128i*)pOut, packed);
+}
+
+// inverse of DeinterleaveSSE()
+static inline void InterleaveSSE(__m128 R, __m128 G, __m128 B, float* pOut)
+{
+	__m128 rg01 = _mm_unpacklo_ps(R, G);
+	__m128 rg23 = _mm_unpackhi_ps(R, G);
+
+	_mm_storeu_ps(pOut,     _mm_shuffle_ps(rg01, _mm_shuffle_ps(B, R, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+	_mm_storeu_ps(pOut + 4, _mm_shuffle_ps(_mm_shuffle_ps(G, B, _MM_SHUFFLE(1, 1, 1, 1)), rg23, _MM_SHUFFLE(1, 0, 2, 0)));
+	_mm_storeu_ps(pOut + 8, _mm_shuffle_ps(_mm_shuffle_ps(B, R, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(G, B, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// CImageConversion
+
+template<typename TBody>
+void CImageConversion::ParallelRows(unsigned int Width, unsigned int Height, const TBody& Body)
+{
+	size_t pixels = size_t(Width) * Height;
+	unsigned int numThreads = max(1u, thread::hardware_concurrency());
+	numThreads = (unsigned int)min<size_t>(numThreads, max<size_t>(1, pixels / MIN_PIXELS_PER_THREAD));
+	numThreads = min(numThreads, max(1u, Height));
+
+	// the last band runs on the calling thread
+	vector<thread> workers;
+	unsigned int rowsPerThread = (Height + numThreads - 1) / numThreads;
+	for(unsigned int t = 0; t < numThreads; t++)
+	{
+		unsigned int rowBegin = min(Height, t * rowsPerThread);
+		unsigned int rowEnd = min(Height, rowBegin + rowsPerThread);
+		if(t == numThreads - 1)
+			Body(rowBegin, rowEnd);
+		else
+			workers.emplace_back(Body, rowBegin, rowEnd);
+	}
+	for(size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void CImageConversion::Deinterleave(const float* const* Rows, unsigned int Width, unsigned int Height, unsigned int Pitch,
+	float* Channels[3])
+{
+	ParallelRows(Width, Height, [=](unsigned int RowBegin, unsigned int RowEnd)
+	{
+		for(unsigned int y = RowBegin; y < RowEnd; y++)
+		{
+			const float* row = Rows[y];
+			float* r = Channels[0] + size_t(y) * Pitch;
+			float* g = Channels[1] + size_t(y) * Pitch;
+			float* b = Channels[2] + size_t(y) * Pitch;
+
+			unsigned int x = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE2
+			for(; x + 4 <= Width; x += 4)
+			{
+				__m128 vr, vg, vb;
+				DeinterleaveSSE(row + 3 * x, vr, vg, vb);
+				_mm_storeu_ps(r + x, vr);
+				_mm_storeu_ps(g + x, vg);
+				_mm_storeu_ps(b + x, vb);
+			}
+#endif
+			for(; x < Width; x++)
+			{
+				r[x] = row[3 * x    ];
+				g[x] = row[3 * x + 1];
+				b[x] = row[3 * x + 2];
+			}
+
+			//pad the image with zeros
+			size_t padding = (Pitch - Width) * sizeof(float);
+			memset(r + Width, 0, padding);
+			memset(g + Width, 0, padding);
+			memset(b + Width, 0, padding);
+		}
+	});
+}
+
+void CImageConversion::DeinterleaveGrayscale(const float* const* Rows, unsigned int Width, unsigned int Height, unsigned int Pitch,
+	float* Channel)
+{
+	ParallelRows(Width, Height, [=](unsigned int RowBegin, unsigned int RowEnd)
+	{
+#ifdef IMAGE_CONVERSION_USE_SSE2
+		const __m128 wr = _mm_set1_ps(GRAY_R);
+		const __m128 wg = _mm_set1_ps(GRAY_G);
+		const __m128 wb = _mm_set1_ps(GRAY_B);
+#endif
+		for(unsigned int y = RowBegin; y < RowEnd; y++)
+		{
+			const float* row = Rows[y];
+			float* gray = Channel + size_t(y) * Pitch;
+
+			unsigned int x = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE2
+			// same weights and order of additions as the scalar loop below
+			for(; x + 4 <= Width; x += 4)
+			{
+				__m128 vr, vg, vb;
+				DeinterleaveSSE(row + 3 * x, vr, vg, vb);
+				__m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vr, wr), _mm_mul_ps(vg, wg)), _mm_mul_ps(vb, wb));
+				_mm_storeu_ps(gray + x, s);
+			}
+#endif
+			for(; x < Width; x++)
+				gray[x] = GRAY_R * row[3 * x] + GRAY_G * row[3 * x + 1] + GRAY_B * row[3 * x + 2];
+
+			memset(gray + Width, 0, (Pitch - Width) * sizeof(float));
+		}
+	});
+}
+
+void CImageConversion::PlanesToGrayscale(const float* const Channels[3], unsigned int Width, unsigned int Height, unsigned int Pitch,
+	float* Gray)
+{
+	ParallelRows(Width, Height, [=](unsigned int RowBegin, unsigned int RowEnd)
+	{
+#ifdef IMAGE_CONVERSION_USE_SSE2
+		const __m128 wr = _mm_set1_ps(GRAY_R);
+		const __m128 wg = _mm_set1_ps(GRAY_G);
+		const __m128 wb = _mm_set1_ps(GRAY_B);
+#endif
+		for(unsigned int y = RowBegin; y < RowEnd; y++)
+		{
+			const float* r = Channels[0] + size_t(y) * Pitch;
+			const float* g = Channels[1] + size_t(y) * Pitch;
+			const float* b = Channels[2] + size_t(y) * Pitch;
+			float* gray = Gray + size_t(y) * Pitch;
+
+			unsigned int x = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE2
+			for(; x + 4 <= Width; x += 4)
+			{
+				__m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(r + x), wr), _mm_mul_ps(_mm_loadu_ps(g + x), wg)),
+					_mm_mul_ps(_mm_loadu_ps(b + x), wb));
+				_mm_storeu_ps(gray + x, s);
+			}
+#endif
+			for(; x < Width; x++)
+				gray[x] = GRAY_R * r[x] + GRAY_G * g[x] + GRAY_B * b[x];
+
+			memset(gray + Width, 0, (Pitch - Width) * sizeof(float));
+		}
+	});
+}
+
+void CImageConversion::Interleave(const float* const Channels[3], unsigned int Width, unsigned int Height, unsigned int Pitch,
+	float* const* Rows)
+{
+	ParallelRows(Width, Height, [=](unsigned int RowBegin, unsigned int RowEnd)
+	{
+		for(unsigned int y = RowBegin; y < RowEnd; y++)
+		{
+			float* row = Rows[y];
+			const float* r = Channels[0] + size_t(y) * Pitch;
+			const float* g = Channels[1] + size_t(y) * Pitch;
+			const float* b = Channels[2] + size_t(y) * Pitch;
+
+			unsigned int x = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE2
+			for(; x + 4 <= Width; x += 4)
+				InterleaveSSE(_mm_loadu_ps(r + x), _mm_loadu_ps(g + x), _mm_loadu_ps(b + x), row + 3 * x);
+#endif
+			for(; x < Width; x++)
+			{
+				row[3 * x    ] = r[x];
+				row[3 * x + 1] = g[x];
+				row[3 * x + 2] = b[x];
+			}
+		}
+	});
+}
+
+void CImageConversion::Quantize(const float* const Channels[3], unsigned int NumChannels, unsigned int Width, unsigned int Height,
+	unsigned int Pitch, unsigned char* const* Rows)
+{
+	ParallelRows(Width, Height, [=](unsigned int RowBegin, unsigned int RowEnd)
+	{
+		for(unsigned int y = RowBegin; y < RowEnd; y++)
+		{
+			unsigned char* row = Rows[y];
+			const float* c0 = Channels[0] + size_t(y) * Pitch;
+			unsigned int x = 0;
+
+			if(NumChannels == 1)
+			{
+#ifdef IMAGE_CONVERSION_USE_SSE2
+				for(; x + 16 <= Width; x += 16)
+					Quantize16SSE(c0 + x, row + x);
+#endif
+				for(; x < Width; x++)
+					row[x] = QuantizeValue(c0[x]);
+				continue;
+			}
+
+			const float* c1 = Channels[1] + size_t(y) * Pitch;
+			const float* c2 = Channels[2] + size_t(y) * Pitch;
+#ifdef IMAGE_CONVERSION_USE_SSE2
+			// interleaving the floats first leaves a plain stream of values to quantize
+			for(; x + 16 <= Width; x += 16)
+			{
+				float interleaved[48];
+				for(unsigned int i = 0; i < 4; i++)
+					InterleaveSSE(_mm_loadu_ps(c0 + x + 4 * i), _mm_loadu_ps(c1 + x + 4 * i), _mm_loadu_ps(c2 + x + 4 * i), interleaved + 12 * i);
+				for(unsigned int i = 0; i < 3; i++)
+					Quantize16SSE(interleaved + 16 * i, row + 3 * x + 16 * i);
+			}
+#endif
+			for(; x < Width; x++)
+			{
+				row[3 * x    ] = QuantizeValue(c0[x]);
+				row[3 * x + 1] = QuantizeValue(c1[x]);
+				row[3 * x + 2] = QuantizeValue(c2[x]);
+			}
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
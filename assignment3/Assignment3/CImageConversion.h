@@ -0,0 +1,71 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CIMAGE_CONVERSION_H
+#define _CIMAGE_CONVERSION_H
+
+#include <cstddef>
+
+//! Conversions between interleaved RGB images and padded planar channels
+/*!
+	The images are loaded and saved as interleaved RGB floats (one pointer per row, see
+	PFM::GetRow()), the tasks work on one plane per channel with Pitch floats per row.
+	The routines use SSE2 shuffles where available and split large images into bands
+	of rows, one per hardware thread.
+*/
+class CImageConversion
+{
+public:
+	//! Splits the rows into the R, G and B planes and zeroes the padding (Width..Pitch) of every row
+	static void Deinterleave(const float* const* Rows, unsigned int Width, unsigned int Height, unsigned int Pitch,
+		float* Channels[3]);
+
+	//! Converts the rows to a single grayscale plane (0.3 R + 0.59 G + 0.11 B), the padding is zeroed
+	static void DeinterleaveGrayscale(const float* const* Rows, unsigned int Width, unsigned int Height, unsigned int Pitch,
+		float* Channel);
+
+	//! Luminance of three planes, with the weights of DeinterleaveGrayscale()
+	/*!
+		Gray has the same pitch as the planes, its padding is set to zero.
+	*/
+	static void PlanesToGrayscale(const float* const Channels[3], unsigned int Width, unsigned int Height, unsigned int Pitch,
+		float* Gray);
+
+	//! Inverse of Deinterleave(), the padding of the planes is skipped
+	/*!
+		Passing the same plane three times writes a grayscale image as RGB.
+	*/
+	static void Interleave(const float* const Channels[3], unsigned int Width, unsigned int Height, unsigned int Pitch,
+		float* const* Rows);
+
+	//! Quantizes NumChannels (1 or 3) planes to interleaved 8 bit rows, [0, 1] maps to [0, 255]
+	/*!
+		Values are clamped and truncated like CConvolutionTaskBase::To8BitChannel(), NaN becomes 0.
+		The channels are written in the given order, pass B, G, R for BMP rows.
+	*/
+	static void Quantize(const float* const Channels[3], unsigned int NumChannels, unsigned int Width, unsigned int Height,
+		unsigned int Pitch, unsigned char* const* Rows);
+
+protected:
+	//! Runs Body(RowBegin, RowEnd) on bands of rows, on worker threads if the image is large enough
+	template<typename TBody>
+	static void ParallelRows(unsigned int Width, unsigned int Height, const TBody& Body);
+};
+
+#endif // _CIMAGE_CONVERSION_H
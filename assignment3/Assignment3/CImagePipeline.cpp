@@ -0,0 +1,183 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CImagePipeline.h"
+
+#include "../../Common/CBoundedQueue.h"
+#include "../../Common/CTimer.h"
+#include "../../Common/CTraceRecorder.h"
+#include "../../Common/CFileUtil.h"
+#include "../../Common/CBenchmarkReport.h"
+
+#include <atomic>
+#include <thread>
+#include <iostream>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CImagePipeline
+
+CImagePipeline::CImagePipeline(size_t QueueDepth)
+	: m_QueueDepth(QueueDepth)
+{
+}
+
+bool CImagePipeline::PrepareBatch(const std::string& Directory, std::vector<std::string>& Files, std::string& OutputDirectory)
+{
+	if(!CFileUtil::ListFiles(Directory, ".pfm", Files) || Files.empty())
+	{
+		cerr << "Error: no PFM images found in " << Directory << "." << endl;
+		return false;
+	}
+
+	OutputDirectory = CFileUtil::JoinPath(Directory, "results");
+	if(!CFileUtil::MakeDirectory(OutputDirectory))
+	{
+		cerr << "Error creating the directory " << OutputDirectory << "." << endl;
+		return false;
+	}
+	cout << "Batch of " << Files.size() << " images, the results are saved to " << OutputDirectory << endl;
+	return true;
+}
+
+bool CImagePipeline::Run(const std::vector<std::string>& Files, const ProcessFunction& Process, const ValidateFunction& Validate)
+{
+	typedef unique_ptr<SItem> ItemPtr;
+	CBoundedQueue<ItemPtr> loaded(m_QueueDepth);
+	CBoundedQueue<ItemPtr> processed(m_QueueDepth);
+	atomic<bool> loadFailed(false);
+	atomic<bool> saveFailed(false);
+
+	m_NumProcessed = 0;
+	m_NumValidated = m_NumMismatches = 0;
+	m_LoadMs = m_ProcessMs = m_SaveMs = m_ValidateMs = 0.0;
+
+	CTimer wallTimer;
+	wallTimer.Start();
+
+	// stage 1: loading, ends early if the device work stops and closes the queue
+	thread reader([&]() {
+		CTimer timer;
+		for(size_t i = 0; i < Files.size(); i++)
+		{
+			ItemPtr item(new SItem);
+			item->InputFile = Files[i];
+			item->Image.reset(new PFM);
+
+			bool ok;
+			timer.Start();
+			{
+				CTraceScope scope("LoadImage", "io");
+				ok = item->Image->LoadRGB(Files[i].c_str());
+			}
+			timer.Stop();
+			m_LoadMs += timer.GetElapsedMilliseconds();
+
+			if(!ok)
+			{
+				loadFailed = true;
+				break;
+			}
+			if(!loaded.Push(move(item)))
+				break;
+		}
+		loaded.Close();
+	});
+
+	// stage 3: saving, the writes of an image run in the order they were queued
+	thread writer([&]() {
+		CTimer timer;
+		ItemPtr item;
+		while(processed.Pop(item))
+		{
+			timer.Start();
+			{
+				CTraceScope scope("SaveImage", "io");
+				for(size_t i = 0; i < item->Writes.size(); i++)
+				{
+					if(!item->Writes[i]())
+						saveFailed = true;
+				}
+			}
+			timer.Stop();
+			m_SaveMs += timer.GetElapsedMilliseconds();
+			item.reset();
+		}
+	});
+
+	// stage 2: the device work on this thread
+	bool processOk = true;
+	CTimer timer;
+	ItemPtr item;
+	int lastWidth = -1, lastHeight = -1;
+	while(processOk && loaded.Pop(item))
+	{
+		bool validate = Validate && (item->Image->width != lastWidth || item->Image->height != lastHeight);
+		lastWidth = item->Image->width;
+		lastHeight = item->Image->height;
+
+		timer.Start();
+		{
+			CTraceScope scope("ProcessImage", "task");
+			processOk = Process(*item);
+		}
+		timer.Stop();
+		m_ProcessMs += timer.GetElapsedMilliseconds();
+
+		if(processOk && validate)
+		{
+			CTraceScope scope("ValidateImage", "task");
+			CBenchmarkReport* report = CBenchmarkReport::GetActive();
+			CBenchmarkReport::SetActive(nullptr);
+			cout << "Validating " << item->InputFile << " against the CPU reference" << endl;
+			timer.Start();
+			bool valid = Validate(*item);
+			timer.Stop();
+			m_ValidateMs += timer.GetElapsedMilliseconds();
+			CBenchmarkReport::SetActive(report);
+
+			m_NumValidated++;
+			if(!valid)
+			{
+				cerr << "Error: the result of " << item->InputFile << " does not match the CPU reference." << endl;
+				m_NumMismatches++;
+			}
+		}
+
+		// the commands of the image have completed: their events are released now, not after the whole batch
+		if(CTraceRecorder::GetActive() != nullptr)
+			CTraceRecorder::GetActive()->Flush();
+
+		// the input is not needed any more, release its mapping before the item waits for the writer
+		item->Image.reset();
+		if(!processOk)
+		{
+			cerr << "Error processing " << item->InputFile << ", the batch is stopped." << endl;
+			break;
+		}
+		m_NumProcessed++;
+		processed.Push(move(item));
+	}
+
+	// closing the input lets a reader waiting in Push() return, the writer still saves what it got
+	loaded.Close();
+	processed.Close();
+	reader.join();
+	writer.join();
+
+	wallTimer.Stop();
+	m_WallMs = wallTimer.GetElapsedMilliseconds() - m_ValidateMs;
+
+	cout << m_NumProcessed << " of " << Files.size() << " images in " << m_WallMs << " ms (load " << m_LoadMs
+		<< " ms, compute " << m_ProcessMs << " ms, save " << m_SaveMs << " ms, the stages overlap)" << endl;
+	if(Validate)
+		cout << m_NumValidated << " image(s) validated in " << m_ValidateMs << " ms (not included above), "
+			<< m_NumMismatches << " mismatch(es)" << endl;
+
+	return processOk && !loadFailed && !saveFailed && m_NumProcessed == Files.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,108 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+
+#ifndef _CIMAGE_PIPELINE_H
+#define _CIMAGE_PIPELINE_H
+
+#include "Pfm.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+//! Three stage pipeline for batches of images: loading, device work and saving
+/*!
+	A reader thread loads the images into a bounded queue, the calling thread takes them
+	out and does the device work (it owns the command queue), and a writer thread executes
+	the writes queued by it. While image N is computed, image N+1 is loaded and the results
+	of image N-1 are written. Each queue holds at most QueueDepth images, so the memory use
+	does not depend on the size of the batch.
+*/
+class CImagePipeline
+{
+public:
+	//! One image of the batch
+	struct SItem
+	{
+		std::string							InputFile;
+		//! Loaded by the reader thread, released right after the device work
+		std::unique_ptr<PFM>				Image;
+		//! Queued by the device work, executed in order by the writer thread
+		/*!
+			The writes must own (or share) the data they save, the item is destroyed
+			after them.
+		*/
+		std::vector<std::function<bool()> >	Writes;
+	};
+
+	//! The device work on an image, returns false to stop the batch
+	typedef std::function<bool(SItem& Item)> ProcessFunction;
+	//! Compares the result of the image just processed to a CPU reference, returns false on a mismatch
+	typedef std::function<bool(SItem& Item)> ValidateFunction;
+
+	explicit CImagePipeline(size_t QueueDepth = 2);
+
+	//! Lists the PFM images of Directory and creates its subdirectory "results" for the outputs
+	/*!
+		The results are kept apart, so a later batch over the same directory does not pick them up.
+	*/
+	static bool PrepareBatch(const std::string& Directory, std::vector<std::string>& Files, std::string& OutputDirectory);
+
+	//! Loads, processes and saves Files, Process is called on the calling thread in the order of Files
+	/*!
+		The batch stops at the first image which cannot be loaded or processed, the results
+		processed before it are still saved. Returns false if any image failed.
+
+		Validate is called right after Process for the first image and every image whose size
+		differs from the image before it, the other images of the same size run the same
+		kernels with the same launch configuration. The batch continues after a mismatch.
+		The CPU reference is not part of the batch: the results recorded in CBenchmarkReport
+		during Validate are discarded and its time is not included in the wall time.
+	*/
+	bool Run(const std::vector<std::string>& Files, const ProcessFunction& Process,
+		const ValidateFunction& Validate = ValidateFunction());
+
+	//! Statistics of the last Run(), the busy times of the stages overlap
+	size_t GetNumProcessed() const { return m_NumProcessed; }
+	double GetLoadMilliseconds() const { return m_LoadMs; }
+	double GetProcessMilliseconds() const { return m_ProcessMs; }
+	double GetSaveMilliseconds() const { return m_SaveMs; }
+	double GetWallMilliseconds() const { return m_WallMs; }
+	double GetValidateMilliseconds() const { return m_ValidateMs; }
+	size_t GetNumValidated() const { return m_NumValidated; }
+	size_t GetNumMismatches() const { return m_NumMismatches; }
+	//! True if images were validated and all of them matched
+	bool IsValid() const { return m_NumValidated > 0 && m_NumMismatches == 0; }
+
+protected:
+	size_t		m_QueueDepth;
+
+	size_t		m_NumProcessed = 0;
+	size_t		m_NumValidated = 0;
+	size_t		m_NumMismatches = 0;
+	double		m_LoadMs = 0.0;
+	double		m_ProcessMs = 0.0;
+	double		m_SaveMs = 0.0;
+	double		m_WallMs = 0.0;
+	double		m_ValidateMs = 0.0;
+};
+
+#endif // _CIMAGE_PIPELINE_H
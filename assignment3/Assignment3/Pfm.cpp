@@ -1,13 +1,102 @@
 
+
 #include "Pfm.h"
 #include <string.h>
 
 #include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4996) //fopen
 #endif
 
+//the header is "PF" or "Pf", width, height and scale separated by white space, followed by
+//exactly one white space character. PFM has no comments, so 256 bytes always hold the header.
+#define PFM_MAX_HEADER 256
+
+//rows handed to a single writev() call
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+namespace
+{
+	bool IsLittleEndianHost()
+	{
+		const uint16_t one = 1;
+		return *(const uint8_t*)&one == 1;
+	}
+
+	//maps the whole file copy-on-write, so the pixels can be modified in memory
+	void* MapFile(const char* file, size_t& size)
+	{
+#ifdef _WIN32
+		HANDLE f = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (f == INVALID_HANDLE_VALUE)
+			return NULL;
+		LARGE_INTEGER fileSize;
+		void* p = NULL;
+		if (GetFileSizeEx(f, &fileSize) && fileSize.QuadPart > 0) {
+			HANDLE mapping = CreateFileMappingA(f, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+			if (mapping) {
+				p = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+			size = size_t(fileSize.QuadPart);
+		}
+		CloseHandle(f);
+		return p;
+#else
+		int fd = open(file, O_RDONLY);
+		if (fd < 0)
+			return NULL;
+		struct stat st;
+		void* p = NULL;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			size = size_t(st.st_size);
+			p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED)
+				p = NULL;
+#ifdef MADV_SEQUENTIAL
+			else
+				madvise(p, size, MADV_SEQUENTIAL);
+#endif
+		}
+		close(fd);
+		return p;
+#endif
+	}
+
+	void UnmapFile(void* p, size_t size)
+	{
+#ifdef _WIN32
+		(void)size;
+		UnmapViewOfFile(p);
+#else
+		munmap(p, size);
+#endif
+	}
+
+	uint32_t Swap32(uint32_t v)
+	{
+		return (v << 24) | ((v << 8) & 0x00FF0000) | ((v >> 8) & 0x0000FF00) | (v >> 24);
+	}
+}
+
 //basic constructor
 PFM::PFM(){
     Reset();
@@ -23,52 +112,16 @@ PFM::~PFM(){
 //load a bitmap from a file and represent it correctly
 //in memory
 bool PFM::LoadRGB(const char *file) {
-
-	Release();
-
-	FILE *f = fopen( file, "rb" );
-
-	if ( !f )  {
-		fprintf( stderr, "PFM::Load: Error opening file '%s'\n", file );
-		return false;
-	}
-
-	char tmp[ 1024 ];
-	fscanf( f, "%s\n", tmp );
-	if ( strcmp( tmp, "PF" ) != 0 )
-		return false;
-
-	fscanf( f, "%d%d", &width, &height );
-	float sc;
-	fscanf( f, "%f", &sc );
-
-	pImg = new float[ width * height * 3];
-
-	fread( pImg, 1, 1, f);
-	fread( pImg, sizeof(float) * 3, width * height, f);
-
-	fclose( f );
-	return true;
+	return Load(file, 3);
 }
 
 bool PFM::SaveRGB(const char* file) {
 
-	FILE *f = fopen( file, "wb" );
-
-	if ( !f )  {
-		fprintf( stderr, "PFM::Save: Error opening file '%s'\n", file );
-		return false;
-	}
-
-	fprintf(f, "PF\n");
-	fprintf(f, "%d %d\n", width, height );
-	fprintf(f, "-1.0000000\n");
-
-	fwrite( pImg, sizeof( float ) * 3,  width * height, f );
-
-	fclose( f );
-	return true;
-
+	channels = 3;
+	vector<const float*> rows(height);
+	for (int y = 0; y < height; y++)
+		rows[y] = GetRow(y);
+	return Save(file, width, height, 3, rows.data());
 }
 
 
@@ -76,36 +129,101 @@ bool PFM::SaveRGB(const char* file) {
 //load a bitmap from a file and represent it correctly
 //in memory
 bool PFM::LoadGrayscale(const char *file) {
+	return Load(file, 1);
+}
 
-	Release();
+bool PFM::SaveGrayscale(const char* file) {
+
+	channels = 1;
+	vector<const float*> rows(height);
+	for (int y = 0; y < height; y++)
+		rows[y] = GetRow(y);
+	return Save(file, width, height, 1, rows.data());
+}
 
-	FILE *f = fopen( file, "rb" );
+bool PFM::Load(const char* file, int expectedChannels) {
 
-	if ( !f )  {
+	Release();
+
+	size_t size = 0;
+	char* data = (char*)MapFile(file, size);
+	if ( !data )  {
 		fprintf( stderr, "PFM::Load: Error opening file '%s'\n", file );
 		return false;
 	}
 
-	char tmp[ 1024 ];
-	fscanf( f, "%s\n", tmp );
-	if ( strcmp( tmp, "Pf" ) != 0 )
+	//parse a null-terminated copy of the header, the mapping has no terminator
+	char header[ PFM_MAX_HEADER + 1 ];
+	size_t headerSize = size < PFM_MAX_HEADER ? size : PFM_MAX_HEADER;
+	memcpy( header, data, headerSize );
+	header[ headerSize ] = '\0';
+
+	int fileChannels = 0;
+	if ( headerSize >= 2 && header[0] == 'P' && header[1] == 'F' )
+		fileChannels = 3;
+	else if ( headerSize >= 2 && header[0] == 'P' && header[1] == 'f' )
+		fileChannels = 1;
+
+	char* pos = header + 2;
+	char* end = NULL;
+	long w = strtol( pos, &end, 10 );
+	bool valid = fileChannels == expectedChannels && end != pos;
+	pos = end;
+	long h = strtol( pos, &end, 10 );
+	valid &= end != pos;
+	pos = end;
+	double scale = strtod( pos, &end );
+	valid &= end != pos && scale != 0.0 && isspace( (unsigned char)*end ) && w > 0 && h > 0;
+
+	//a single white space character separates the header from the pixels
+	size_t offset = size_t(end - header) + 1;
+	size_t payloadSize = size_t(w) * size_t(h) * fileChannels * sizeof(float);
+	if ( !valid || offset + payloadSize > size ) {
+		fprintf( stderr, "PFM::Load: '%s' is not a valid %s PFM file\n", file, expectedChannels == 3 ? "RGB" : "grayscale" );
+		UnmapFile( data, size );
 		return false;
+	}
 
-	fscanf( f, "%d%d", &width, &height );
-	float sc;
-	fscanf( f, "%f", &sc );
-
-	pImg = new float[ width * height];
-
-	fread( pImg, 1, 1, f);
-	fread( pImg, sizeof(float), width * height, f );
+	width = int(w);
+	height = int(h);
+	channels = fileChannels;
+
+	//a negative scale marks little endian data, a positive one big endian
+	bool swap = (scale < 0.0) != IsLittleEndianHost();
+	char* payload = data + offset;
+	if ( !swap && offset % sizeof(float) == 0 ) {
+		//zero-copy: the pixels stay in the mapped file
+		pMapping = data;
+		mappingSize = size;
+		pImg = (float*)payload;
+		return true;
+	}
 
-	fclose( f );
+	size_t count = size_t(width) * height * channels;
+	pImg = new float[ count ];
+	memcpy( pImg, payload, payloadSize );
+	if ( swap ) {
+		uint32_t* p = (uint32_t*)pImg;
+		for ( size_t i = 0; i < count; i++ )
+			p[i] = Swap32( p[i] );
+	}
+	UnmapFile( data, size );
 	return true;
 }
 
-bool PFM::SaveGrayscale(const char* file) {
+bool PFM::Save(const char* file, int width, int height, int channels, const float* const* rows) {
+
+	//the pixels are written in the byte order of the host, the sign of the scale tells which
+	char header[ PFM_MAX_HEADER ];
+	int headerSize = snprintf( header, sizeof(header), "%s\n%d %d\n%s", channels == 3 ? "PF" : "Pf",
+		width, height, IsLittleEndianHost() ? "-1.0" : "1.0" );
+	//pad the scale with zeros, so the payload starts 16 byte aligned and a later Load() maps it
+	while ( (headerSize + 1) % 16 != 0 )
+		header[ headerSize++ ] = '0';
+	header[ headerSize++ ] = '\n';
+	size_t rowSize = size_t(width) * channels * sizeof(float);
 
+#ifdef _WIN32
 	FILE *f = fopen( file, "wb" );
 
 	if ( !f )  {
@@ -113,15 +231,54 @@ bool PFM::SaveGrayscale(const char* file) {
 		return false;
 	}
 
-	fprintf(f, "Pf\n");
-	fprintf(f, "%d %d\n", width, height );
-	fprintf(f, "-1.00000\n");
+	//the file stores the bottom row first
+	bool ok = fwrite( header, 1, headerSize, f ) == size_t(headerSize);
+	for ( int y = height - 1; ok && y >= 0; y-- )
+		ok = fwrite( rows[y], 1, rowSize, f ) == rowSize;
 
-	fwrite( pImg, sizeof(float),  width * height, f );
+	ok &= fclose( f ) == 0;
+#else
+	int fd = open( file, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
 
-	fclose( f );
-	return true;
+	if ( fd < 0 )  {
+		fprintf( stderr, "PFM::Save: Error opening file '%s'\n", file );
+		return false;
+	}
+
+	//gather the header and the rows (bottom row first) straight from the callers memory
+	vector<struct iovec> iov;
+	iov.reserve( height + 1 );
+	struct iovec h = { header, size_t(headerSize) };
+	iov.push_back( h );
+	for ( int y = height - 1; y >= 0; y-- ) {
+		struct iovec r = { (void*)rows[y], rowSize };
+		iov.push_back( r );
+	}
+
+	bool ok = true;
+	for ( size_t i = 0; ok && i < iov.size(); ) {
+		int n = int( iov.size() - i < IOV_MAX ? iov.size() - i : IOV_MAX );
+		ssize_t written = writev( fd, &iov[i], n );
+		if ( written <= 0 ) {
+			ok = false;
+			break;
+		}
+		//continue after a partial write
+		size_t remaining = size_t(written);
+		while ( i < iov.size() && remaining >= iov[i].iov_len )
+			remaining -= iov[i++].iov_len;
+		if ( remaining > 0 ) {
+			iov[i].iov_base = (char*)iov[i].iov_base + remaining;
+			iov[i].iov_len -= remaining;
+		}
+	}
+
+	ok &= close( fd ) == 0;
+#endif
 
+	if ( !ok )
+		fprintf( stderr, "PFM::Save: Error writing file '%s'\n", file );
+	return ok;
 }
 
 
@@ -129,10 +286,16 @@ bool PFM::SaveGrayscale(const char* file) {
 void PFM::Reset(void) {
 	height = 0;
 	width  = 0;
+	channels = 0;
     pImg = NULL;
+	pMapping = NULL;
+	mappingSize = 0;
 }
 
 void PFM::Release(void){
-	if (pImg)
+	if (pMapping)
+		UnmapFile(pMapping, mappingSize);
+	else if (pImg)
 		delete [] pImg;
+	Reset();
 }
@@ -7,30 +7,60 @@
 using namespace std;
 
 
+//portable float map (PF: RGB, Pf: grayscale)
+//
+//the files are memory mapped: if the byte order of the file matches the host and the
+//payload is aligned, pImg points directly into the mapping (copy-on-write), otherwise the
+//pixels are copied (and byte swapped) into an own buffer. The rows are kept in the order
+//of the file, which stores the bottom row first, GetRow() counts from the top.
 class PFM {
 public:
 
 	//variables
 	int width;
 	int height;
+	//3 for RGB, 1 for grayscale
+	int channels;
+	//the pixels, bottom row first like in the file
 	float *pImg;
 
- 
+
 	//methods
     PFM(void);
     ~PFM();
     bool LoadRGB(const char *);
-	bool SaveRGB(const char*); 
+	bool SaveRGB(const char*);
     bool LoadGrayscale(const char *);
-	bool SaveGrayscale(const char*); 
+	bool SaveGrayscale(const char*);
+
+	//row y counted from the top of the image, width * channels floats
+	float* GetRow(int y) { return pImg + size_t(height - 1 - y) * width * channels; }
+	const float* GetRow(int y) const { return pImg + size_t(height - 1 - y) * width * channels; }
+
+	//true if pImg points into the mapped file
+	bool IsMapped() const { return pImg != NULL && pMapping != NULL; }
+
+	//writes an image without an intermediate copy, rows[y] is row y counted from the top
+	//and holds width * channels floats (the rows may be spread over several arrays)
+	static bool Save(const char* file, int width, int height, int channels, const float* const* rows);
 
 private:
 
+	//the image owns its pixels or the mapping, it cannot be copied
+	PFM(const PFM&);
+	PFM& operator=(const PFM&);
+
     //methods
     void Reset(void);
 	void Release(void);
+	bool Load(const char* file, int expectedChannels);
+
+	//the mapped file, NULL if pImg is an own allocation
+	void *pMapping;
+	size_t mappingSize;
 };
 
-#endif //_BITMAP_H
+#endif //PFM_H
+
 
 
@@ -1,3 +1,6 @@
+# Functions see the directory of their caller in CMAKE_CURRENT_LIST_DIR, so remember ours
+set(CHANGE_WORKINGDIR_MODULE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
 function(change_workingdir EXE WorkingDir)
 	#add a user file to auto config the working directory for debugging
 	if (MSVC)
@@ -7,7 +10,7 @@ function(change_workingdir EXE WorkingDir)
 		endif (CMAKE_CL_64)
 				
 		configure_file (
-			${CMAKE_SOURCE_DIR}/../cmake/WorkingDirectory.vcxproj.user.in
+			${CHANGE_WORKINGDIR_MODULE_DIR}/WorkingDirectory.vcxproj.user.in
 			${CMAKE_CURRENT_BINARY_DIR}/${EXE}.vcxproj.user 
 			@ONLY
 			)
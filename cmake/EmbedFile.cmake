@@ -0,0 +1,17 @@
+# Writes the contents of INPUT as a byte array named SYMBOL into the header OUTPUT
+# usage: cmake -DINPUT=<file> -DOUTPUT=<header> -DSYMBOL=<name> -P EmbedFile.cmake
+
+file(READ "${INPUT}" Hex HEX)
+# one byte per "0x.." entry, 16 entries per line (CMake regular expressions have no {n})
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," Bytes "${Hex}")
+set(Line "")
+foreach(i RANGE 1 16)
+	set(Line "${Line}0x[0-9a-f][0-9a-f],")
+endforeach()
+string(REGEX REPLACE "(${Line})" "\\1\n\t" Bytes "${Bytes}")
+
+get_filename_component(Name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+	"// Generated from ${Name} by cmake/EmbedFile.cmake, do not edit.\n"
+	"// The array is null-terminated, its size includes the terminator.\n\n"
+	"static const unsigned char ${SYMBOL}[] = {\n\t${Bytes}0x00\n};\n")
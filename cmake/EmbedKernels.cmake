@@ -0,0 +1,43 @@
+# Compiles OpenCL sources into an executable, so it does not depend on the working directory.
+# The headers are regenerated whenever a source changes; the sources are registered with
+# CLUtil under their file name, see CLUtil::LoadProgramSourceToMemory().
+#
+# usage: embed_kernels(<target> <file.cl> [<file.cl> ...])
+
+# Functions see the directory of their caller in CMAKE_CURRENT_LIST_DIR, so remember ours
+set(EMBED_KERNELS_MODULE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(embed_kernels TARGET)
+	set(OutDir ${CMAKE_CURRENT_BINARY_DIR}/EmbeddedKernels)
+	set(Headers)
+	set(Includes)
+	set(Registrations)
+
+	foreach(Source ${ARGN})
+		get_filename_component(Source ${Source} ABSOLUTE)
+		get_filename_component(Name ${Source} NAME)
+		string(MAKE_C_IDENTIFIER ${Name} Symbol)
+		set(Header ${OutDir}/${Name}.h)
+
+		add_custom_command(
+			OUTPUT ${Header}
+			COMMAND ${CMAKE_COMMAND} -DINPUT=${Source} -DOUTPUT=${Header} -DSYMBOL=g_${Symbol} -P ${EMBED_KERNELS_MODULE_DIR}/EmbedFile.cmake
+			DEPENDS ${Source} ${EMBED_KERNELS_MODULE_DIR}/EmbedFile.cmake
+			COMMENT "Embedding ${Name}"
+			VERBATIM
+			)
+
+		list(APPEND Headers ${Header})
+		set(Includes "${Includes}#include \"${Name}.h\"\n")
+		set(Registrations "${Registrations}static CLEmbeddedSource s_${Symbol}(\"${Name}\", g_${Symbol}, sizeof(g_${Symbol}) - 1);\n")
+	endforeach()
+
+	# only rewritten if the list of sources changes
+	set(Registry ${OutDir}/EmbeddedKernels.cpp)
+	file(GENERATE OUTPUT ${Registry} CONTENT
+		"// Generated by embed_kernels() (cmake/EmbedKernels.cmake), do not edit.\n\n#include \"CLUtil.h\"\n\n${Includes}\n${Registrations}")
+
+	target_sources(${TARGET} PRIVATE ${Registry} ${Headers})
+	target_include_directories(${TARGET} PRIVATE ${OutDir})
+	source_group("Embedded Kernels" FILES ${Registry} ${Headers})
+endfunction()